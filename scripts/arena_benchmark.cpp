@@ -0,0 +1,120 @@
+// Compares util::Arena with allocating every AST node with std::make_unique
+// and keeping it in a vector of owning pointers, as ASTContext did before.
+//
+// Compile with
+//   g++ -std=c++20 -O2 -I src scripts/arena_benchmark.cpp -o arena_benchmark
+//
+// USAGE:
+//   ./arena_benchmark unique_ptr|arena [per-node-location]
+//
+// Every round builds and destroys the nodes of a 10,000-probe script like
+// `interval:s:1 { @[$i] = count(); }`. The nodes are not the real AST nodes,
+// they only mimic their layout: a vtable, a state pointer, a location and a
+// payload of the size of the real node. By default all nodes share one
+// location, with per-node-location every node gets its own, as the parser
+// does.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+#include "util/arena.h"
+
+namespace {
+
+constexpr size_t PROBES = 10000;
+constexpr int ROUNDS = 50;
+
+struct Location {
+  std::string filename;
+  int line = 1;
+  int column = 1;
+};
+
+struct Node {
+  Node(std::shared_ptr<Location> loc) : loc(std::move(loc))
+  {
+  }
+  virtual ~Node() = default;
+
+  void *state = nullptr;
+  std::shared_ptr<Location> loc;
+};
+
+template <size_t N>
+struct SizedNode : Node {
+  using Node::Node;
+  void *payload[N] = {};
+};
+
+template <typename Make>
+void build_probe(Make &make, const std::shared_ptr<Location> &shared_loc)
+{
+  auto loc = [&] {
+    return shared_loc ? shared_loc : std::make_shared<Location>();
+  };
+  make.template operator()<SizedNode<6>>(loc());  // Probe
+  make.template operator()<SizedNode<12>>(loc()); // AttachPoint
+  make.template operator()<SizedNode<4>>(loc());  // Block
+  make.template operator()<SizedNode<3>>(loc());  // AssignMapStatement
+  make.template operator()<SizedNode<8>>(loc());  // Map
+  make.template operator()<SizedNode<8>>(loc());  // MapAccess
+  make.template operator()<SizedNode<6>>(loc());  // Variable
+  make.template operator()<SizedNode<8>>(loc());  // Call
+  make.template operator()<SizedNode<2>>(loc());  // Integer
+  make.template operator()<SizedNode<4>>(loc());  // ExprStatement
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  if (argc < 2 || (strcmp(argv[1], "unique_ptr") != 0 &&
+                   strcmp(argv[1], "arena") != 0)) {
+    fprintf(stderr,
+            "USAGE: %s unique_ptr|arena [per-node-location]\n",
+            argv[0]);
+    return 1;
+  }
+  bool use_arena = strcmp(argv[1], "arena") == 0;
+  std::shared_ptr<Location> shared_loc;
+  if (argc < 3)
+    shared_loc = std::make_shared<Location>();
+
+  auto start = std::chrono::steady_clock::now();
+  if (use_arena) {
+    bpftrace::util::Arena arena;
+    auto make = [&]<typename T>(std::shared_ptr<Location> loc) {
+      return arena.make<T>(std::move(loc));
+    };
+    for (int round = 0; round < ROUNDS; round++) {
+      for (size_t i = 0; i < PROBES; i++)
+        build_probe(make, shared_loc);
+      arena.clear();
+    }
+  } else {
+    for (int round = 0; round < ROUNDS; round++) {
+      std::vector<std::unique_ptr<Node>> nodes;
+      auto make = [&]<typename T>(std::shared_ptr<Location> loc) {
+        nodes.push_back(std::make_unique<T>(std::move(loc)));
+        return nodes.back().get();
+      };
+      for (size_t i = 0; i < PROBES; i++)
+        build_probe(make, shared_loc);
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("%s: %.2f ms per AST (build+destroy), peak RSS %ld KiB\n",
+         argv[1],
+         std::chrono::duration<double, std::milli>(end - start).count() /
+             ROUNDS,
+         usage.ru_maxrss);
+  return 0;
+}
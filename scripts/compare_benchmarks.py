@@ -0,0 +1,45 @@
+#!/usr/bin/env python3
+# Compares two reports of `bpftrace --test benchmark -f json`, e.g. of two
+# bpftrace builds for the same script from tests/benchmark. Prints the mean
+# time of every result in both reports and flags changes that are larger than
+# the confidence intervals of both.
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as report_file:
+        report = json.load(report_file)
+    if report["status"] != "PASS":
+        sys.exit(f"{path}: benchmark did not pass")
+    return {result["name"]: result for result in report["results"]}
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(f"USAGE: {sys.argv[0]} <old.json> <new.json>")
+    old = load(sys.argv[1])
+    new = load(sys.argv[2])
+
+    print(f"{'name':40} {'old':>14} {'new':>14} {'change':>8}")
+    for name, old_result in old.items():
+        new_result = new.get(name)
+        if new_result is None or "mean_ns" not in old_result:
+            continue
+        if "mean_ns" not in new_result:
+            continue
+        old_mean = old_result["mean_ns"]
+        new_mean = new_result["mean_ns"]
+        change = (new_mean - old_mean) / old_mean * 100 if old_mean else 0
+        significant = (
+            abs(new_mean - old_mean) > old_result["ci95_ns"] + new_result["ci95_ns"]
+        )
+        print(
+            f"{name:40} {old_mean:>14} {new_mean:>14} {change:>+7.1f}%"
+            + (" *" if significant else "")
+        )
+
+
+if __name__ == "__main__":
+    main()
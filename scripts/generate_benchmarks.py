@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+# Generates the startup benchmark scripts in tests/benchmark, which are run
+# with `bpftrace --test benchmark` and compared with compare_benchmarks.py.
+# Change the scripts here and regenerate them with
+#
+#   scripts/generate_benchmarks.py tests/benchmark
+
+import os
+import sys
+
+HEADER = "// Generated by scripts/generate_benchmarks.py, do not edit.\n"
+
+# Fields of the large structs cycle through these types.
+FIELD_TYPES = ["long", "int", "short", "char"]
+
+
+def many_probes():
+    out = "// Startup benchmark: many probes, each with its own program.\n"
+    out += "// One interval probe per line, all updating the same map.\n"
+    out += HEADER + "\n"
+    for i in range(500):
+        out += f"interval:s:{100 + i} {{ @hits[{i}] = count(); }}\n"
+    return out
+
+
+def many_maps():
+    out = "// Startup benchmark: many maps of different kinds, written by a few\n"
+    out += "// probes.\n"
+    out += HEADER
+    for probe in range(5):
+        out += f"\ninterval:s:{100 + probe} {{\n"
+        for i in range(probe * 20, (probe + 1) * 20):
+            out += f"  @count{i}[pid] = count();\n"
+            out += f"  @sum{i}[cpu] = sum(nsecs);\n"
+            out += f"  @hist{i} = hist(nsecs);\n"
+            out += f"  @lhist{i} = lhist(nsecs % 1000, 0, 1000, 10);\n"
+            out += f"  @avg{i}[comm] = avg(nsecs);\n"
+            out += f"  @scalar{i} = nsecs;\n"
+        out += "}\n"
+    return out
+
+
+def large_structs():
+    out = "// Startup benchmark: large structs, copied into map values and "
+    out += "tuples.\n"
+    out += HEADER
+    for i in range(4):
+        out += f"\nstruct large{i} {{\n"
+        for field in range(64):
+            out += f"  {FIELD_TYPES[field % 4]} f{field};\n"
+        out += "  char name[64];\n"
+        out += "};\n"
+    for i in range(4):
+        fields = ", ".join(f"$p->f{i + 8 * k}" for k in range(8))
+        out += f"\ninterval:s:{100 + i} {{\n"
+        out += f"  $p = (struct large{i} *)curtask;\n"
+        out += f"  @value{i}[$p->f0, $p->f1, $p->f2, $p->f3] = *$p;\n"
+        out += f"  @tuple{i} = ({fields}, $p->name);\n"
+        out += "}\n"
+    return out
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(f"USAGE: {sys.argv[0]} <output directory>")
+    scripts = {
+        "many_probes.bt": many_probes,
+        "many_maps.bt": many_maps,
+        "large_structs.bt": large_structs,
+    }
+    for name, generate in scripts.items():
+        with open(os.path.join(sys.argv[1], name), "w") as script_file:
+            script_file.write(generate())
+
+
+if __name__ == "__main__":
+    main()
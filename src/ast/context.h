@@ -5,6 +5,7 @@
 
 #include "ast/diagnostic.h"
 #include "ast/pass_manager.h"
+#include "util/arena.h"
 
 namespace bpftrace {
 
@@ -53,11 +54,7 @@ public:
   template <NodeType T, typename... Args>
   constexpr T *make_node(Args &&...args)
   {
-    auto uniq_ptr = std::make_unique<T>(*this,
-                                        wrap(std::forward<Args>(args))...);
-    auto *raw_ptr = uniq_ptr.get();
-    state_->nodes_.push_back(std::move(uniq_ptr));
-    return raw_ptr;
+    return state_->nodes_.make<T>(*this, wrap(std::forward<Args>(args))...);
   }
 
   template <NodeType T>
@@ -66,10 +63,7 @@ public:
     if (other == nullptr) {
       return nullptr;
     }
-    auto uniq_ptr = std::make_unique<T>(*this, *other, loc);
-    auto *raw_ptr = uniq_ptr.get();
-    state_->nodes_.push_back(std::move(uniq_ptr));
-    return raw_ptr;
+    return state_->nodes_.make<T>(*this, *other, loc);
   }
 
   unsigned int node_count()
@@ -101,7 +95,10 @@ private:
   class State {
   public:
     State();
-    std::vector<std::unique_ptr<Node>> nodes_;
+    // Scripts can expand to hundreds of thousands of nodes (macros, unroll,
+    // attach point expansion), so nodes are bump-allocated rather than
+    // allocated one by one.
+    util::Arena nodes_;
     std::unique_ptr<Diagnostics> diagnostics_;
   };
 
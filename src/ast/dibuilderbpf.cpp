@@ -315,7 +315,8 @@ DIType *DIBuilderBPF::GetType(const SizedType &stype, bool emit_codegen_types)
                             getOrCreateArray({}));
   }
 
-  if (stype.IsByteArray() || stype.IsRecordTy() || stype.IsStack()) {
+  if (stype.IsByteArray() || stype.IsRecordTy() || stype.IsStack() ||
+      stype.IsDistinctTy()) {
     auto *subrange = getOrCreateSubrange(0, stype.GetSize());
     return createArrayType(
         stype.GetSize() * 8, 0, getInt8Ty(), getOrCreateArray({ subrange }));
@@ -379,7 +380,7 @@ DIType *DIBuilderBPF::GetMapKeyType(const SizedType &key_type,
 
   // Some map types need an extra 8-byte key.
   if (value_type.IsHistTy() || value_type.IsLhistTy() ||
-      value_type.IsTSeriesTy()) {
+      value_type.IsTSeriesTy() || value_type.IsQuantilesTy()) {
     uint64_t size = key_type.GetSize() + 8;
     return CreateByteArrayType(size);
   }
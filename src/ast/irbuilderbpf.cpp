@@ -1,6 +1,8 @@
 #include <filesystem>
+#include <llvm/Analysis/ValueTracking.h>
 #include <llvm/IR/DataLayout.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Transforms/Utils/Local.h>
 
 #include "arch/arch.h"
 #include "ast/async_event_types.h"
@@ -368,7 +370,7 @@ llvm::Type *IRBuilderBPF::GetType(const SizedType &stype,
                                   bool emit_codegen_types)
 {
   llvm::Type *ty;
-  if (stype.IsByteArray() || stype.IsRecordTy()) {
+  if (stype.IsByteArray() || stype.IsRecordTy() || stype.IsDistinctTy()) {
     ty = ArrayType::get(getInt8Ty(), stype.GetSize());
   } else if (stype.IsArrayTy()) {
     ty = ArrayType::get(GetType(*stype.GetElementTy()), stype.GetNumElements());
@@ -555,13 +557,22 @@ CallInst *IRBuilderBPF::CreateGetStackScratchMap(StackType stack_type,
                                                  BasicBlock *failure_callback,
                                                  const Location &loc)
 {
-  SizedType value_type = CreateArray(stack_type.limit, CreateUInt64());
+  SizedType value_type = CreateArray(stack_type.value_words(),
+                                     CreateUInt64());
   return createGetScratchMap(StackType::scratch_name(),
                              StackType::scratch_name(),
                              loc,
                              failure_callback);
 }
 
+CallInst *IRBuilderBPF::CreateGetTopkSketchMap(const std::string &map_ident,
+                                               BasicBlock *failure_callback,
+                                               const Location &loc)
+{
+  return createGetScratchMap(
+      topk_sketch_map_name(map_ident), "topk_sketch", loc, failure_callback);
+}
+
 Value *IRBuilderBPF::CreateGetStrAllocation(const std::string &name,
                                             const Location &loc)
 {
@@ -1331,6 +1342,32 @@ void IRBuilderBPF::CreateCheckSetRecursion(const Location &loc,
   SetInsertPoint(merge_block);
 }
 
+void IRBuilderBPF::CreateCgroupFilter(uint64_t cgroup_id,
+                                      int level,
+                                      const Location &loc,
+                                      int early_exit_ret)
+{
+  // The ancestor at the level of the filter cgroup is that cgroup itself if
+  // the current task is in it or anywhere below it.
+  Value *ancestor = CreateGetCurrentAncestorCgroupId(level, loc);
+
+  llvm::Function *parent = GetInsertBlock()->getParent();
+  BasicBlock *reject_block = BasicBlock::Create(module_.getContext(),
+                                                "cgroup_reject",
+                                                parent);
+  BasicBlock *accept_block = BasicBlock::Create(module_.getContext(),
+                                                "cgroup_accept",
+                                                parent);
+  CreateCondBr(CreateICmpEQ(ancestor, getInt64(cgroup_id), "cgroup_cond"),
+               accept_block,
+               reject_block);
+
+  SetInsertPoint(reject_block);
+  CreateRet(getInt64(early_exit_ret));
+
+  SetInsertPoint(accept_block);
+}
+
 void IRBuilderBPF::CreateUnSetRecursion(const Location &loc)
 {
   const std::string map_ident = to_string(MapType::RecursionPrevention);
@@ -1617,6 +1654,9 @@ Value *IRBuilderBPF::CreateStrncmp(Value *str1,
   //
   //     return true;
   //  }
+  //
+  // If both strings are in aligned buffers, the loop is first done on 8 byte
+  // words, and only the remaining bytes are compared one by one.
 
   llvm::Function *parent = GetInsertBlock()->getParent();
   AllocaInst *store = CreateAllocaBPF(getInt1Ty(), "strcmp.result");
@@ -1629,8 +1669,51 @@ Value *IRBuilderBPF::CreateStrncmp(Value *str1,
 
   CreateStore(getInt1(!inverse), store);
 
+  size_t i = 0;
+  if (n >= 8 && canLoadWords(str1) && canLoadWords(str2)) {
+    Value *ones = getInt64(0x0101010101010101);
+    Value *highs = getInt64(0x8080808080808080);
+    for (; i + 8 <= n; i += 8) {
+      BasicBlock *word_eq = BasicBlock::Create(module_.getContext(),
+                                               "strcmp.word",
+                                               parent);
+      BasicBlock *word_null_check = BasicBlock::Create(module_.getContext(),
+                                                       "strcmp.word_null_cmp",
+                                                       parent);
+
+      auto *ptr_l = CreateGEP(getInt8Ty(), str1, { getInt32(i) });
+      Value *l = CreateAlignedLoad(getInt64Ty(), ptr_l, MaybeAlign(8));
+      auto *ptr_r = CreateGEP(getInt8Ty(), str2, { getInt32(i) });
+      Value *r = CreateAlignedLoad(getInt64Ty(), ptr_r, MaybeAlign(8));
+
+      // Has the high bit set in every NUL byte of l. Bytes above a NUL can
+      // also get it, but never bytes below one, so the lowest set bit marks
+      // the first NUL.
+      Value *nulls = CreateSub(l, ones);
+      nulls = CreateAnd(nulls, CreateNot(l));
+      nulls = CreateAnd(nulls, highs, "strcmp.nulls");
+      // Selects the bytes up to and including the first NUL, which come
+      // first in memory on little endian. All bytes if there is no NUL.
+      Value *first_null = CreateAnd(nulls, CreateNeg(nulls));
+      Value *mask = CreateShl(first_null, 1);
+      mask = CreateSub(mask, getInt64(1), "strcmp.mask");
+
+      Value *diff = CreateXor(l, r);
+      diff = CreateAnd(diff, mask);
+      Value *cmp = CreateICmpNE(diff, getInt64(0), "strcmp.cmp");
+      CreateCondBr(cmp, str_ne, word_null_check);
+
+      SetInsertPoint(word_null_check);
+
+      Value *cmp_null = CreateICmpNE(nulls, getInt64(0), "strcmp.cmp_null");
+      CreateCondBr(cmp_null, done, word_eq);
+
+      SetInsertPoint(word_eq);
+    }
+  }
+
   Value *null_byte = getInt8(0);
-  for (size_t i = 0; i < n; i++) {
+  for (; i < n; i++) {
     BasicBlock *char_eq = BasicBlock::Create(module_.getContext(),
                                              "strcmp.loop",
                                              parent);
@@ -1672,6 +1755,58 @@ Value *IRBuilderBPF::CreateStrncmp(Value *str1,
   return result;
 }
 
+// Whether ptr can be read in aligned 8 byte words. This is the case for
+// buffers on the stack or in a scratch map, whose alignment is raised if
+// needed. String literals are left alone, they are usually short.
+bool IRBuilderBPF::canLoadWords(Value *ptr)
+{
+  const DataLayout &layout = module_.getDataLayout();
+  if (!layout.isLittleEndian())
+    return false;
+
+  const Value *base = getUnderlyingObject(ptr);
+  const auto *global = dyn_cast<GlobalVariable>(base);
+  if (!isa<AllocaInst>(base) && !(global && global->hasSection()))
+    return false;
+  return getOrEnforceKnownAlignment(ptr, MaybeAlign(8), layout) >= Align(8);
+}
+
+Value *IRBuilderBPF::CreateStrncmpLiteral(Value *str,
+                                          const std::string &literal,
+                                          uint64_t n,
+                                          bool inverse,
+                                          const Location &loc)
+{
+  // The verifier only accepts a NUL terminated string from a frozen,
+  // read-only map, which is what libbpf makes of .rodata.
+  std::string name = "__bt__strncmp." + literal;
+  GlobalVariable *ro_literal = module_.getNamedGlobal(name);
+  if (!ro_literal) {
+    auto *init = ConstantDataArray::getString(module_.getContext(), literal);
+    ro_literal = new GlobalVariable(module_,
+                                    init->getType(),
+                                    true,
+                                    GlobalValue::PrivateLinkage,
+                                    init,
+                                    name);
+    ro_literal->setSection(".rodata");
+  }
+
+  // long bpf_strncmp(const char *s1, u32 s1_sz, const char *s2)
+  // Return: 0 if the strings are equal, like strncmp(s1, s2, s1_sz)
+  FunctionType *strncmp_func_type = FunctionType::get(
+      getInt64Ty(), { str->getType(), getInt32Ty(), getPtrTy() }, false);
+  CallInst *call = CreateHelperCall(libbpf::BPF_FUNC_strncmp,
+                                    strncmp_func_type,
+                                    { str, getInt32(n), ro_literal },
+                                    false,
+                                    "strncmp",
+                                    loc);
+  Value *cmp = inverse ? CreateICmpEQ(call, getInt64(0), "strcmp.eq")
+                       : CreateICmpNE(call, getInt64(0), "strcmp.ne");
+  return CreateIntCast(cmp, getInt64Ty(), false);
+}
+
 Value *IRBuilderBPF::CreateStrcontains(Value *haystack,
                                        uint64_t haystack_sz,
                                        Value *needle,
@@ -2041,6 +2176,23 @@ CallInst *IRBuilderBPF::CreateGetCurrentCgroupId(const Location &loc)
                           loc);
 }
 
+CallInst *IRBuilderBPF::CreateGetCurrentAncestorCgroupId(int level,
+                                                         const Location &loc)
+{
+  // u64 bpf_get_current_ancestor_cgroup_id(int ancestor_level)
+  // Return: 64-bit cgroup-v2 id of the ancestor at ancestor_level, 0 if the
+  //         current cgroup is above that level
+  FunctionType *getancestor_func_type = FunctionType::get(getInt64Ty(),
+                                                          { getInt32Ty() },
+                                                          false);
+  return CreateHelperCall(libbpf::BPF_FUNC_get_current_ancestor_cgroup_id,
+                          getancestor_func_type,
+                          { getInt32(level) },
+                          true,
+                          "get_ancestor_cgroup_id",
+                          loc);
+}
+
 CallInst *IRBuilderBPF::CreateGetUidGid(const Location &loc)
 {
   // u64 bpf_get_current_uid_gid(void)
@@ -2113,10 +2265,16 @@ CallInst *IRBuilderBPF::CreateGetStack(Value *ctx,
                                        const Location &loc)
 {
   int flags = 0;
+  size_t frame_size = sizeof(uint64_t);
   if (ustack)
     flags |= (1 << 8);
+  if (stack_type.has_build_id_frames()) {
+    // BPF_F_USER_BUILD_ID: frames are struct bpf_stack_build_id
+    flags |= (1 << 11);
+    frame_size = 4 * sizeof(uint64_t);
+  }
   Value *flags_val = getInt64(flags);
-  Value *stack_size = getInt32(stack_type.limit * sizeof(uint64_t));
+  Value *stack_size = getInt32(stack_type.limit * frame_size);
 
   // long bpf_get_stack(void *ctx, void *buf, u32 size, u64 flags)
   // Return: The non-negative copied *buf* length equal to or less than
@@ -2225,13 +2383,19 @@ CallInst *IRBuilderBPF::CreateGetSocketCookie(Value *var, const Location &loc)
 }
 
 void IRBuilderBPF::CreateOutput(Value *data, size_t size, const Location &loc)
+{
+  CreateOutput(data, getInt64(size), loc);
+}
+
+void IRBuilderBPF::CreateOutput(Value *data, Value *size, const Location &loc)
 {
   assert(data && data->getType()->isPointerTy());
+  assert(size && size->getType()->isIntegerTy(64));
   CreateRingbufOutput(data, size, loc);
 }
 
 void IRBuilderBPF::CreateRingbufOutput(Value *data,
-                                       size_t size,
+                                       Value *size,
                                        const Location &loc)
 {
   Value *map_ptr = GetMapVar(to_string(MapType::Ringbuf));
@@ -2244,7 +2408,7 @@ void IRBuilderBPF::CreateRingbufOutput(Value *data,
 
   Value *ret = CreateHelperCall(libbpf::BPF_FUNC_ringbuf_output,
                                 ringbuf_output_func_type,
-                                { map_ptr, data, getInt64(size), getInt64(0) },
+                                { map_ptr, data, size, getInt64(0) },
                                 false,
                                 "ringbuf_output",
                                 loc);
@@ -110,6 +110,13 @@ public:
                                 AddrSpace as,
                                 const Location &loc);
   Value *CreateStrncmp(Value *str1, Value *str2, uint64_t n, bool inverse);
+  // Same as CreateStrncmp, for a string literal as the second operand. Uses
+  // bpf_strncmp, which requires the literal to be in read-only memory.
+  Value *CreateStrncmpLiteral(Value *str,
+                              const std::string &literal,
+                              uint64_t n,
+                              bool inverse,
+                              const Location &loc);
   Value *CreateStrcontains(Value *haystack,
                            uint64_t haystack_sz,
                            Value *needle,
@@ -124,6 +131,7 @@ public:
   CallInst *CreateGetNs(TimestampMode ts, const Location &loc);
   CallInst *CreateJiffies64(const Location &loc);
   CallInst *CreateGetCurrentCgroupId(const Location &loc);
+  CallInst *CreateGetCurrentAncestorCgroupId(int level, const Location &loc);
   CallInst *CreateGetUidGid(const Location &loc);
   CallInst *CreateGetNumaId(const Location &loc);
   CallInst *CreateGetCpuId(const Location &loc);
@@ -142,6 +150,9 @@ public:
   CallInst *CreateGetStackScratchMap(StackType stack_type,
                                      BasicBlock *failure_callback,
                                      const Location &loc);
+  CallInst *CreateGetTopkSketchMap(const std::string &map_ident,
+                                   BasicBlock *failure_callback,
+                                   const Location &loc);
   Value *CreateGetStrAllocation(const std::string &name, const Location &loc);
   Value *CreateGetFmtStringArgsAllocation(StructType *struct_type,
                                           const std::string &name,
@@ -159,6 +170,10 @@ public:
                                 const std::string &name,
                                 const Location &loc);
   void CreateCheckSetRecursion(const Location &loc, int early_exit_ret);
+  void CreateCgroupFilter(uint64_t cgroup_id,
+                          int level,
+                          const Location &loc,
+                          int early_exit_ret);
   void CreateUnSetRecursion(const Location &loc);
   CallInst *CreateHelperCall(libbpf::bpf_func_id func_id,
                              FunctionType *helper_type,
@@ -172,6 +187,9 @@ public:
                        const Twine &Name);
   void CreateGetCurrentComm(AllocaInst *buf, size_t size, const Location &loc);
   void CreateOutput(Value *data, size_t size, const Location &loc);
+  // Outputs the first `size` bytes of data, for events whose size is only
+  // known at runtime. The verifier must be able to bound `size`.
+  void CreateOutput(Value *data, Value *size, const Location &loc);
   void CreateIncEventLossCounter(const Location &loc);
   void CreatePerCpuMapElemInit(Map &map,
                                Value *key,
@@ -312,9 +330,11 @@ private:
                              size_t key);
   libbpf::bpf_func_id selectProbeReadHelper(AddrSpace as, bool str);
 
+  bool canLoadWords(Value *ptr);
+
   llvm::Type *getKernelPointerStorageTy();
   llvm::Type *getUserPointerStorageTy();
-  void CreateRingbufOutput(Value *data, size_t size, const Location &loc);
+  void CreateRingbufOutput(Value *data, Value *size, const Location &loc);
 
   void createPerCpuSum(AllocaInst *ret, CallInst *call, const SizedType &type);
   void createPerCpuMinMax(AllocaInst *ret,
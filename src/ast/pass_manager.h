@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "util/result.h"
+#include "util/timing.h"
 #include "util/type_name.h"
 
 namespace bpftrace::ast {
@@ -343,6 +344,7 @@ public:
       // without the need for explicit error plumbing.
       if (!ctx.ok())
         return OK();
+      util::TimingSpan span("pass", pass.name());
       return pass.run(ctx);
     });
     if (!err) {
@@ -3,13 +3,18 @@
 #include <clang/Driver/Driver.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <llvm/Config/llvm-config.h>
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/VirtualFileSystem.h>
 #include <regex>
 #include <sstream>
+#include <sys/stat.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -23,9 +28,13 @@
 #include "log.h"
 #include "stdlib/stdlib.h"
 #include "types.h"
+#include "util/cache.h"
+#include "util/hash.h"
 #include "util/io.h"
+#include "util/paths.h"
 #include "util/strings.h"
 #include "util/system.h"
+#include "util/timing.h"
 
 namespace bpftrace::ast {
 
@@ -77,6 +86,10 @@ private:
   std::string get_arch_include_path();
   std::vector<std::string> system_include_paths();
 
+  // Path under which the parsed translation unit for the current args and
+  // input files is cached, or nullopt if caching is disabled.
+  std::optional<std::filesystem::path> get_cache_path(BPFtrace &bpftrace);
+
   std::string input;
   std::vector<const char *> args;
   std::vector<CXUnsavedFile> input_files;
@@ -114,6 +127,14 @@ private:
     bool has_redefinition_error();
     bool has_unknown_type_error();
 
+    // Load a translation unit previously stored with save(). Fails if there
+    // is none or if any of the headers it includes changed since.
+    bool load(const std::filesystem::path &path);
+    void save(const std::filesystem::path &path);
+
+    // Parse translation units so that they can be saved.
+    bool for_serialization = false;
+
   private:
     CXIndex index;
     CXTranslationUnit translation_unit = nullptr;
@@ -319,6 +340,8 @@ CXErrorCode ClangParser::ClangParserHandler::parse_translation_unit(
   // Clean up previous translation unit to prevent resource leak
   clang_disposeTranslationUnit(translation_unit);
 
+  util::TimingSpan span("clang", source_filename);
+
   return clang_parseTranslationUnit2(index,
                                      source_filename,
                                      command_line_args,
@@ -368,7 +391,8 @@ bool ClangParser::ClangParserHandler::parse_file(
       args.size(),
       unsaved_files.data(),
       unsaved_files.size(),
-      CXTranslationUnit_DetailedPreprocessingRecord);
+      CXTranslationUnit_DetailedPreprocessingRecord |
+          (for_serialization ? CXTranslationUnit_ForSerialization : 0));
 
   error_msgs.clear();
   if (error) {
@@ -400,6 +424,113 @@ bool ClangParser::ClangParserHandler::has_unknown_type_error()
 }
 
 namespace {
+// Translation units with kernel headers take tens of megabytes, this keeps
+// the ones for a handful of kernels and scripts.
+constexpr uint64_t MAX_CACHE_SIZE = 256 << 20;
+
+static std::filesystem::path get_deps_path(const std::filesystem::path &path)
+{
+  auto deps_path = path;
+  deps_path.replace_extension(".deps");
+  return deps_path;
+}
+
+bool ClangParser::ClangParserHandler::load(const std::filesystem::path &path)
+{
+  // Only files we own are loaded, and they are read through the descriptors
+  // that passed the check, so they cannot be swapped for others in between.
+  int deps_fd = util::open_cache_file(get_deps_path(path));
+  if (deps_fd < 0)
+    return false;
+  std::string deps_str;
+  char buf[4096];
+  ssize_t len;
+  while ((len = ::read(deps_fd, buf, sizeof(buf))) > 0)
+    deps_str.append(buf, len);
+  close(deps_fd);
+  if (len < 0)
+    return false;
+
+  // The cache key only covers the in-memory files, headers included from
+  // disk are validated by their modification times.
+  std::istringstream deps(deps_str);
+  for (std::string line; std::getline(deps, line);) {
+    auto sep = line.find(' ');
+    if (sep == std::string::npos)
+      return false;
+    auto file = line.substr(sep + 1);
+    struct stat st;
+    if (::stat(file.c_str(), &st) != 0 ||
+        std::to_string(st.st_mtime) != line.substr(0, sep))
+      return false;
+  }
+
+  int fd = util::open_cache_file(path);
+  if (fd < 0)
+    return false;
+  clang_disposeTranslationUnit(translation_unit);
+  translation_unit = nullptr;
+  // libclang only takes a path. /proc/self/fd refers to the file we opened,
+  // even if the path has been replaced since.
+  auto fd_path = "/proc/self/fd/" + std::to_string(fd);
+  bool loaded = clang_createTranslationUnit2(index,
+                                             fd_path.c_str(),
+                                             &translation_unit) ==
+                CXError_Success;
+  close(fd);
+  return loaded;
+}
+
+void ClangParser::ClangParserHandler::save(const std::filesystem::path &path)
+{
+  std::ostringstream deps;
+  clang_getInclusions(
+      translation_unit,
+      [](CXFile file, CXSourceLocation *, unsigned, CXClientData data) {
+        auto name = get_clang_string(clang_getFileName(file));
+        // In-memory files are part of the cache key.
+        if (name == "definitions.h" || name.starts_with("/bpftrace/"))
+          return;
+        *static_cast<std::ostringstream *>(data)
+            << clang_getFileTime(file) << " " << name << "\n";
+      },
+      &deps);
+
+  // Write to temporary files and rename them so that concurrent runs never
+  // see partial files.
+  std::error_code ec;
+  auto suffix = ".tmp" + std::to_string(getpid());
+  auto deps_path = get_deps_path(path);
+  auto tmp_deps_path = deps_path.string() + suffix;
+  auto tmp_path = path.string() + suffix;
+  {
+    std::ofstream out(tmp_deps_path);
+    out << deps.str();
+    if (!out) {
+      std::filesystem::remove(tmp_deps_path, ec);
+      return;
+    }
+  }
+  if (clang_saveTranslationUnit(translation_unit,
+                                tmp_path.c_str(),
+                                CXSaveTranslationUnit_None) !=
+      CXSaveError_None) {
+    std::filesystem::remove(tmp_deps_path, ec);
+    std::filesystem::remove(tmp_path, ec);
+    return;
+  }
+  std::filesystem::rename(tmp_deps_path, deps_path, ec);
+  if (!ec)
+    std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_deps_path, ec);
+    std::filesystem::remove(tmp_path, ec);
+    return;
+  }
+
+  util::trim_cache_dir(path.parent_path(), MAX_CACHE_SIZE);
+}
+
 using visitFn = std::function<CXChildVisitResult(CXCursor, CXCursor)>;
 int visitChildren(CXCursor cursor, visitFn fn)
 {
@@ -640,6 +771,11 @@ bool ClangParser::parse(ast::Program *program,
                         BPFtrace &bpftrace,
                         std::vector<std::string> extra_flags)
 {
+  // Tracepoint records are normally built without clang, so there is often
+  // nothing to parse at all. Don't pay for starting up libclang then.
+  if (program->c_definitions.empty() && bpftrace.btf_set_.empty())
+    return true;
+
   input = "#include </bpftrace/include/__btf_generated_header.h>\n" +
           program->c_definitions;
 
@@ -670,8 +806,18 @@ bool ClangParser::parse(ast::Program *program,
                                ? get_btf_generated_header(bpftrace)
                                : get_empty_btf_generated_header());
 
-  bool btf_conflict = false;
+  // Parsing kernel headers takes seconds, reuse the translation unit from a
+  // previous run with the same inputs if there is one.
+  auto cache_path = get_cache_path(bpftrace);
   ClangParserHandler handler;
+  if (cache_path && handler.load(*cache_path)) {
+    LOG(V1) << "Loaded C definitions from " << *cache_path;
+    CXCursor cursor = handler.get_translation_unit_cursor();
+    return visit_children(cursor, bpftrace);
+  }
+  handler.for_serialization = cache_path.has_value();
+
+  bool btf_conflict = false;
   if (bpftrace.has_btf_data()) {
     // We set these args early because some systems may not have
     // <linux/types.h> (containers) and fully rely on BTF.
@@ -730,6 +876,9 @@ bool ClangParser::parse(ast::Program *program,
     return false;
   }
 
+  if (cache_path)
+    handler.save(*cache_path);
+
   CXCursor cursor = handler.get_translation_unit_cursor();
   return visit_children(cursor, bpftrace);
 }
@@ -794,6 +943,38 @@ void ClangParser::resolve_unknown_typedefs_from_btf(BPFtrace &bpftrace)
   }
 }
 
+std::optional<std::filesystem::path> ClangParser::get_cache_path(
+    BPFtrace &bpftrace)
+{
+  auto cache_dir = util::get_cache_subdir("clang");
+  if (!cache_dir)
+    return std::nullopt;
+
+  // The translation unit depends on the clang version, the kernel (through
+  // the BTF definitions and the arch include path), the args and the
+  // contents of all the in-memory files.
+  uint64_t key = util::fnv1a_64(get_clang_string(clang_getClangVersion()));
+  struct utsname utsname;
+  if (uname(&utsname) == 0) {
+    key = util::fnv1a_64(utsname.release, key);
+    key = util::fnv1a_64(utsname.version, key);
+  }
+  key = util::fnv1a_64(bpftrace.has_btf_data() ? "btf" : "no btf", key);
+  for (const auto *arg : args) {
+    // Include the terminating NUL so that args can't run into each other.
+    key = util::fnv1a_64(std::string_view(arg, std::strlen(arg) + 1), key);
+  }
+  for (const auto &file : input_files) {
+    key = util::fnv1a_64(
+        std::string_view(file.Filename, std::strlen(file.Filename) + 1), key);
+    key = util::fnv1a_64(std::string_view(file.Contents, file.Length), key);
+  }
+
+  std::ostringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << key << ".ast";
+  return *cache_dir / name.str();
+}
+
 CXUnsavedFile ClangParser::get_btf_generated_header(BPFtrace &bpftrace)
 {
   // Note that `c_def` will provide the full set of types if an empty set is
@@ -67,6 +67,7 @@
 #include "util/cgroup.h"
 #include "util/cpus.h"
 #include "util/exceptions.h"
+#include "util/sketch.h"
 
 namespace bpftrace::ast {
 
@@ -265,6 +266,11 @@ private:
                               const CallArgs &call_args,
                               const std::string &call_name,
                               async_action::AsyncAction async_action);
+  // Writes a packed format string argument to dst and returns its size
+  Value *createPackedFormatArg(Value *dst,
+                               const SizedType &type,
+                               Value *src,
+                               const Location &loc);
 
   void createPrintMapCall(Call &call);
   void createPrintNonMapCall(Call &call, int id);
@@ -319,10 +325,21 @@ private:
 
   llvm::Function *createLog2Function();
   llvm::Function *createLinearFunction();
+  llvm::Function *createHelperFunction(const std::string &name,
+                                       FunctionType *func_type,
+                                       const Struct &debug_args);
+  CallInst *createHelperCall(llvm::Function *func,
+                             ArrayRef<Value *> args,
+                             const Twine &name);
   MDNode *createLoopMetadata();
 
   std::pair<ScopedExpr, uint64_t> getString(Expression &expr);
 
+  ScopedExpr compare_strings(Expression &left,
+                             Expression &right,
+                             uint64_t n,
+                             bool inverse,
+                             const Location &loc);
   ScopedExpr binop_string(Binop &binop);
   ScopedExpr binop_integer_array(Binop &binop);
   ScopedExpr binop_buf(Binop &binop);
@@ -405,7 +422,8 @@ private:
   llvm::Function *createForEachMapCallback(const For &f,
                                            const Map &map,
                                            llvm::Type *ctx_t);
-  llvm::Function *createMurmurHash2Func();
+  llvm::Function *createMurmurHash2Func(bool build_id_frames);
+  Value *createKeyHash(Value *data, size_t size);
 
   Value *createFmtString(int print_id);
 
@@ -463,6 +481,7 @@ private:
   llvm::Function *linear_func_ = nullptr;
   llvm::Function *log2_func_ = nullptr;
   llvm::Function *murmur_hash_2_func_ = nullptr;
+  llvm::Function *murmur_hash_2_build_id_func_ = nullptr;
   llvm::Function *map_len_func_ = nullptr;
   MDNode *loop_metadata_ = nullptr;
 
@@ -569,11 +588,17 @@ ScopedExpr CodegenLLVM::kstack_ustack(const std::string &ident,
                                       StackType stack_type,
                                       const Location &loc)
 {
-  if (!murmur_hash_2_func_)
-    murmur_hash_2_func_ = createMurmurHash2Func();
-
   const bool is_ustack = ident == "ustack";
   const auto uint64_size = sizeof(uint64_t);
+  // User stacks in build_id mode are made of struct bpf_stack_build_id.
+  const bool build_id_frames = stack_type.has_build_id_frames();
+  const auto frame_size = build_id_frames ? 4 * uint64_size : uint64_size;
+
+  llvm::Function *&murmur_hash_2_func = build_id_frames
+                                            ? murmur_hash_2_build_id_func_
+                                            : murmur_hash_2_func_;
+  if (!murmur_hash_2_func)
+    murmur_hash_2_func = createMurmurHash2Func(build_id_frames);
 
   StructType *stack_key_struct = b_.GetStackStructType(is_ustack);
   AllocaInst *stack_key = b_.CreateAllocaBPF(stack_key_struct, "stack_key");
@@ -593,7 +618,7 @@ ScopedExpr CodegenLLVM::kstack_ustack(const std::string &ident,
                                                    loc);
   b_.CreateMemsetBPF(stack_trace,
                      b_.getInt8(0),
-                     uint64_size * stack_type.limit);
+                     uint64_size * stack_type.value_words());
 
   BasicBlock *get_stack_success = BasicBlock::Create(module_->getContext(),
                                                      "get_stack_success",
@@ -614,7 +639,7 @@ ScopedExpr CodegenLLVM::kstack_ustack(const std::string &ident,
   b_.CreateBr(merge_block);
   b_.SetInsertPoint(get_stack_success);
 
-  Value *num_frames = b_.CreateUDiv(stack_size, b_.getInt64(uint64_size));
+  Value *num_frames = b_.CreateUDiv(stack_size, b_.getInt64(frame_size));
   b_.CreateStore(num_frames,
                  b_.CreateGEP(stack_key_struct,
                               stack_key,
@@ -634,7 +659,7 @@ ScopedExpr CodegenLLVM::kstack_ustack(const std::string &ident,
   // collisions.
   // More details here: https://github.com/bpftrace/bpftrace/issues/2962
   Value *murmur_hash_2 = b_.CreateCall(
-      murmur_hash_2_func_,
+      murmur_hash_2_func,
       { stack_trace, trunc_nr_stack_frames, seed },
       "murmur_hash_2");
 
@@ -1070,7 +1095,37 @@ ScopedExpr CodegenLLVM::visit(Call &call)
     Value *expr = b_.CreateIntCast(scoped_arg.value(),
                                    b_.getInt64Ty(),
                                    call.vargs.at(2).type().IsSigned());
-    Value *log2 = b_.CreateCall(log2_func_, { expr, k }, "log2");
+    Value *log2 = createHelperCall(log2_func_, { expr, k }, "log2");
+    ScopedExpr scoped_key = getMultiMapKey(
+        map, call.vargs.at(1), { log2 }, call.loc);
+    b_.CreatePerCpuMapElemAdd(
+        map, scoped_key.value(), b_.getInt64(1), call.loc);
+
+    return ScopedExpr();
+
+  } else if (call.func == "quantiles") {
+    // quantiles is a hist with a fixed, fine-grained number of buckets per
+    // power of 2. The quantiles themselves are computed in userspace.
+    if (!log2_func_)
+      log2_func_ = createLog2Function();
+
+    Map &map = *call.vargs.at(0).as<Map>();
+    auto &arg = call.vargs.at(2);
+    ScopedExpr scoped_arg = visit(arg);
+
+    // promote int to 64-bit
+    Value *expr = b_.CreateIntCast(scoped_arg.value(),
+                                   b_.getInt64Ty(),
+                                   arg.type().IsSigned());
+    if (arg.type().IsSigned()) {
+      // Negative values are counted as 0
+      expr = b_.CreateSelect(b_.CreateICmpSLT(expr, b_.getInt64(0)),
+                             b_.getInt64(0),
+                             expr);
+    }
+    Value *log2 = createHelperCall(log2_func_,
+                                   { expr, b_.getInt64(util::QUANTILES_BITS) },
+                                   "log2");
     ScopedExpr scoped_key = getMultiMapKey(
         map, call.vargs.at(1), { log2 }, call.loc);
     b_.CreatePerCpuMapElemAdd(
@@ -1108,9 +1163,9 @@ ScopedExpr CodegenLLVM::visit(Call &call)
                                    b_.getInt64Ty(),
                                    false);
 
-    Value *linear = b_.CreateCall(linear_func_,
-                                  { value, min, max, step },
-                                  "linear");
+    Value *linear = createHelperCall(linear_func_,
+                                     { value, min, max, step },
+                                     "linear");
 
     ScopedExpr scoped_key = getMultiMapKey(
         map, call.vargs.at(1), { linear }, call.loc);
@@ -1354,6 +1409,170 @@ ScopedExpr CodegenLLVM::visit(Call &call)
     b_.CreateLifetimeEnd(ts_struct_ptr);
     b_.CreateLifetimeEnd(key_exists);
 
+    return ScopedExpr();
+  } else if (call.func == "topk") {
+    // topk counts keys in a count-min sketch and remembers the keys it has
+    // seen as candidates in the map itself (an LRU hash keyed by the user key
+    // holding the key hash). The heavy hitters are picked in userspace.
+    //
+    // void topk(key) {
+    //   hash = key_hash(key);
+    //   sketch = bpf_map_lookup_elem(&sketch_map, 0);
+    //   for (row = 0; row < ROWS; row++)
+    //     sketch[row][((u32)hash + row * (hash >> 32)) % COLS]++;
+    //   if (!bpf_map_lookup_elem(&map, &key))
+    //     bpf_map_update_elem(&map, &key, &hash, BPF_ANY);
+    // }
+    Map &map = *call.vargs.at(0).as<Map>();
+    ScopedExpr scoped_key = getMapKey(map, call.vargs.at(1));
+    Value *hash = createKeyHash(scoped_key.value(), map.key_type.GetSize());
+
+    Value *sketch = b_.CreateGetTopkSketchMap(map.ident, nullptr, call.loc);
+    Value *hash_lo = b_.CreateAnd(hash, b_.getInt64(0xffffffff));
+    Value *hash_hi = b_.CreateLShr(hash, b_.getInt64(32));
+    for (uint32_t row = 0; row < util::TOPK_SKETCH_ROWS; row++) {
+      Value *col = b_.CreateAnd(
+          b_.CreateAdd(hash_lo, b_.CreateMul(hash_hi, b_.getInt64(row))),
+          b_.getInt64(util::TOPK_SKETCH_COLS - 1));
+      Value *idx = b_.CreateAdd(col,
+                                b_.getInt64(row * util::TOPK_SKETCH_COLS));
+      Value *counter = b_.CreateGEP(b_.getInt32Ty(), sketch, idx);
+      b_.CreateStore(b_.CreateAdd(b_.CreateLoad(b_.getInt32Ty(), counter),
+                                  b_.getInt32(1)),
+                     counter);
+    }
+
+    CallInst *lookup = b_.CreateMapLookup(map, scoped_key.value());
+    llvm::Function *parent = b_.GetInsertBlock()->getParent();
+    BasicBlock *lookup_failure_block = BasicBlock::Create(module_->getContext(),
+                                                          "lookup_failure",
+                                                          parent);
+    BasicBlock *lookup_merge_block = BasicBlock::Create(module_->getContext(),
+                                                        "lookup_merge",
+                                                        parent);
+    Value *lookup_condition = b_.CreateICmpNE(
+        b_.CreateIntCast(lookup, b_.getPtrTy(), true),
+        b_.GetNull(),
+        "lookup_cond");
+    b_.CreateCondBr(lookup_condition, lookup_merge_block, lookup_failure_block);
+
+    b_.SetInsertPoint(lookup_failure_block);
+    AllocaInst *hash_val = b_.CreateAllocaBPF(b_.getInt64Ty(), "topk_hash");
+    b_.CreateStore(hash, hash_val);
+    b_.CreateMapUpdateElem(map.ident, scoped_key.value(), hash_val, call.loc);
+    b_.CreateLifetimeEnd(hash_val);
+    b_.CreateBr(lookup_merge_block);
+
+    b_.SetInsertPoint(lookup_merge_block);
+    return ScopedExpr();
+  } else if (call.func == "distinct") {
+    // distinct keeps HyperLogLog registers in a per-CPU map value. The top
+    // bits of the value hash pick a register, which remembers the longest run
+    // of leading zeros seen in the remaining bits.
+    //
+    // void distinct(key, value) {
+    //   hash = key_hash(value);
+    //   regs = bpf_map_lookup_elem(&map, &key);
+    //   if (!regs) {
+    //     bpf_map_update_elem(&map, &key, &zero, BPF_ANY);
+    //     regs = bpf_map_lookup_elem(&map, &key);
+    //     if (!regs)
+    //       return;
+    //   }
+    //   rho = min(clz(hash << P) + 1, 64 - P + 1);
+    //   regs[hash >> (64 - P)] = max(regs[hash >> (64 - P)], rho);
+    // }
+    Map &map = *call.vargs.at(0).as<Map>();
+    ScopedExpr scoped_key = getMapKey(map, call.vargs.at(1));
+    auto &arg = call.vargs.at(2);
+    ScopedExpr scoped_arg = visit(arg);
+
+    Value *hash;
+    if (shouldBeInBpfMemoryAlready(arg.type())) {
+      hash = createKeyHash(scoped_arg.value(), arg.type().GetSize());
+    } else {
+      AllocaInst *arg_val = b_.CreateAllocaBPF(b_.getInt64Ty(),
+                                               "distinct_val");
+      b_.CreateStore(b_.CreateIntCast(scoped_arg.value(),
+                                      b_.getInt64Ty(),
+                                      arg.type().IsSigned()),
+                     arg_val);
+      hash = createKeyHash(arg_val, sizeof(uint64_t));
+      b_.CreateLifetimeEnd(arg_val);
+    }
+
+    CallInst *lookup = b_.CreateMapLookup(map, scoped_key.value());
+    llvm::Function *parent = b_.GetInsertBlock()->getParent();
+    BasicBlock *lookup_failure_block = BasicBlock::Create(module_->getContext(),
+                                                          "lookup_failure",
+                                                          parent);
+    BasicBlock *lookup_merge_block = BasicBlock::Create(module_->getContext(),
+                                                        "lookup_merge",
+                                                        parent);
+    BasicBlock *update_block = BasicBlock::Create(module_->getContext(),
+                                                  "distinct_update",
+                                                  parent);
+    BasicBlock *done_block = BasicBlock::Create(module_->getContext(),
+                                                "distinct_done",
+                                                parent);
+    BasicBlock *entry_block = b_.GetInsertBlock();
+    Value *lookup_condition = b_.CreateICmpNE(
+        b_.CreateIntCast(lookup, b_.getPtrTy(), true),
+        b_.GetNull(),
+        "lookup_cond");
+    b_.CreateCondBr(lookup_condition, lookup_merge_block, lookup_failure_block);
+
+    b_.SetInsertPoint(lookup_failure_block);
+    Value *zero = b_.CreateWriteMapValueAllocation(map.value_type,
+                                                   map.ident + "_zero",
+                                                   call.loc);
+    b_.CreateMemsetBPF(zero, b_.getInt8(0), map.value_type.GetSize());
+    b_.CreateMapUpdateElem(map.ident, scoped_key.value(), zero, call.loc);
+    if (dyn_cast<AllocaInst>(zero))
+      b_.CreateLifetimeEnd(zero);
+    CallInst *relookup = b_.CreateMapLookup(map, scoped_key.value());
+    BasicBlock *relookup_block = b_.GetInsertBlock();
+    b_.CreateBr(lookup_merge_block);
+
+    b_.SetInsertPoint(lookup_merge_block);
+    PHINode *registers = b_.CreatePHI(lookup->getType(), 2, "registers");
+    registers->addIncoming(lookup, entry_block);
+    registers->addIncoming(relookup, relookup_block);
+    Value *registers_condition = b_.CreateICmpNE(
+        b_.CreateIntCast(registers, b_.getPtrTy(), true),
+        b_.GetNull(),
+        "registers_cond");
+    b_.CreateCondBr(registers_condition, update_block, done_block);
+
+    b_.SetInsertPoint(update_block);
+    Value *idx = b_.CreateLShr(hash,
+                               b_.getInt64(64 - util::DISTINCT_PRECISION));
+    Value *bits = b_.CreateShl(hash, b_.getInt64(util::DISTINCT_PRECISION));
+    // Count leading zeros with a branchless binary search, BPF has no
+    // instruction for it.
+    Value *zeros = b_.getInt64(0);
+    for (uint64_t shift : { 32, 16, 8, 4, 2, 1 }) {
+      Value *is_zero = b_.CreateICmpEQ(
+          b_.CreateLShr(bits, b_.getInt64(64 - shift)), b_.getInt64(0));
+      zeros = b_.CreateSelect(is_zero,
+                              b_.CreateAdd(zeros, b_.getInt64(shift)),
+                              zeros);
+      bits = b_.CreateSelect(is_zero,
+                             b_.CreateShl(bits, b_.getInt64(shift)),
+                             bits);
+    }
+    Value *rho = b_.CreateAdd(zeros, b_.getInt64(1));
+    Value *max_rho = b_.getInt64(64 - util::DISTINCT_PRECISION + 1);
+    rho = b_.CreateSelect(b_.CreateICmpULT(rho, max_rho), rho, max_rho);
+    rho = b_.CreateTrunc(rho, b_.getInt8Ty());
+
+    Value *reg = b_.CreateGEP(b_.getInt8Ty(), registers, idx);
+    Value *old_rho = b_.CreateLoad(b_.getInt8Ty(), reg);
+    b_.CreateStore(
+        b_.CreateSelect(b_.CreateICmpUGT(rho, old_rho), rho, old_rho), reg);
+    b_.CreateBr(done_block);
+
+    b_.SetInsertPoint(done_block);
     return ScopedExpr();
   } else if (call.func == "delete") {
     auto &map = *call.vargs.at(0).as<Map>();
@@ -1934,11 +2153,7 @@ ScopedExpr CodegenLLVM::visit(Call &call)
     uint64_t size = std::min(
         { size_opt, left_arg.type().GetSize(), right_arg.type().GetSize() });
 
-    auto left_string = visit(&left_arg);
-    auto right_string = visit(&right_arg);
-
-    return ScopedExpr(b_.CreateStrncmp(
-        left_string.value(), right_string.value(), size, false));
+    return compare_strings(left_arg, right_arg, size, false, call.loc);
   } else if (call.func == "strcontains") {
     auto &left_arg = call.vargs.at(0);
     auto &right_arg = call.vargs.at(1);
@@ -2156,6 +2371,33 @@ ScopedExpr CodegenLLVM::visit(Variable &var)
   }
 }
 
+ScopedExpr CodegenLLVM::compare_strings(Expression &left,
+                                        Expression &right,
+                                        uint64_t n,
+                                        bool inverse,
+                                        const Location &loc)
+{
+  // Comparing against a literal is a single helper call, if available.
+  auto *literal = right.as<String>();
+  Expression *other = &left;
+  if (!literal) {
+    literal = left.as<String>();
+    other = &right;
+  }
+  if (literal && n > 0 && bpftrace_.feature_->has_helper_strncmp()) {
+    std::string s(literal->value);
+    s.resize(literal->string_type.GetSize() - 1);
+    auto scoped_str = visit(*other);
+    return ScopedExpr(
+        b_.CreateStrncmpLiteral(scoped_str.value(), s, n, inverse, loc));
+  }
+
+  auto left_string = visit(left);
+  auto right_string = visit(right);
+  return ScopedExpr(b_.CreateStrncmp(
+      left_string.value(), right_string.value(), n, inverse));
+}
+
 ScopedExpr CodegenLLVM::binop_string(Binop &binop)
 {
   if (binop.op != Operator::EQ && binop.op != Operator::NE) {
@@ -2165,13 +2407,9 @@ ScopedExpr CodegenLLVM::binop_string(Binop &binop)
   // strcmp returns 0 when strings are equal
   bool inverse = binop.op == Operator::EQ;
 
-  auto left_string = visit(binop.left);
-  auto right_string = visit(binop.right);
-
   size_t len = std::min(binop.left.type().GetSize(),
                         binop.right.type().GetSize());
-  return ScopedExpr(b_.CreateStrncmp(
-      left_string.value(), right_string.value(), len, inverse));
+  return compare_strings(binop.left, binop.right, len, inverse, binop.loc);
 }
 
 ScopedExpr CodegenLLVM::binop_integer_array(Binop &binop)
@@ -3378,6 +3616,16 @@ void CodegenLLVM::generateProbe(Probe &probe,
   // check: do the following 8 lines need to be in the wildcard loop?
   ctx_ = func->arg_begin();
 
+  const auto &cgroup_filter = bpftrace_.cgroup_filter_;
+  if (cgroup_filter &&
+      probe_needs_cgroup_filter(probe_type,
+                                bpftrace_.child_ || bpftrace_.pid())) {
+    b_.CreateCgroupFilter(cgroup_filter->id,
+                          cgroup_filter->level,
+                          current_attach_point_->loc,
+                          getReturnValueForProbe(probe_type));
+  }
+
   if (bpftrace_.need_recursion_check_) {
     b_.CreateCheckSetRecursion(current_attach_point_->loc,
                                getReturnValueForProbe(probe_type));
@@ -3945,11 +4193,10 @@ llvm::Function *CodegenLLVM::createLog2Function()
 
   FunctionType *log2_func_type = FunctionType::get(
       b_.getInt64Ty(), { b_.getInt64Ty(), b_.getInt64Ty() }, false);
-  auto *log2_func = llvm::Function::Create(
-      log2_func_type, llvm::Function::InternalLinkage, "log2", module_.get());
-  log2_func->addFnAttr(Attribute::AlwaysInline);
-  log2_func->setSection("helpers");
-  log2_func->addFnAttr(Attribute::NoUnwind);
+  Struct debug_args;
+  debug_args.AddField("n", CreateInt64());
+  debug_args.AddField("k", CreateInt64());
+  auto *log2_func = createHelperFunction("log2", log2_func_type, debug_args);
   BasicBlock *entry = BasicBlock::Create(module_->getContext(),
                                          "entry",
                                          log2_func);
@@ -4023,7 +4270,7 @@ llvm::Function *CodegenLLVM::createLog2Function()
   createRet(ret);
 
   b_.restoreIP(ip);
-  return module_->getFunction("log2");
+  return log2_func;
 }
 
 llvm::Function *CodegenLLVM::createLinearFunction()
@@ -4047,18 +4294,18 @@ llvm::Function *CodegenLLVM::createLinearFunction()
   //   return result;
   // }
 
-  // inlined function initialization
   FunctionType *linear_func_type = FunctionType::get(
       b_.getInt64Ty(),
       { b_.getInt64Ty(), b_.getInt64Ty(), b_.getInt64Ty(), b_.getInt64Ty() },
       false);
-  auto *linear_func = llvm::Function::Create(linear_func_type,
-                                             llvm::Function::InternalLinkage,
-                                             "linear",
-                                             module_.get());
-  linear_func->addFnAttr(Attribute::AlwaysInline);
-  linear_func->setSection("helpers");
-  linear_func->addFnAttr(Attribute::NoUnwind);
+  Struct debug_args;
+  debug_args.AddField("value", CreateInt64());
+  debug_args.AddField("min", CreateInt64());
+  debug_args.AddField("max", CreateInt64());
+  debug_args.AddField("step", CreateInt64());
+  auto *linear_func = createHelperFunction("linear",
+                                           linear_func_type,
+                                           debug_args);
   BasicBlock *entry = BasicBlock::Create(module_->getContext(),
                                          "entry",
                                          linear_func);
@@ -4130,7 +4377,49 @@ llvm::Function *CodegenLLVM::createLinearFunction()
   }
 
   b_.restoreIP(ip);
-  return module_->getFunction("linear");
+  return linear_func;
+}
+
+// Helpers that only take and return integers are emitted as global BPF
+// functions if the kernel supports them. The verifier checks a global function
+// once per program, regardless of its arguments, instead of checking an
+// inlined copy at every call site. Without support they are always inlined.
+llvm::Function *CodegenLLVM::createHelperFunction(const std::string &name,
+                                                  FunctionType *func_type,
+                                                  const Struct &debug_args)
+{
+  if (!bpftrace_.feature_->has_btf_func_global()) {
+    auto *func = llvm::Function::Create(
+        func_type, llvm::Function::InternalLinkage, name, module_.get());
+    func->addFnAttr(Attribute::AlwaysInline);
+    func->setSection("helpers");
+    func->addFnAttr(Attribute::NoUnwind);
+    return func;
+  }
+
+  // Global functions must be described in BTF, which is generated from the
+  // debug info.
+  auto *func = llvm::Function::Create(
+      func_type, llvm::Function::ExternalLinkage, name, module_.get());
+  func->setDSOLocal(true);
+  func->setSection(".text");
+  func->addFnAttr(Attribute::NoInline);
+  func->addFnAttr(Attribute::NoUnwind);
+  debug_.createFunctionDebugInfo(*func, CreateInt64(), debug_args);
+  return func;
+}
+
+CallInst *CodegenLLVM::createHelperCall(llvm::Function *func,
+                                        ArrayRef<Value *> args,
+                                        const Twine &name)
+{
+  CallInst *call = b_.CreateCall(func, args, name);
+  // Calls to functions with debug info need a location if the caller has
+  // debug info too.
+  auto *caller = b_.GetInsertBlock()->getParent()->getSubprogram();
+  if (caller && func->getSubprogram())
+    call->setDebugLoc(DILocation::get(llvm_ctx_, 0, 0, caller));
+  return call;
 }
 
 MDNode *CodegenLLVM::createLoopMetadata()
@@ -4161,10 +4450,18 @@ void CodegenLLVM::createFormatStringCall(Call &call,
   std::vector<llvm::Type *> elements = { b_.getInt64Ty() }; // ID
 
   const auto &args = std::get<1>(call_args.at(id));
+  size_t packed_size = 0;
   for (const Field &arg : args) {
+    if (arg.is_packed) {
+      packed_size += arg.type.GetSize();
+      continue;
+    }
     llvm::Type *ty = b_.GetType(arg.type);
     elements.push_back(ty);
   }
+  // Packed strings and buffers share the space at the end of the struct
+  if (packed_size > 0)
+    elements.push_back(ArrayType::get(b_.getInt8Ty(), packed_size));
   StructType *fmt_struct = StructType::create(elements,
                                               call_name + "_t",
                                               false);
@@ -4173,10 +4470,11 @@ void CodegenLLVM::createFormatStringCall(Call &call,
   // Check that offsets created during resource analysis match what LLVM
   // expects. This is just a guard rail against bad padding analysis logic.
   const auto *struct_layout = datalayout().getStructLayout(fmt_struct);
-  for (size_t i = 0; i < args.size(); i++) {
-    auto offset = static_cast<size_t>(args[i].offset);
-    // +1 for the id field
-    size_t expected_offset = struct_layout->getElementOffset(i + 1);
+  unsigned int elem = 1; // +1 for the id field
+  for (const Field &arg : args) {
+    auto offset = static_cast<size_t>(arg.offset);
+    size_t expected_offset = struct_layout->getElementOffset(
+        arg.is_packed ? elements.size() - 1 : elem++);
     if (offset != expected_offset)
       LOG(BUG) << "Calculated offset=" << offset
                << " does not match LLVM offset=" << expected_offset;
@@ -4185,20 +4483,36 @@ void CodegenLLVM::createFormatStringCall(Call &call,
   Value *fmt_args = b_.CreateGetFmtStringArgsAllocation(fmt_struct,
                                                         call_name + "_args",
                                                         call.loc);
-  // The struct is not packed so we need to memset it
-  b_.CreateMemsetBPF(fmt_args, b_.getInt8(0), struct_size);
+  // The struct is not packed so we need to memset it. Packed arguments are
+  // written back to back, so only the fixed part has padding.
+  size_t fixed_size = struct_size;
+  if (packed_size > 0)
+    fixed_size = struct_layout->getElementOffset(elements.size() - 1);
+  b_.CreateMemsetBPF(fmt_args, b_.getInt8(0), fixed_size);
 
   Value *id_offset = b_.CreateGEP(fmt_struct,
                                   fmt_args,
                                   { b_.getInt32(0), b_.getInt32(0) });
   b_.CreateStore(b_.getInt64(id + static_cast<int>(async_action)), id_offset);
 
+  // End of the packed arguments written so far
+  Value *packed_end = b_.getInt64(fixed_size);
+  elem = 1;
   for (size_t i = 1; i < call.vargs.size(); i++) {
     Expression &arg = call.vargs.at(i);
     auto scoped_arg = visit(arg);
+    if (args.at(i - 1).is_packed) {
+      Value *dst = b_.CreateGEP(b_.getInt8Ty(), fmt_args, packed_end);
+      Value *size = createPackedFormatArg(dst,
+                                          arg.type(),
+                                          scoped_arg.value(),
+                                          call.loc);
+      packed_end = b_.CreateAdd(packed_end, size, "packed.end");
+      continue;
+    }
     Value *offset = b_.CreateGEP(fmt_struct,
                                  fmt_args,
-                                 { b_.getInt32(0), b_.getInt32(i) });
+                                 { b_.getInt32(0), b_.getInt32(elem++) });
     if (needMemcpy(arg.type()))
       b_.CreateMemcpyBPF(offset, scoped_arg.value(), arg.type().GetSize());
     else if (arg.type().IsIntegerTy() && arg.type().GetSize() < 8)
@@ -4210,11 +4524,45 @@ void CodegenLLVM::createFormatStringCall(Call &call,
       b_.CreateStore(scoped_arg.value(), offset);
   }
 
-  b_.CreateOutput(fmt_args, struct_size, call.loc);
+  if (packed_size > 0)
+    b_.CreateOutput(fmt_args, packed_end, call.loc);
+  else
+    b_.CreateOutput(fmt_args, struct_size, call.loc);
   if (dyn_cast<AllocaInst>(fmt_args))
     b_.CreateLifetimeEnd(fmt_args);
 }
 
+Value *CodegenLLVM::createPackedFormatArg(Value *dst,
+                                          const SizedType &type,
+                                          Value *src,
+                                          const Location &loc)
+{
+  if (type.IsStringTy()) {
+    // Copies the string up to and including the NUL. On failure the helper
+    // zeroes dst, which is sent as an empty string.
+    CallInst *read = b_.CreateProbeReadStr(dst,
+                                           type.GetSize(),
+                                           src,
+                                           AddrSpace::kernel,
+                                           loc);
+    Value *failed = b_.CreateICmpSLT(read, b_.getInt64(1));
+    return b_.CreateSelect(failed, b_.getInt64(1), read, "packed.str_size");
+  }
+
+  assert(type.IsBufferTy());
+  // Copies the length prefix and as much content as it says, bounded by the
+  // buffer size so the verifier can check the read.
+  const uint32_t max_length = type.GetSize() - sizeof(AsyncEvent::Buf);
+  Value *length = b_.CreateLoad(b_.getInt32Ty(), src, "packed.buf_length");
+  Value *too_long = b_.CreateICmpUGT(length, b_.getInt32(max_length));
+  length = b_.CreateSelect(too_long, b_.getInt32(max_length), length);
+  Value *size = b_.CreateAdd(length,
+                             b_.getInt32(sizeof(AsyncEvent::Buf)),
+                             "packed.buf_size");
+  b_.CreateProbeRead(dst, size, src, AddrSpace::kernel, loc);
+  return b_.CreateZExt(size, b_.getInt64Ty());
+}
+
 Result<> CodegenLLVM::generateWatchpointSetupProbe(
     FunctionType *func_type,
     const std::string &expanded_probe_name,
@@ -4367,26 +4715,52 @@ void CodegenLLVM::createJoinCall(Call &call, int id)
   Value *value = scoped_arg.value();
   AllocaInst *arr = b_.CreateAllocaBPF(b_.getInt64Ty(), call.func + "_r0");
 
+  // Arguments are packed back to back, each with its NUL. An unreadable or
+  // empty argument ends the list, and the NUL it leaves behind is sent along
+  // as the terminator.
+  BasicBlock *done = BasicBlock::Create(module_->getContext(),
+                                        "join_done",
+                                        parent);
+  std::vector<std::pair<Value *, BasicBlock *>> content_sizes;
+  Value *content_end = b_.getInt64(0);
   for (unsigned int i = 0; i < bpftrace_.join_argnum_; i++) {
     if (i > 0) {
       value = b_.CreateAdd(value, b_.getInt64(ptr_width / 8));
     }
 
     b_.CreateProbeRead(arr, elem_type, value, call.loc);
-    Value *str_offset = b_.getInt64(
-        static_cast<uint64_t>(i) *
-        static_cast<uint64_t>(bpftrace_.join_argsize_));
-    Value *str_ptr = b_.CreateGEP(b_.getInt8Ty(), content_ptr, str_offset);
-
-    b_.CreateProbeReadStr(str_ptr,
-                          bpftrace_.join_argsize_,
-                          b_.CreateLoad(b_.getInt64Ty(), arr),
-                          addrspace,
-                          call.loc);
+    Value *str_ptr = b_.CreateGEP(b_.getInt8Ty(), content_ptr, content_end);
+
+    CallInst *read = b_.CreateProbeReadStr(str_ptr,
+                                           bpftrace_.join_argsize_,
+                                           b_.CreateLoad(b_.getInt64Ty(), arr),
+                                           addrspace,
+                                           call.loc);
+    BasicBlock *next = BasicBlock::Create(module_->getContext(),
+                                          "join_next",
+                                          parent);
+    content_sizes.emplace_back(b_.CreateAdd(content_end, b_.getInt64(1)),
+                               b_.GetInsertBlock());
+    Value *last = b_.CreateICmpSLT(read, b_.getInt64(2), "join.last");
+    b_.CreateCondBr(last, done, next);
+
+    b_.SetInsertPoint(next);
+    content_end = b_.CreateAdd(content_end, read, "join.end");
   }
+  content_sizes.emplace_back(content_end, b_.GetInsertBlock());
+  b_.CreateBr(done);
+
+  done->moveAfter(b_.GetInsertBlock());
+  b_.SetInsertPoint(done);
+  PHINode *content_size_phi = b_.CreatePHI(b_.getInt64Ty(),
+                                           content_sizes.size(),
+                                           "join.size");
+  for (auto &[size, block] : content_sizes)
+    content_size_phi->addIncoming(size, block);
+
   size_t header_size = offsetof(AsyncEvent::Join, content); // action_id +
                                                             // join_id
-  size_t total_size = header_size + content_size;
+  Value *total_size = b_.CreateAdd(b_.getInt64(header_size), content_size_phi);
   b_.CreateOutput(perfdata, total_size, call.loc);
 
   b_.CreateBr(failure_callback);
@@ -4509,22 +4883,34 @@ void CodegenLLVM::generate_maps(const RequiredResources &required_resources,
 
   // bpftrace internal maps
 
-  uint16_t max_stack_limit = 0;
+  uint32_t max_stack_words = 0;
   for (const StackType &stack_type : codegen_resources.stackid_maps) {
     createMapDefinition(stack_type.name(),
                         libbpf::BPF_MAP_TYPE_LRU_HASH,
                         128 << 10,
                         CreateArray(16, CreateInt8()),
-                        CreateArray(stack_type.limit, CreateUInt64()));
-    max_stack_limit = std::max(stack_type.limit, max_stack_limit);
+                        CreateArray(stack_type.value_words(), CreateUInt64()));
+    max_stack_words = std::max(stack_type.value_words(), max_stack_words);
   }
 
-  if (max_stack_limit > 0) {
+  if (max_stack_words > 0) {
     createMapDefinition(StackType::scratch_name(),
                         libbpf::BPF_MAP_TYPE_PERCPU_ARRAY,
                         1,
                         CreateUInt32(),
-                        CreateArray(max_stack_limit, CreateUInt64()));
+                        CreateArray(max_stack_words, CreateUInt64()));
+  }
+
+  for (const auto &[name, info] : required_resources.maps_info) {
+    if (!info.value_type.IsTopkTy())
+      continue;
+    createMapDefinition(
+        topk_sketch_map_name(name),
+        libbpf::BPF_MAP_TYPE_PERCPU_ARRAY,
+        1,
+        CreateUInt32(),
+        CreateArray(util::TOPK_SKETCH_ROWS * util::TOPK_SKETCH_COLS,
+                    CreateUInt32()));
   }
 
   if (codegen_resources.needs_join_map) {
@@ -4756,7 +5142,7 @@ ScopedExpr CodegenLLVM::createIncDec(Unop &unop)
   }
 }
 
-llvm::Function *CodegenLLVM::createMurmurHash2Func()
+llvm::Function *CodegenLLVM::createMurmurHash2Func(bool build_id_frames)
 {
   // The goal is to produce the following code:
   //
@@ -4790,7 +5176,7 @@ llvm::Function *CodegenLLVM::createMurmurHash2Func()
   auto *callback = llvm::Function::Create(
       callback_type,
       llvm::Function::LinkageTypes::InternalLinkage,
-      "murmur_hash_2",
+      build_id_frames ? "murmur_hash_2_build_id" : "murmur_hash_2",
       module_.get());
   callback->addFnAttr(Attribute::AlwaysInline);
   callback->setSection("helpers");
@@ -4849,10 +5235,30 @@ llvm::Function *CodegenLLVM::createMurmurHash2Func()
   b_.SetInsertPoint(while_body);
 
   // uint64_t k = stack[i];
-  Value *stack_ptr = b_.CreateGEP(b_.getInt64Ty(),
-                                  stack_addr,
-                                  b_.CreateLoad(b_.getInt8Ty(), i));
-  b_.CreateStore(b_.CreateLoad(b_.getInt64Ty(), stack_ptr), k);
+  if (build_id_frames) {
+    // Each frame is a struct bpf_stack_build_id: { s32 status; u8
+    // build_id[20]; u64 offset; }. Mix the last 8 bytes of the build-id
+    // into the offset, which is plenty to tell binaries apart.
+    Value *frame = b_.CreateMul(
+        b_.CreateIntCast(b_.CreateLoad(b_.getInt8Ty(), i),
+                         b_.getInt64Ty(),
+                         false),
+        b_.getInt64(4));
+    Value *build_id_ptr = b_.CreateGEP(b_.getInt64Ty(),
+                                       stack_addr,
+                                       b_.CreateAdd(frame, b_.getInt64(2)));
+    Value *offset_ptr = b_.CreateGEP(b_.getInt64Ty(),
+                                     stack_addr,
+                                     b_.CreateAdd(frame, b_.getInt64(3)));
+    b_.CreateStore(b_.CreateXor(b_.CreateLoad(b_.getInt64Ty(), build_id_ptr),
+                                b_.CreateLoad(b_.getInt64Ty(), offset_ptr)),
+                   k);
+  } else {
+    Value *stack_ptr = b_.CreateGEP(b_.getInt64Ty(),
+                                    stack_addr,
+                                    b_.CreateLoad(b_.getInt8Ty(), i));
+    b_.CreateStore(b_.CreateLoad(b_.getInt64Ty(), stack_ptr), k);
+  }
 
   // k *= m;
   b_.CreateStore(b_.CreateMul(b_.CreateLoad(b_.getInt64Ty(), k), m), k);
@@ -4918,6 +5324,42 @@ llvm::Function *CodegenLLVM::createMurmurHash2Func()
   return callback;
 }
 
+// Hash `size` bytes at `data` with the MurmurHash64A mixing steps used by
+// murmur_hash_2 above. Key sizes are always known at compile time so the loop
+// is fully unrolled, and the trailing bytes are folded in one at a time as
+// the data is not guaranteed to be 8-byte aligned.
+Value *CodegenLLVM::createKeyHash(Value *data, size_t size)
+{
+  Value *m = b_.getInt64(0xc6a4a7935bd1e995LLU);
+  Value *r = b_.getInt64(47);
+
+  Value *h = b_.getInt64(size * 0xc6a4a7935bd1e995LLU);
+  size_t off = 0;
+  for (; off + 8 <= size; off += 8) {
+    Value *ptr = b_.CreateGEP(b_.getInt8Ty(), data, b_.getInt64(off));
+    Value *k = b_.CreateAlignedLoad(b_.getInt64Ty(), ptr, MaybeAlign(1));
+    k = b_.CreateMul(k, m);
+    k = b_.CreateXor(k, b_.CreateLShr(k, r));
+    k = b_.CreateMul(k, m);
+    h = b_.CreateMul(b_.CreateXor(h, k), m);
+  }
+
+  if (off < size) {
+    Value *tail = b_.getInt64(0);
+    for (size_t i = 0; off + i < size; i++) {
+      Value *ptr = b_.CreateGEP(b_.getInt8Ty(), data, b_.getInt64(off + i));
+      Value *byte = b_.CreateZExt(b_.CreateLoad(b_.getInt8Ty(), ptr),
+                                  b_.getInt64Ty());
+      tail = b_.CreateOr(tail, b_.CreateShl(byte, b_.getInt64(8 * i)));
+    }
+    h = b_.CreateMul(b_.CreateXor(h, tail), m);
+  }
+
+  h = b_.CreateXor(h, b_.CreateLShr(h, r));
+  h = b_.CreateMul(h, m);
+  return b_.CreateXor(h, b_.CreateLShr(h, r), "key_hash");
+}
+
 llvm::Function *CodegenLLVM::createMapLenCallback()
 {
   // The goal is to produce the following code:
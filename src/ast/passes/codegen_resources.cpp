@@ -21,7 +21,9 @@ void CodegenResourceAnalyser::visit(Builtin &builtin)
   if (builtin.ident == "elapsed") {
     resources_.needs_elapsed_map = true;
   } else if (builtin.ident == "kstack" || builtin.ident == "ustack") {
-    resources_.stackid_maps.insert(StackType{ .mode = config_.stack_mode });
+    resources_.stackid_maps.insert(
+        StackType{ .mode = config_.stack_mode,
+                   .kernel = builtin.ident == "kstack" });
   }
 }
 
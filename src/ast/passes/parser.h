@@ -10,6 +10,7 @@
 #include "ast/passes/import_scripts.h"
 #include "ast/passes/macro_expansion.h"
 #include "ast/passes/map_sugar.h"
+#include "ast/passes/probe_upgrade.h"
 #include "ast/passes/resolve_imports.h"
 #include "ast/passes/unstable_feature.h"
 #include "btf.h"
@@ -34,6 +35,7 @@ inline std::vector<Pass> AllParsePasses(
   passes.emplace_back(CreateDeprecatedPass());
   passes.emplace_back(CreateParseAttachpointsPass());
   passes.emplace_back(CreateParseBTFPass());
+  passes.emplace_back(CreateProbeUpgradePass());
   passes.emplace_back(CreateParseTracepointFormatPass());
   passes.emplace_back(CreateFieldAnalyserPass());
   passes.emplace_back(CreateClangParsePass(std::move(extra_flags)));
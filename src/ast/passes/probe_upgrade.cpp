@@ -0,0 +1,170 @@
+#include <string>
+
+#include "ast/ast.h"
+#include "ast/passes/probe_upgrade.h"
+#include "ast/visitor.h"
+#include "bpftrace.h"
+#include "btf.h"
+#include "log.h"
+
+namespace bpftrace::ast {
+
+namespace {
+
+// Finds the first use of a builtin or function in a probe whose meaning
+// would change if the probe was attached with a different mechanism.
+class UpgradeBlocker : public Visitor<UpgradeBlocker> {
+public:
+  explicit UpgradeBlocker(BPFtrace &bpftrace) : bpftrace_(bpftrace)
+  {
+  }
+
+  using Visitor<UpgradeBlocker>::visit;
+  void visit(Builtin &builtin);
+  void visit(Call &call);
+
+  std::string use;
+
+private:
+  BPFtrace &bpftrace_;
+};
+
+void UpgradeBlocker::visit(Builtin &builtin)
+{
+  if (!use.empty())
+    return;
+
+  // argX and sargX read registers and the stack, while fentry and raw
+  // tracepoint arguments are typed. A kretprobe's retval is always a uint64,
+  // a fexit's has the function's return type. The args of a tracepoint are
+  // the fields of its event, not the arguments of its raw tracepoint. probe
+  // would return the new attach point.
+  if (builtin.is_argx() || builtin.ident.starts_with("sarg") ||
+      builtin.ident == "retval" || builtin.ident == "args" ||
+      builtin.ident == "ctx" || builtin.ident == "probe")
+    use = builtin.ident;
+  else if (builtin.ident == "func" &&
+           !bpftrace_.feature_->has_helper_get_func_ip())
+    use = builtin.ident;
+}
+
+void UpgradeBlocker::visit(Call &call)
+{
+  if (!use.empty())
+    return;
+
+  if (call.func == "reg" || call.func == "override")
+    use = call.func + "()";
+  else
+    Visitor<UpgradeBlocker>::visit(call);
+}
+
+class ProbeUpgrade : public Visitor<ProbeUpgrade> {
+public:
+  explicit ProbeUpgrade(BPFtrace &bpftrace) : bpftrace_(bpftrace)
+  {
+  }
+
+  using Visitor<ProbeUpgrade>::visit;
+  void visit(Probe &probe);
+
+private:
+  bool upgrade_kprobe(AttachPoint &ap, ProbeType type);
+  bool upgrade_tracepoint(AttachPoint &ap);
+
+  BPFtrace &bpftrace_;
+};
+
+void ProbeUpgrade::visit(Probe &probe)
+{
+  UpgradeBlocker blocker(bpftrace_);
+  blocker.visit(probe.pred);
+  blocker.visit(probe.block);
+
+  for (auto *ap : probe.attach_points) {
+    auto type = probetype(ap->provider);
+    if (type != ProbeType::kprobe && type != ProbeType::kretprobe &&
+        type != ProbeType::tracepoint)
+      continue;
+    // Wildcards may match functions and events that cannot be upgraded, and
+    // offsets and addresses only work with kprobes.
+    if (ap->expansion != ExpansionType::NONE || ap->func.empty() ||
+        ap->func_offset != 0 || ap->address != 0)
+      continue;
+
+    if (!blocker.use.empty()) {
+      LOG(V1) << "Not upgrading " << ap->name() << ": probe uses "
+              << blocker.use;
+      continue;
+    }
+
+    auto old_name = ap->name();
+    bool upgraded = type == ProbeType::tracepoint ? upgrade_tracepoint(*ap)
+                                                  : upgrade_kprobe(*ap, type);
+    if (upgraded)
+      LOG(V1) << "Upgraded " << old_name << " to " << ap->name();
+  }
+}
+
+bool ProbeUpgrade::upgrade_kprobe(AttachPoint &ap, ProbeType type)
+{
+  auto modules = bpftrace_.get_func_modules(ap.func);
+  if (modules.size() != 1 ||
+      (!ap.target.empty() && !modules.contains(ap.target))) {
+    LOG(V1) << "Not upgrading " << ap.name()
+            << ": function is not in exactly one module";
+    return false;
+  }
+
+  std::string err;
+  if (!bpftrace_.btf_->resolve_args(
+          ap.func, type == ProbeType::kretprobe, true, false, err)) {
+    LOG(V1) << "Not upgrading " << ap.name() << ": " << err;
+    return false;
+  }
+
+  ap.provider = type == ProbeType::kretprobe ? "fexit" : "fentry";
+  ap.target = *modules.begin();
+  return true;
+}
+
+bool ProbeUpgrade::upgrade_tracepoint(AttachPoint &ap)
+{
+  // Raw tracepoints are named after the event, without the category.
+  auto modules = bpftrace_.get_raw_tracepoint_modules(ap.func);
+  if (modules.size() != 1) {
+    LOG(V1) << "Not upgrading " << ap.name()
+            << ": no raw tracepoint with the same name";
+    return false;
+  }
+
+  std::string err;
+  if (!bpftrace_.btf_->resolve_raw_tracepoint_args(ap.func, err)) {
+    LOG(V1) << "Not upgrading " << ap.name() << ": " << err;
+    return false;
+  }
+
+  ap.provider = "rawtracepoint";
+  ap.target = *modules.begin();
+  return true;
+}
+
+} // namespace
+
+// Attaches kprobes, kretprobes and tracepoints with fentry, fexit and raw
+// tracepoints where the kernel supports it, as these avoid the trap of a
+// kprobe and the copy of the event into the trace buffer of a tracepoint.
+//
+// This is only done for probes that would behave the same after the upgrade,
+// other probes are left alone.
+Pass CreateProbeUpgradePass()
+{
+  return Pass::create("ProbeUpgrade", [](ASTContext &ast, BPFtrace &b) {
+    if (!b.config_->upgrade_probes || !b.feature_->has_fentry())
+      return;
+    ProbeUpgrade upgrade(b);
+    upgrade.visit(ast.root);
+  });
+}
+
+} // namespace bpftrace::ast
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "ast/pass_manager.h"
+
+namespace bpftrace::ast {
+
+Pass CreateProbeUpgradePass();
+
+} // namespace bpftrace::ast
@@ -21,6 +21,10 @@ namespace bpftrace::ast {
 
 namespace {
 
+// Format string arguments at least this large are packed at the end of the
+// event, see Field::is_packed.
+constexpr size_t MIN_PACKED_ARG_SIZE = 64;
+
 // Resource analysis pass on AST
 //
 // This pass collects information on what runtime resources a script needs.
@@ -201,6 +205,56 @@ void ResourceAnalyser::visit(Call &call)
     // creation to generate offsets for each argument in the args "tuple".
     auto tuple = Struct::CreateTuple(args);
 
+    // Large strings and buffers are mostly empty, e.g. a path in a
+    // max_strlen sized string. If the event does not fit on the stack
+    // anyway, only send what they hold by packing them at the end of the
+    // event. Events printed by the kernel itself keep the fixed layout.
+    bool is_async = call.func != "debugf" &&
+                    (probe_ == nullptr ||
+                     single_provider_type_postsema(probe_) != ProbeType::iter);
+    auto is_packed = [](const SizedType &ty) {
+      return (ty.IsStringTy() || ty.IsBufferTy()) &&
+             ty.GetSize() >= MIN_PACKED_ARG_SIZE;
+    };
+    std::vector<SizedType> fixed_args;
+    size_t packed_size = 0;
+    for (const auto &ty : args) {
+      if (is_packed(ty))
+        packed_size += ty.GetSize();
+      else
+        fixed_args.push_back(ty);
+    }
+    if (is_async && packed_size > 0) {
+      // The packed arguments are laid out as a byte array after the fixed
+      // ones, which is also how codegen sees them.
+      fixed_args.push_back(CreateArray(packed_size, CreateInt8()));
+      auto fixed = Struct::CreateTuple(fixed_args);
+      // Packed arguments are written at a variable offset, which older
+      // kernels only allow into the scratch map and not on the stack.
+      if (exceeds_stack_limit(fixed->size)) {
+        ssize_t packed_offset = fixed->fields.back().offset;
+        fixed->fields.pop_back();
+
+        auto fixed_field = fixed->fields.begin();
+        Fields fields;
+        for (const auto &ty : args) {
+          if (is_packed(ty)) {
+            fields.push_back(Field{
+                .name = "",
+                .type = ty,
+                .offset = packed_offset,
+                .bitfield = std::nullopt,
+                .is_packed = true,
+            });
+          } else {
+            fields.push_back(*fixed_field++);
+          }
+        }
+        fixed->fields = std::move(fields);
+        tuple = std::move(fixed);
+      }
+    }
+
     // Remove implicit printf ID field. Downstream consumers do not
     // expect it nor do they care about it.
     tuple->fields.erase(tuple->fields.begin());
@@ -315,6 +369,21 @@ void ResourceAnalyser::visit(Call &call)
     } else {
       call.addError() << "Different tseries bounds in a single map unsupported";
     }
+  } else if (call.func == "topk") {
+    Map *map = call.vargs.at(0).as<Map>();
+    auto args = TopkArgs{
+      .k = static_cast<long>(call.vargs.at(2).as<Integer>()->value),
+    };
+
+    auto &map_info = resources_.maps_info[map->ident];
+    if (std::holds_alternative<std::monostate>(map_info.detail)) {
+      map_info.detail.emplace<TopkArgs>(args);
+    } else if (std::holds_alternative<TopkArgs>(map_info.detail) &&
+               std::get<TopkArgs>(map_info.detail) == args) {
+      // Same arguments.
+    } else {
+      call.addError() << "Different k in a single topk map unsupported";
+    }
   } else if (call.func == "time") {
     if (!call.vargs.empty())
       resources_.time_args.push_back(call.vargs.at(0).as<String>()->value);
@@ -345,7 +414,8 @@ void ResourceAnalyser::visit(Call &call)
 
     resources_.skboutput_args_.emplace_back(file, offset);
     resources_.using_skboutput = true;
-  } else if (call.func == "delete") {
+  } else if (call.func == "delete" || call.func == "distinct") {
+    // distinct() zero-initialises its registers for new keys the same way.
     auto &arg0 = call.vargs.at(0);
     auto &map = *arg0.as<Map>();
     if (exceeds_stack_limit(map.value_type.GetSize())) {
@@ -376,14 +446,16 @@ void ResourceAnalyser::visit(Call &call)
   // buffer here.
   //
   // The exceptions are:
-  // 1. lhist/hist/tseries because the map key buffer includes both the key
-  //    itself and the bucket ID from a call to linear/log2/tseries functions.
+  // 1. lhist/hist/quantiles/tseries because the map key buffer includes both
+  //    the key itself and the bucket ID from a call to linear/log2/tseries
+  //    functions.
   // 2. has_key/delete because the map key buffer allocation depends on
   //    arguments to the function e.g.
   //      delete(@, 2)
   //    requires a map key buffer to hold arg1 = 2 but map.key_expr is null
   //    so the map key buffer check in visit(Map &map) doesn't work as is.
-  if (call.func == "lhist" || call.func == "hist" || call.func == "tseries") {
+  if (call.func == "lhist" || call.func == "hist" ||
+      call.func == "quantiles" || call.func == "tseries") {
     auto &map = *call.vargs.at(0).as<Map>();
     // Allocation is always needed for lhist/hist/tseries. But we need to
     // allocate space for both map key and the bucket ID from a call to
@@ -601,6 +673,7 @@ void ResourceAnalyser::update_map_info(Map &map)
   if (decl != map_decls_.end()) {
     map_info.bpf_type = decl->second.first;
     map_info.max_entries = decl->second.second;
+    map_info.is_declared = true;
   } else {
     map_info.bpf_type = get_bpf_map_type(map_info.value_type,
                                          map_info.is_scalar);
@@ -22,6 +22,7 @@
 #include "types.h"
 #include "usdt.h"
 #include "util/paths.h"
+#include "util/sketch.h"
 #include "util/strings.h"
 #include "util/system.h"
 #include "util/wildcard.h"
@@ -332,6 +333,15 @@ static const std::map<std::string, call_spec> CALL_SPEC = {
         map_key_spec{ .map_index=0 },
       }
        } },
+  { "distinct",
+    { .min_args=3,
+      .max_args=3,
+      .arg_types={
+        map_type_spec{
+          .type = std::function<SizedType(const Call&)>([](const ast::Call&) -> SizedType { return CreateDistinct(); })
+        },
+        map_key_spec{ .map_index=0 },
+        arg_type_spec{ .skip_check=true } } } },
   { "exit",
     { .min_args=0,
       .max_args=1,
@@ -411,6 +421,15 @@ static const std::map<std::string, call_spec> CALL_SPEC = {
         arg_type_spec{ .type=Type::integer, .literal=true },
         arg_type_spec{ .type=Type::integer, .literal=true },
         arg_type_spec{ .type=Type::string, .literal=true } } } },
+  { "topk",
+    { .min_args=2,
+      .max_args=3,
+      .arg_types={
+        map_type_spec{
+          .type = std::function<SizedType(const ast::Call&)>([]([[maybe_unused]] const ast::Call &call) -> SizedType { return CreateTopk(); })
+        },
+        map_key_spec{ .map_index=0 },
+        arg_type_spec{ .type=Type::integer, .literal=true } } } },
   { "macaddr",
     { .min_args=1,
       .max_args=1,
@@ -484,6 +503,15 @@ static const std::map<std::string, call_spec> CALL_SPEC = {
     { .min_args=1,
       .max_args=1,
       .discard_ret_warn = true, } },
+  { "quantiles",
+    { .min_args=3,
+      .max_args=3,
+      .arg_types={
+        map_type_spec{
+          .type = std::function<SizedType(const Call&)>([](const ast::Call&) -> SizedType { return CreateQuantiles(); })
+        },
+        map_key_spec{ .map_index=0 },
+        arg_type_spec{ .type=Type::integer } } } },
   { "reg",
     { .min_args=1,
       .max_args=1,
@@ -683,6 +711,9 @@ static bool IsValidVarDeclType(const SizedType &ty)
     case Type::hist_t:
     case Type::lhist_t:
     case Type::tseries_t:
+    case Type::topk_t:
+    case Type::quantiles_t:
+    case Type::distinct_t:
     case Type::max_t:
     case Type::min_t:
     case Type::stats_t:
@@ -1305,6 +1336,31 @@ void SemanticAnalyser::visit(Call &call)
     }
 
     call.return_type = CreateTSeries();
+  } else if (call.func == "topk") {
+    if (call.vargs.size() == 2) {
+      call.vargs.emplace_back(ctx_.make_node<Integer>(
+          util::TOPK_DEFAULT_K, Location(call.loc))); // default k is 10
+    } else {
+      const auto *k = call.vargs.at(2).as<Integer>();
+      if (!k) {
+        call.addError() << call.func
+                        << ": invalid k value (must be positive literal)";
+      } else if (k->value == 0 || k->value > util::TOPK_MAX_K) {
+        call.addError() << call.func << ": k " << k->value << " must be 1.."
+                        << util::TOPK_MAX_K;
+      }
+    }
+
+    if (is_final_pass()) {
+      auto &map = *call.vargs.at(0).as<Map>();
+      if (map_metadata_.scalar[map.ident]) {
+        call.addError() << call.func
+                        << "() counts map keys and must be assigned to a "
+                           "keyed map, e.g. @x[comm] = topk()";
+      }
+    }
+
+    call.return_type = CreateTopk();
   } else if (call.func == "count") {
     call.return_type = CreateCount();
   } else if (call.func == "sum") {
@@ -1317,6 +1373,19 @@ void SemanticAnalyser::visit(Call &call)
     call.return_type = CreateAvg(true);
   } else if (call.func == "stats") {
     call.return_type = CreateStats(true);
+  } else if (call.func == "distinct") {
+    const auto &t = call.vargs.at(2).type();
+    if (is_final_pass() &&
+        !(t.IsIntegerTy() || t.IsBoolTy() || t.IsPtrTy() || t.IsStringTy() ||
+          t.IsBufferTy() || t.IsInetTy() || t.IsTupleTy() || t.IsStack())) {
+      call.addError() << call.func
+                      << "() expects an integer, string, buffer, inet, tuple "
+                         "or stack argument ("
+                      << t << " provided)";
+    }
+    call.return_type = CreateDistinct();
+  } else if (call.func == "quantiles") {
+    call.return_type = CreateQuantiles();
   } else if (call.func == "delete") {
     call.return_type = CreateUInt8();
   } else if (call.func == "has_key") {
@@ -1969,7 +2038,8 @@ void SemanticAnalyser::validate_map_key(const SizedType &key, Node &node)
   }
 
   if (key.IsHistTy() || key.IsLhistTy() || key.IsStatsTy() ||
-      key.IsTSeriesTy()) {
+      key.IsTSeriesTy() || key.IsTopkTy() || key.IsDistinctTy() ||
+      key.IsQuantilesTy()) {
     node.addError() << key << " cannot be used as a map key";
   }
 
@@ -3128,7 +3198,10 @@ static const std::unordered_map<Type, std::string_view> AGGREGATE_HINTS{
   { Type::hist_t, "hist(retval)" },
   { Type::lhist_t, "lhist(rand %10, 0, 10, 1)" },
   { Type::tseries_t, "tseries(rand %10, 10s, 1)" },
+  { Type::topk_t, "topk()" },
   { Type::stats_t, "stats(arg2)" },
+  { Type::distinct_t, "distinct(pid)" },
+  { Type::quantiles_t, "quantiles(retval)" },
 };
 
 void SemanticAnalyser::visit(AssignMapStatement &assignment)
@@ -3777,6 +3850,17 @@ void SemanticAnalyser::visit(Probe &probe)
       return;
     }
     visit(ap);
+
+    auto type = probetype(ap->provider);
+    if (bpftrace_.cgroup_filter_ &&
+        probe_needs_cgroup_filter(type, bpftrace_.child_ || bpftrace_.pid()) &&
+        !bpftrace_.feature_->has_helper_get_current_ancestor_cgroup_id(
+            progtype(type))) {
+      ap->addError() << "--cgroup is not supported for " << type
+                     << " probes: the get_current_ancestor_cgroup_id BPF "
+                        "helper is not available for "
+                     << progtypeName(progtype(type)) << " programs";
+    }
   }
   visit(probe.pred);
   visit(probe.block);
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -18,19 +19,32 @@ void AsyncHandlers::exit(const void *data)
   bpftrace.request_finalize();
 }
 
-void AsyncHandlers::join(const void *data)
+void AsyncHandlers::join(const void *data, size_t size)
 {
+  if (size < sizeof(AsyncEvent::Join))
+    throw util::FatalUserException("join: event of size " +
+                                   std::to_string(size) + " is too small");
   const auto *join = static_cast<const AsyncEvent::Join *>(data);
   uint64_t join_id = join->join_id;
   const auto *delim = bpftrace.resources.join_args[join_id].c_str();
   std::stringstream joined;
+  // Arguments are NUL-terminated and packed back to back, the event ends
+  // after the last one
+  const auto *arg = join->content;
+  const auto *end = static_cast<const char *>(data) + size;
   for (unsigned int i = 0; i < bpftrace.join_argnum_; i++) {
-    const auto *arg = join->content + (i * bpftrace.join_argsize_);
-    if (arg[0] == 0)
+    size_t length = strnlen(arg, end - arg);
+    if (length == static_cast<size_t>(end - arg))
+      throw util::FatalUserException(
+          "join: argument " + std::to_string(i) +
+          " is not terminated within the event of size " +
+          std::to_string(size));
+    if (length == 0)
       break;
     if (i)
       joined << delim;
     joined << arg;
+    arg += length + 1;
   }
   out.message(MessageType::join, joined.str());
 }
@@ -77,6 +91,13 @@ void AsyncHandlers::print_non_map(const void *data)
   out.value(bpftrace, ty, bytes);
 }
 
+bool AsyncHandlers::is_topk_map(const BpfMap &map) const
+{
+  auto map_info = bpftrace.resources.maps_info.find(map.name());
+  return map_info != bpftrace.resources.maps_info.end() &&
+         map_info->second.value_type.IsTopkTy();
+}
+
 void AsyncHandlers::print_map(const void *data)
 {
   const auto *print = static_cast<const AsyncEvent::Print *>(data);
@@ -93,6 +114,12 @@ void AsyncHandlers::zero_map(const void *data)
 {
   const auto *mapevent = static_cast<const AsyncEvent::MapEvent *>(data);
   const auto &map = bpftrace.bytecode_.getMap(mapevent->mapid);
+  if (is_topk_map(map)) {
+    // The values of a topk-map are key hashes, not counts, so zeroing it is
+    // the same as clearing it.
+    clear_map(data);
+    return;
+  }
   uint64_t nvalues = map.is_per_cpu_type() ? bpftrace.ncpus_ : 1;
   auto ok = map.zero_out(nvalues);
 
@@ -112,6 +139,16 @@ void AsyncHandlers::clear_map(const void *data)
     LOG(BUG) << "Could not clear map with ident \"" << map.name()
              << "\", err=" << ok.takeError();
   }
+
+  if (is_topk_map(map)) {
+    const auto &sketch = bpftrace.bytecode_.getMap(
+        topk_sketch_map_name(map.name()));
+    auto ok = sketch.zero_out(bpftrace.ncpus_);
+    if (!ok) {
+      LOG(BUG) << "Could not zero topk sketch of map with ident \""
+               << map.name() << "\", err=" << ok.takeError();
+    }
+  }
 }
 
 void AsyncHandlers::watchpoint_attach(const void *data)
@@ -199,7 +236,9 @@ void AsyncHandlers::skboutput(void *data, int size)
       hdr->id, hdr->ns, hdr->pkt + offset, size - sizeof(*hdr));
 }
 
-void AsyncHandlers::syscall(AsyncAction printf_id, uint8_t *arg_data)
+void AsyncHandlers::syscall(AsyncAction printf_id,
+                            uint8_t *arg_data,
+                            size_t size)
 {
   if (bpftrace.safe_mode_) {
     throw util::FatalUserException(
@@ -210,20 +249,22 @@ void AsyncHandlers::syscall(AsyncAction printf_id, uint8_t *arg_data)
             static_cast<uint64_t>(AsyncAction::syscall);
   auto &fmt = std::get<0>(bpftrace.resources.system_args[id]);
   auto &args = std::get<1>(bpftrace.resources.system_args[id]);
-  auto arg_values = bpftrace.get_arg_values(out, args, arg_data);
+  auto arg_values = bpftrace.get_arg_values(out, args, arg_data, size);
 
   out.message(MessageType::syscall,
               util::exec_system(fmt.format_str(arg_values).c_str()),
               false);
 }
 
-void AsyncHandlers::cat(AsyncAction printf_id, uint8_t *arg_data)
+void AsyncHandlers::cat(AsyncAction printf_id,
+                        uint8_t *arg_data,
+                        size_t size)
 {
   auto id = static_cast<size_t>(printf_id) -
             static_cast<size_t>(AsyncAction::cat);
   auto &fmt = std::get<0>(bpftrace.resources.cat_args[id]);
   auto &args = std::get<1>(bpftrace.resources.cat_args[id]);
-  auto arg_values = bpftrace.get_arg_values(out, args, arg_data);
+  auto arg_values = bpftrace.get_arg_values(out, args, arg_data, size);
 
   std::stringstream buf;
   util::cat_file(fmt.format_str(arg_values).c_str(),
@@ -232,15 +273,44 @@ void AsyncHandlers::cat(AsyncAction printf_id, uint8_t *arg_data)
   out.message(MessageType::cat, buf.str(), false);
 }
 
-void AsyncHandlers::printf(AsyncAction printf_id, uint8_t *arg_data)
+void AsyncHandlers::printf(AsyncAction printf_id,
+                           uint8_t *arg_data,
+                           size_t size)
 {
   auto id = static_cast<size_t>(printf_id) -
             static_cast<size_t>(AsyncAction::printf);
   auto &fmt = std::get<0>(bpftrace.resources.printf_args[id]);
   auto &args = std::get<1>(bpftrace.resources.printf_args[id]);
-  auto arg_values = bpftrace.get_arg_values(out, args, arg_data);
 
-  out.message(MessageType::printf, fmt.format_str(arg_values), false);
+  auto &pool = bpftrace.symbolizer_pool_;
+  if (!pool) {
+    auto arg_values = bpftrace.get_arg_values(out, args, arg_data, size);
+    out.message(MessageType::printf, fmt.format_str(arg_values), false);
+    return;
+  }
+
+  // Symbols are resolved by the pool's workers, formatting and output stay
+  // on this thread.
+  auto deferred = std::make_shared<std::vector<DeferredArg>>();
+  auto arg_values = std::make_shared<std::vector<std::unique_ptr<IPrintable>>>(
+      bpftrace.get_arg_values(out, args, arg_data, size, deferred.get()));
+  auto emit = [this, &fmt, arg_values] {
+    out.message(MessageType::printf, fmt.format_str(*arg_values), false);
+  };
+  if (deferred->empty()) {
+    if (pool->empty())
+      emit();
+    else
+      pool->submit(nullptr, std::move(emit));
+    return;
+  }
+  pool->submit(
+      [deferred, arg_values](Ksyms &ksyms, Usyms &usyms) {
+        for (const auto &arg : *deferred)
+          (*arg_values)[arg.index] = std::make_unique<PrintableString>(
+              arg.resolve(ksyms, usyms));
+      },
+      std::move(emit));
 }
 
 } // namespace bpftrace::async_action
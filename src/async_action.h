@@ -36,7 +36,7 @@ public:
       : bpftrace(bpftrace), out(output) {};
 
   void exit(const void *data);
-  void join(const void *data);
+  void join(const void *data, size_t size);
   void time(const void *data);
   void helper_error(const void *data);
   void print_non_map(const void *data);
@@ -46,11 +46,13 @@ public:
   void watchpoint_attach(const void *data);
   void watchpoint_detach(const void *data);
   void skboutput(void *data, int size);
-  void syscall(AsyncAction printf_id, uint8_t *arg_data);
-  void cat(AsyncAction printf_id, uint8_t *arg_data);
-  void printf(AsyncAction printf_id, uint8_t *arg_data);
+  void syscall(AsyncAction printf_id, uint8_t *arg_data, size_t size);
+  void cat(AsyncAction printf_id, uint8_t *arg_data, size_t size);
+  void printf(AsyncAction printf_id, uint8_t *arg_data, size_t size);
 
 private:
+  bool is_topk_map(const BpfMap &map) const;
+
   BPFtrace &bpftrace;
   Output &out;
 };
@@ -3,6 +3,7 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <elf.h>
 #include <fcntl.h>
@@ -17,7 +18,6 @@
 #include <unistd.h>
 #include <utility>
 
-#include <bcc/bcc_elf.h>
 #include <bcc/bcc_syms.h>
 #include <bcc/bcc_usdt.h>
 #include <bpf/bpf.h>
@@ -28,6 +28,7 @@
 #include "disasm.h"
 #include "log.h"
 #include "probe_matcher.h"
+#include "scopeguard.h"
 #include "usdt.h"
 #include "util/bpf_names.h"
 #include "util/cpus.h"
@@ -273,21 +274,21 @@ Result<> check_alignment(Probe &probe,
 
 Result<uint64_t> resolve_offset_uprobe(Probe &probe, bool safe_mode)
 {
-  struct bcc_symbol_option option = {};
-  struct symbol sym = {};
   std::string &symbol = probe.attach_point;
   uint64_t func_offset = probe.func_offset;
+  uint64_t sym_addr = 0;
+  uint64_t sym_size = 0;
 
-  sym.name = "";
-  option.use_debug_file = 1;
-  option.use_symbol_type = BCC_SYM_ALL_TYPES ^ (1 << STT_NOTYPE);
+  // All uprobes on the same binary share the index, so its symbols and
+  // sections are only read once.
+  auto index = util::ElfIndex::get(probe.path);
 
   if (symbol.empty()) {
-    sym.address = probe.address;
-    bcc_elf_foreach_sym(
-        probe.path.c_str(), util::sym_address_cb, &option, &sym);
+    std::optional<util::elf_symbol> sym;
+    if (index)
+      sym = index->lookup(probe.address);
 
-    if (!sym.start) {
+    if (!sym || !sym->start) {
       if (safe_mode) {
         std::stringstream ss;
         ss << "0x" << std::hex << probe.address;
@@ -302,16 +303,21 @@ Result<uint64_t> resolve_offset_uprobe(Probe &probe, bool safe_mode)
       }
     }
 
-    symbol = sym.name;
-    func_offset = probe.address - sym.start;
+    symbol = sym->name;
+    sym_addr = sym->start;
+    sym_size = sym->end - sym->start;
+    func_offset = probe.address - sym->start;
   } else {
-    sym.name = symbol;
-    bcc_elf_foreach_sym(probe.path.c_str(), util::sym_name_cb, &option, &sym);
+    std::optional<util::elf_symbol> sym;
+    if (index)
+      sym = index->find(symbol);
 
-    if (!sym.start) {
+    if (!sym || !sym->start) {
       return make_error<AttachError>("Could not resolve symbol: " + probe.path +
                                      ":" + symbol);
     }
+    sym_addr = sym->start;
+    sym_size = sym->end - sym->start;
   }
 
   if (probe.type == ProbeType::uretprobe && func_offset != 0) {
@@ -321,10 +327,10 @@ Result<uint64_t> resolve_offset_uprobe(Probe &probe, bool safe_mode)
                                    ")");
   }
 
-  if (sym.size == 0 && func_offset == 0) {
+  if (sym_size == 0 && func_offset == 0) {
     if (safe_mode) {
       std::stringstream msg;
-      msg << "Could not determine boundary for " << sym.name
+      msg << "Could not determine boundary for " << symbol
           << " (symbol has size 0).";
       if (probe.orig_name == probe.name) {
         msg << hint_unsafe;
@@ -334,15 +340,16 @@ Result<uint64_t> resolve_offset_uprobe(Probe &probe, bool safe_mode)
       }
       return make_error<AttachError>();
     }
-  } else if (func_offset >= sym.size) {
+  } else if (func_offset >= sym_size) {
     return make_error<AttachError>("Offset outside the function bounds ('" +
                                    symbol + "' size is " +
-                                   std::to_string(sym.size) + ")");
+                                   std::to_string(sym_size) + ")");
   }
 
-  auto sym_offset = resolve_offset(probe);
+  auto sym_offset = index->file_offset(sym_addr);
   if (!sym_offset) {
-    return sym_offset.takeError();
+    return make_error<AttachError>("Could not resolve symbol: " + probe.path +
+                                   ":" + symbol);
   }
 
   uint64_t offset = *sym_offset + func_offset;
@@ -363,54 +370,11 @@ Result<uint64_t> resolve_offset_uprobe(Probe &probe, bool safe_mode)
 }
 
 #ifdef HAVE_LIBBPF_UPROBE_MULTI
-struct bcc_sym_cb_data {
-  std::vector<std::string> &syms;
-  std::set<uint64_t> &offsets;
-};
-
-static int bcc_sym_cb(const char *symname,
-                      uint64_t start,
-                      uint64_t /*unused*/,
-                      void *p)
-{
-  auto *data = static_cast<struct bcc_sym_cb_data *>(p);
-  std::vector<std::string> &syms = data->syms;
-
-  if (std::ranges::binary_search(syms, symname)) {
-    data->offsets.insert(start);
-  }
-
-  return 0;
-}
-
-struct addr_offset {
-  uint64_t addr;
-  uint64_t offset;
-};
-
-static int bcc_load_cb(uint64_t v_addr,
-                       uint64_t mem_sz,
-                       uint64_t file_offset,
-                       void *p)
-{
-  auto *addrs = static_cast<std::vector<struct addr_offset> *>(p);
-
-  for (auto &a : *addrs) {
-    if (a.addr >= v_addr && a.addr < (v_addr + mem_sz)) {
-      a.offset = a.addr - v_addr + file_offset;
-    }
-  }
-
-  return 0;
-}
-
 Result<std::vector<unsigned long>> resolve_offsets_uprobe_multi(
     Probe &probe,
     std::vector<std::string> &syms)
 {
   std::vector<unsigned long> offsets;
-  struct bcc_symbol_option option = {};
-  int err;
 
   // Parse symbols names into syms vector
   for (const std::string &func : probe.funcs) {
@@ -425,41 +389,28 @@ Result<std::vector<unsigned long>> resolve_offsets_uprobe_multi(
 
   std::ranges::sort(syms);
 
-  option.use_debug_file = 1;
-  option.use_symbol_type = BCC_SYM_ALL_TYPES ^ (1 << STT_NOTYPE);
-
-  std::vector<struct addr_offset> addrs;
-  std::set<uint64_t> set;
-  struct bcc_sym_cb_data data = {
-    .syms = syms,
-    .offsets = set,
-  };
-
-  // Resolve symbols into addresses
-  err = bcc_elf_foreach_sym(probe.path.c_str(), bcc_sym_cb, &option, &data);
-  if (err) {
+  auto index = util::ElfIndex::get(probe.path);
+  if (!index) {
     return make_error<AttachError>("Failed to list symbols for probe: " +
                                    probe.name);
   }
 
-  for (auto a : set) {
-    struct addr_offset addr = {
-      .addr = a,
-      .offset = 0x0,
-    };
-
-    addrs.push_back(addr);
+  // Resolve symbols into addresses. There can be several symbols with the
+  // same name, attach to all of them.
+  std::set<uint64_t> addrs;
+  for (const auto &sym_name : syms) {
+    for (const auto &sym : index->find_all(sym_name))
+      addrs.insert(sym.start);
   }
 
   // Translate addresses into offsets
-  err = bcc_elf_foreach_load_section(probe.path.c_str(), bcc_load_cb, &addrs);
-  if (err) {
-    return make_error<AttachError>(
-        "Failed to resolve symbols offsets for probe: " + probe.name);
-  }
-
-  for (auto a : addrs) {
-    offsets.push_back(a.offset);
+  for (auto addr : addrs) {
+    auto offset = index->file_offset(addr);
+    if (!offset) {
+      return make_error<AttachError>(
+          "Failed to resolve symbols offsets for probe: " + probe.name);
+    }
+    offsets.push_back(*offset);
   }
 
   return offsets;
@@ -637,6 +588,7 @@ public:
       Probe &probe,
       const BpfProgram &prog,
       std::optional<int> pid,
+      BPFtrace &bpftrace,
       bool safe_mode);
   ~AttachedUprobeProbe() override;
 
@@ -670,9 +622,13 @@ Result<std::unique_ptr<AttachedUprobeProbe>> AttachedUprobeProbe::make(
     Probe &probe,
     const BpfProgram &prog,
     std::optional<int> pid,
+    BPFtrace &bpftrace,
     bool safe_mode)
 {
+  auto start = std::chrono::steady_clock::now();
   auto offset_res = resolve_offset_uprobe(probe, safe_mode);
+  bpftrace.uprobe_resolve_stats_.add(1,
+                                     std::chrono::steady_clock::now() - start);
   if (!offset_res) {
     return offset_res.takeError();
   }
@@ -700,7 +656,8 @@ public:
   static Result<std::unique_ptr<AttachedMultiUprobeProbe>> make(
       Probe &probe,
       const BpfProgram &prog,
-      std::optional<int> pid);
+      std::optional<int> pid,
+      BPFtrace &bpftrace);
   ~AttachedMultiUprobeProbe() override;
 
   size_t probe_count() const override;
@@ -728,13 +685,19 @@ size_t AttachedMultiUprobeProbe::probe_count() const
 
 #ifdef HAVE_LIBBPF_UPROBE_MULTI
 Result<std::unique_ptr<AttachedMultiUprobeProbe>> AttachedMultiUprobeProbe::
-    make(Probe &probe, const BpfProgram &prog, std::optional<int> pid)
+    make(Probe &probe,
+         const BpfProgram &prog,
+         std::optional<int> pid,
+         BPFtrace &bpftrace)
 {
   std::vector<std::string> syms;
   unsigned int i;
 
   // Resolve probe_.funcs into offsets and syms vector
+  auto start = std::chrono::steady_clock::now();
   auto offset_res = resolve_offsets_uprobe_multi(probe, syms);
+  bpftrace.uprobe_resolve_stats_.add(probe.funcs.size(),
+                                     std::chrono::steady_clock::now() - start);
   if (!offset_res) {
     return offset_res.takeError();
   }
@@ -774,7 +737,10 @@ Result<std::unique_ptr<AttachedMultiUprobeProbe>> AttachedMultiUprobeProbe::
 }
 #else
 Result<std::unique_ptr<AttachedMultiUprobeProbe>> AttachedMultiUprobeProbe::
-    make(Probe &probe, const BpfProgram &prog, std::optional<int> pid)
+    make(Probe &probe,
+         const BpfProgram &prog,
+         std::optional<int> pid,
+         BPFtrace &bpftrace)
 {
   return make_error<AttachError>("uprobe multi not available on this system");
 }
@@ -939,7 +905,8 @@ int open_perf_event(uint32_t ev_type,
                     uint64_t sample_freq,
                     pid_t pid,
                     int cpu,
-                    int group_fd)
+                    int group_fd,
+                    int cgroup_fd = -1)
 {
   if (sample_period > 0 && sample_freq > 0) {
     LOG(BUG) << "Exactly one of sample_period / sample_freq should be set";
@@ -956,11 +923,30 @@ int open_perf_event(uint32_t ev_type,
   } else {
     attr.sample_period = sample_period;
   }
-  if (pid > 0)
+  unsigned long flags = PERF_FLAG_FD_CLOEXEC;
+  if (pid > 0) {
     attr.inherit = 1;
+  } else if (cgroup_fd >= 0) {
+    // A per-CPU event in a cgroup is only active while a task of the cgroup
+    // (or of its descendants) runs on that CPU, so the program does not even
+    // run for other tasks.
+    pid = cgroup_fd;
+    flags |= PERF_FLAG_PID_CGROUP;
+  }
 
-  return syscall(
-      __NR_perf_event_open, &attr, pid, cpu, group_fd, PERF_FLAG_FD_CLOEXEC);
+  return syscall(__NR_perf_event_open, &attr, pid, cpu, group_fd, flags);
+}
+
+// Opens the --cgroup directory for perf_event_open(), if there is one.
+static Result<int> open_cgroup(const std::optional<CgroupFilter> &cgroup)
+{
+  if (!cgroup)
+    return -1;
+  int fd = open(cgroup->path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0)
+    return make_error<AttachError>("failed to open cgroup " + cgroup->path +
+                                   ": " + strerror(errno));
+  return fd;
 }
 
 class AttachedProfileProbe : public AttachedProbe {
@@ -968,7 +954,8 @@ public:
   static Result<std::unique_ptr<AttachedProfileProbe>> make(
       Probe &probe,
       const BpfProgram &prog,
-      std::optional<int> pid);
+      std::optional<int> pid,
+      const std::optional<CgroupFilter> &cgroup);
   ~AttachedProfileProbe() override;
 
 private:
@@ -995,9 +982,18 @@ AttachedProfileProbe::~AttachedProfileProbe()
 Result<std::unique_ptr<AttachedProfileProbe>> AttachedProfileProbe::make(
     Probe &probe,
     const BpfProgram &prog,
-    std::optional<int> pid)
+    std::optional<int> pid,
+    const std::optional<CgroupFilter> &cgroup)
 {
   int group_fd = -1;
+  auto cgroup_fd = open_cgroup(cgroup);
+  if (!cgroup_fd)
+    return cgroup_fd.takeError();
+  SCOPE_EXIT
+  {
+    if (*cgroup_fd >= 0)
+      close(*cgroup_fd);
+  };
 
   uint64_t period, freq;
   if (probe.path == "hz") {
@@ -1027,7 +1023,8 @@ Result<std::unique_ptr<AttachedProfileProbe>> AttachedProfileProbe::make(
                                         freq,
                                         pid.has_value() ? *pid : -1,
                                         cpu,
-                                        group_fd);
+                                        group_fd,
+                                        *cgroup_fd);
 
     if (perf_event_fd < 0) {
       has_error = true;
@@ -1137,7 +1134,8 @@ public:
   static Result<std::unique_ptr<AttachedSoftwareProbe>> make(
       Probe &probe,
       const BpfProgram &prog,
-      std::optional<int> pid);
+      std::optional<int> pid,
+      const std::optional<CgroupFilter> &cgroup);
   ~AttachedSoftwareProbe() override;
 
 private:
@@ -1165,9 +1163,18 @@ AttachedSoftwareProbe::~AttachedSoftwareProbe()
 Result<std::unique_ptr<AttachedSoftwareProbe>> AttachedSoftwareProbe::make(
     Probe &probe,
     const BpfProgram &prog,
-    std::optional<int> pid)
+    std::optional<int> pid,
+    const std::optional<CgroupFilter> &cgroup)
 {
   int group_fd = -1;
+  auto cgroup_fd = open_cgroup(cgroup);
+  if (!cgroup_fd)
+    return cgroup_fd.takeError();
+  SCOPE_EXIT
+  {
+    if (*cgroup_fd >= 0)
+      close(*cgroup_fd);
+  };
 
   uint64_t period = probe.freq;
   uint64_t defaultp = 1;
@@ -1194,7 +1201,8 @@ Result<std::unique_ptr<AttachedSoftwareProbe>> AttachedSoftwareProbe::make(
                                         0,
                                         pid.has_value() ? *pid : -1,
                                         cpu,
-                                        group_fd);
+                                        group_fd,
+                                        *cgroup_fd);
 
     if (perf_event_fd < 0) {
       has_error = true;
@@ -1228,7 +1236,8 @@ public:
   static Result<std::unique_ptr<AttachedHardwareProbe>> make(
       Probe &probe,
       const BpfProgram &prog,
-      std::optional<int> pid);
+      std::optional<int> pid,
+      const std::optional<CgroupFilter> &cgroup);
   ~AttachedHardwareProbe() override;
 
 private:
@@ -1256,9 +1265,18 @@ AttachedHardwareProbe::~AttachedHardwareProbe()
 Result<std::unique_ptr<AttachedHardwareProbe>> AttachedHardwareProbe::make(
     Probe &probe,
     const BpfProgram &prog,
-    std::optional<int> pid)
+    std::optional<int> pid,
+    const std::optional<CgroupFilter> &cgroup)
 {
   int group_fd = -1;
+  auto cgroup_fd = open_cgroup(cgroup);
+  if (!cgroup_fd)
+    return cgroup_fd.takeError();
+  SCOPE_EXIT
+  {
+    if (*cgroup_fd >= 0)
+      close(*cgroup_fd);
+  };
 
   uint64_t period = probe.freq;
   uint64_t defaultp = 1000000;
@@ -1285,7 +1303,8 @@ Result<std::unique_ptr<AttachedHardwareProbe>> AttachedHardwareProbe::make(
                                         0,
                                         pid.has_value() ? *pid : -1,
                                         cpu,
-                                        group_fd);
+                                        group_fd,
+                                        *cgroup_fd);
 
     if (perf_event_fd < 0) {
       has_error = true;
@@ -1593,16 +1612,25 @@ Result<std::unique_ptr<AttachedProbe>> AttachedProbe::make(
       return AttachedTracepointProbe::make(probe, prog);
     }
     case ProbeType::profile: {
-      return AttachedProfileProbe::make(probe, prog, pid);
+      return AttachedProfileProbe::make(probe,
+                                        prog,
+                                        pid,
+                                        bpftrace.cgroup_filter_);
     }
     case ProbeType::interval: {
       return AttachedIntervalProbe::make(probe, prog, pid);
     }
     case ProbeType::software: {
-      return AttachedSoftwareProbe::make(probe, prog, pid);
+      return AttachedSoftwareProbe::make(probe,
+                                         prog,
+                                         pid,
+                                         bpftrace.cgroup_filter_);
     }
     case ProbeType::hardware: {
-      return AttachedHardwareProbe::make(probe, prog, pid);
+      return AttachedHardwareProbe::make(probe,
+                                         prog,
+                                         pid,
+                                         bpftrace.cgroup_filter_);
     }
     case ProbeType::fentry:
     case ProbeType::fexit: {
@@ -1624,9 +1652,9 @@ Result<std::unique_ptr<AttachedProbe>> AttachedProbe::make(
     case ProbeType::uprobe:
     case ProbeType::uretprobe: {
       if (!probe.funcs.empty()) {
-        return AttachedMultiUprobeProbe::make(probe, prog, pid);
+        return AttachedMultiUprobeProbe::make(probe, prog, pid, bpftrace);
       }
-      return AttachedUprobeProbe::make(probe, prog, pid, safe_mode);
+      return AttachedUprobeProbe::make(probe, prog, pid, bpftrace, safe_mode);
     }
     case ProbeType::invalid:
     case ProbeType::special: {
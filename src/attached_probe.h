@@ -1,6 +1,7 @@
 #pragma once
 
 #include <bcc/libbpf.h>
+#include <chrono>
 #include <functional>
 #include <string>
 #include <vector>
@@ -33,6 +34,18 @@ private:
   std::string msg_;
 };
 
+// Time spent translating uprobe attach points into file offsets.
+struct UprobeResolveStats {
+  size_t count = 0;
+  std::chrono::nanoseconds time{ 0 };
+
+  void add(size_t probes, std::chrono::nanoseconds duration)
+  {
+    count += probes;
+    time += duration;
+  }
+};
+
 class AttachedProbe {
 public:
   static Result<std::unique_ptr<AttachedProbe>> make(Probe &probe,
@@ -1,14 +1,32 @@
+#include <array>
+#include <bpf/bpf.h>
 #include <chrono>
 #include <cmath>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <random>
 #include <sstream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
 
 #include "ast/ast.h"
 #include "ast/context.h"
+#include "ast/passes/codegen_llvm.h"
+#include "ast/passes/link.h"
 #include "ast/passes/printer.h"
+#include "attached_probe.h"
 #include "benchmark.h"
+#include "bpftrace.h"
+#include "child.h"
+#include "scopeguard.h"
+#include "util/cgroup.h"
+#include "util/paths.h"
+#include "util/strings.h"
+#include "util/temp.h"
 
 namespace bpftrace {
 
@@ -18,6 +36,12 @@ void TimerError::log(llvm::raw_ostream &OS) const
   OS << "timer error: " << strerror(err_);
 }
 
+char BenchmarkError::ID;
+void BenchmarkError::log(llvm::raw_ostream &OS) const
+{
+  OS << msg_;
+}
+
 using time_point = std::chrono::time_point<std::chrono::steady_clock,
                                            std::chrono::nanoseconds>;
 
@@ -38,41 +62,237 @@ static int64_t delta(time_point start, time_point end)
       .count();
 }
 
-Result<> benchmark(std::ostream &out, ast::PassManager &mgr)
+// The peak resident set size of the process, in KiB.
+static Result<int64_t> peak_rss()
+{
+  struct rusage usage = {};
+  if (getrusage(RUSAGE_SELF, &usage) < 0) {
+    return make_error<BenchmarkError>(std::string("getrusage: ") +
+                                      strerror(errno));
+  }
+  return usage.ru_maxrss;
+}
+
+// We print out the confidence interval at p95, which corresponds to a
+// z-score of 1.96 (see the `err` value below).
+void BenchmarkReport::add(const std::string &name,
+                          int64_t total,
+                          int64_t count,
+                          double variance)
+{
+  size_t mean = total / count;
+  auto stddev = std::sqrt(variance);
+  auto err = static_cast<int64_t>(1.96 * stddev /
+                                  std::sqrt(static_cast<double>(count)));
+  if (json_) {
+    std::ostringstream entry;
+    entry << R"({"name": ")" << util::json_escape(name) << R"(", "count": )"
+          << count << R"(, "total_ns": )" << total << R"(, "mean_ns": )"
+          << mean << R"(, "ci95_ns": )" << err << "}";
+    entries_.push_back(entry.str());
+    return;
+  }
+
+  std::string unit = "ns";
+  if (mean > 10000000) {
+    unit = "ms";
+    mean /= 1000000;
+    err /= 1000000;
+  } else if (mean > 10000) {
+    unit = "μs";
+    mean /= 1000;
+    err /= 1000;
+  }
+  out_ << std::left << std::setw(30) << name;
+  out_ << std::left << std::setw(8) << count;
+  out_ << std::left << std::setw(14) << total;
+  out_ << mean << " ± " << err << " " << unit << std::endl;
+}
+
+void BenchmarkReport::add_samples(const std::string &name,
+                                  const std::vector<int64_t> &samples)
+{
+  int64_t total = 0;
+  for (const auto &sample : samples) {
+    total += sample;
+  }
+  int64_t mean = total / samples.size();
+  double variance = 0;
+  for (const auto &sample : samples) {
+    variance += std::pow(static_cast<double>(sample - mean), 2);
+  }
+  add(name, total, samples.size(), variance);
+}
+
+void BenchmarkReport::add_empty(const std::string &name)
+{
+  if (json_)
+    entries_.push_back(R"({"name": ")" + util::json_escape(name) +
+                       R"(", "count": 0})");
+  else
+    out_ << std::left << std::setw(30) << name << "no samples" << std::endl;
+}
+
+void BenchmarkReport::add_value(const std::string &name,
+                                int64_t value,
+                                const std::string &unit)
+{
+  if (json_)
+    entries_.push_back(R"({"name": ")" + util::json_escape(name) +
+                       R"(", "value": )" + std::to_string(value) +
+                       R"(, "unit": ")" + util::json_escape(unit) + "\"}");
+  else
+    out_ << std::left << std::setw(30) << name << value << " " << unit
+         << std::endl;
+}
+
+void BenchmarkReport::finish(bool pass)
+{
+  if (!json_) {
+    out_ << (pass ? "PASS\n" : "FAIL\n");
+    return;
+  }
+  out_ << R"({"status": ")" << (pass ? "PASS" : "FAIL")
+       << R"(", "results": [)";
+  for (size_t i = 0; i < entries_.size(); i++)
+    out_ << (i ? ",\n  " : "\n  ") << entries_[i];
+  out_ << "\n]}" << std::endl;
+  entries_.clear();
+}
+
+using wall_clock = std::chrono::steady_clock;
+
+static int64_t wall_delta(wall_clock::time_point start,
+                          wall_clock::time_point end)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+      .count();
+}
+
+// libbpf creates the maps as part of loading the programs. To tell the two
+// apart, maps with the same definitions as the loaded ones are created (and
+// closed again) on their own.
+static void create_maps_like(const BpfBytecode &bytecode)
+{
+  for (const auto &[_, map] : bytecode.maps()) {
+    struct bpf_map_info info = {};
+    uint32_t info_len = sizeof(info);
+    if (map.fd() < 0 ||
+        bpf_map_get_info_by_fd(map.fd(), &info, &info_len) != 0)
+      continue;
+    LIBBPF_OPTS(bpf_map_create_opts, opts, .map_flags = info.map_flags);
+    int fd = bpf_map_create(static_cast<enum bpf_map_type>(info.type),
+                            nullptr,
+                            info.key_size,
+                            info.value_size,
+                            info.max_entries,
+                            &opts);
+    if (fd >= 0)
+      close(fd);
+  }
+}
+
+// Measures the startup stages after code generation. Every round opens and
+// loads the object again, attaches all probes and detaches them at the end.
+// These are wall clock times, as the kernel may sleep, e.g. while attaching.
+static Result<> benchmark_startup(BenchmarkReport &report,
+                                  BPFtrace &bpftrace,
+                                  ast::BpfObject &obj)
+{
+  auto named_param_vals = bpftrace.resources.global_vars.get_named_param_vals(
+      {});
+  if (!named_param_vals)
+    return named_param_vals.takeError();
+
+  auto &probes = bpftrace.resources.probes;
+  std::vector<int64_t> open_samples, load_samples, maps_samples,
+      attach_samples;
+  std::vector<std::vector<int64_t>> probe_samples(probes.size());
+
+  // As for the passes, but loading large scripts is slow, so at most 100
+  // rounds.
+  int64_t goal = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::milliseconds(100))
+                     .count();
+  int64_t elapsed = 0;
+  while (load_samples.size() < 3 ||
+         (elapsed < goal && load_samples.size() < 100)) {
+    auto start = wall_clock::now();
+    BpfBytecode bytecode(obj.data);
+    auto opened = wall_clock::now();
+    bytecode.update_global_vars(bpftrace,
+                                globalvars::GlobalVarMap(*named_param_vals));
+    auto load_start = wall_clock::now();
+    if (bpftrace.load_bytecode(std::move(bytecode)) != 0)
+      return make_error<BenchmarkError>("cannot load programs");
+    auto loaded = wall_clock::now();
+    create_maps_like(bpftrace.bytecode_);
+    auto maps_created = wall_clock::now();
+
+    std::vector<std::unique_ptr<AttachedProbe>> attached;
+    int64_t attach_total = 0;
+    for (size_t i = 0; i < probes.size(); i++) {
+      auto attach_start = wall_clock::now();
+      auto ap = bpftrace.attach_probe(probes[i], bpftrace.bytecode_);
+      if (!ap)
+        return ap.takeError();
+      int64_t current = wall_delta(attach_start, wall_clock::now());
+      attached.push_back(std::move(*ap));
+      probe_samples[i].push_back(current);
+      attach_total += current;
+    }
+    attached.clear();
+
+    open_samples.push_back(wall_delta(start, opened));
+    load_samples.push_back(wall_delta(load_start, loaded));
+    maps_samples.push_back(wall_delta(loaded, maps_created));
+    attach_samples.push_back(attach_total);
+    elapsed += open_samples.back() + load_samples.back() + attach_total;
+  }
+
+  report.add_samples("startup/open", open_samples);
+  report.add_samples("startup/load", load_samples);
+  report.add_samples("startup/maps", maps_samples);
+  report.add_samples("startup/attach", attach_samples);
+  for (size_t i = 0; i < probes.size(); i++)
+    report.add_samples("attach/" + probes[i].name, probe_samples[i]);
+  return OK();
+}
+
+Result<> benchmark(BenchmarkReport &report,
+                   ast::PassManager &mgr,
+                   BPFtrace &bpftrace)
 {
   ast::PassContext ctx;
 
+  // Start with an empty cache, so that the first run of a pass that caches
+  // its results across runs, e.g. the clang parser, is cold and the following
+  // ones are warm. Nothing is cached if caching is disabled. The cache
+  // directory of the caller is restored afterwards.
+  std::optional<std::string> saved_cache_dir;
+  if (const char *dir = std::getenv("BPFTRACE_CACHE_DIR"))
+    saved_cache_dir = dir;
+  SCOPE_EXIT
+  {
+    if (saved_cache_dir)
+      ::setenv("BPFTRACE_CACHE_DIR", saved_cache_dir->c_str(), 1);
+    else
+      ::unsetenv("BPFTRACE_CACHE_DIR");
+  };
+  std::optional<util::TempDir> cache_dir;
+  if (util::get_cache_dir()) {
+    auto dir = util::TempDir::create();
+    if (!dir)
+      return dir.takeError();
+    ::setenv("BPFTRACE_CACHE_DIR", dir->path().c_str(), 1);
+    cache_dir.emplace(std::move(*dir));
+  }
+
   // See below; we aggregate at the end.
   int64_t full_mean = 0;
   double full_variance = 0;
   size_t full_count = 0;
 
-  // We print out the confidence interval at p95, which corresponds to a
-  // z-score of 1.96 (see the `err` value below).
-  auto emit = [&](const std::string &name,
-                  int64_t total,
-                  int64_t count,
-                  double variance) {
-    size_t mean = total / count;
-    auto stddev = std::sqrt(variance);
-    auto err = static_cast<int64_t>(1.96 * stddev /
-                                    std::sqrt(static_cast<double>(count)));
-    std::string unit = "ns";
-    if (mean > 10000000) {
-      unit = "ms";
-      mean /= 1000000;
-      err /= 1000000;
-    } else if (mean > 10000) {
-      unit = "μs";
-      mean /= 1000;
-      err /= 1000;
-    }
-    out << std::left << std::setw(30) << name;
-    out << std::left << std::setw(8) << count;
-    out << std::left << std::setw(14) << total;
-    out << mean << " ± " << err << " " << unit << std::endl;
-  };
-
   auto ok = mgr.foreach([&](auto &pass) -> Result<> {
     // Copy out the AST. We allow passes to mutate the AST, and therefore we
     // copy this out and reset it each time.
@@ -120,13 +340,19 @@ Result<> benchmark(std::ostream &out, ast::PassManager &mgr)
       ast.root = clone(ast, saved.root, ast::Location());
     }
 
+    // The first run is reported on its own, as it may be much slower than
+    // the others, e.g. when parsing headers that are cached afterwards.
+    report.add(pass.name() + "/first", samples.front(), 1, 0);
+    total -= samples.front();
+    samples.erase(samples.begin());
+
     // Compute the variance of the samples.
     int64_t mean = total / samples.size();
     double variance = 0;
     for (const auto &sample : samples) {
       variance += std::pow(static_cast<double>(sample - mean), 2);
     }
-    emit(pass.name(), total, samples.size(), variance);
+    report.add(pass.name(), total, samples.size(), variance);
 
     // Aggregate for printing the final stats. Note that we treat each pass as
     // independent, therefore the final variance is the sum of the variances.
@@ -136,15 +362,407 @@ Result<> benchmark(std::ostream &out, ast::PassManager &mgr)
     return OK();
   });
   if (!ok) {
-    out << "FAIL\n"; // See below.
+    report.fail(); // See below.
     return ok.takeError();
   }
 
   // The final `PASS` is emitted when all passes have finished correctly. This
   // makes the output format compatible with `gobench` or other aggregation
   // tools that can compare benchmarks.
-  emit("total", full_mean * full_count, full_count, full_variance);
-  out << "PASS\n";
+  report.add("total", full_mean * full_count, full_count, full_variance);
+
+  // Loading and attaching needs root. Objects linked with imported ones are
+  // only available after linking, which is not repeated here.
+  bool linked = ctx.has<ast::BpfExternObjects>() &&
+                !ctx.get<ast::BpfExternObjects>().objects.empty();
+  if (geteuid() == 0 && ctx.has<ast::BpfObject>() && !linked) {
+    auto ok = benchmark_startup(report, bpftrace, ctx.get<ast::BpfObject>());
+    if (!ok) {
+      report.fail();
+      return ok.takeError();
+    }
+  }
+
+  // Memory used by the AST and the passes, e.g. for large generated scripts.
+  auto rss = peak_rss();
+  if (!rss) {
+    return rss.takeError();
+  }
+  report.add_value("peak rss", *rss, "KiB");
+  report.pass();
+  return OK();
+}
+
+Result<> benchmark_ksyms(BenchmarkReport &report, Ksyms &ksyms)
+{
+  const auto *kallsyms = ksyms.kallsyms();
+  if (!kallsyms || kallsyms->size() == 0) {
+    report.fail();
+    return make_error<BenchmarkError>("cannot read kernel symbols");
+  }
+
+  // Addresses inside random kernel symbols, the same for all backends.
+  constexpr size_t naddrs = 10000;
+  std::mt19937_64 rng(0);
+  std::vector<uint64_t> addrs;
+  for (size_t i = 0; i < naddrs; i++)
+    addrs.push_back((*kallsyms)[rng() % kallsyms->size()].start + (rng() % 16));
+
+  std::vector<std::pair<std::string, Ksyms::Backend>> backends = {
+    { "kallsyms", Ksyms::Backend::kallsyms },
+    { "bcc", Ksyms::Backend::bcc },
+  };
+#ifdef HAVE_BLAZESYM
+  backends.emplace_back("blazesym", Ksyms::Backend::blazesym);
+#endif
+
+  // Each sample is the mean time of a single lookup over all addresses. As
+  // for the passes, we collect samples for at least 100 milliseconds.
+  int64_t goal = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::milliseconds(100))
+                     .count();
+  for (const auto &[name, backend] : backends) {
+    // The first round loads the backend's symbols.
+    auto start = processor_time();
+    if (!start)
+      return start.takeError();
+    for (auto addr : addrs)
+      ksyms.resolve(backend, addr, true, false, false);
+    auto end = processor_time();
+    if (!end)
+      return end.takeError();
+    report.add("ksyms/" + name + "/first", delta(*start, *end), 1, 0);
+
+    std::vector<int64_t> samples;
+    int64_t total = 0;
+    int64_t elapsed = 0;
+    while (samples.size() < 3 || elapsed < goal) {
+      start = processor_time();
+      if (!start)
+        return start.takeError();
+      for (auto addr : addrs)
+        ksyms.resolve(backend, addr, true, false, false);
+      end = processor_time();
+      if (!end)
+        return end.takeError();
+      int64_t current = delta(*start, *end);
+      elapsed += current;
+      samples.push_back(current / static_cast<int64_t>(naddrs));
+      total += samples.back();
+    }
+
+    int64_t mean = total / samples.size();
+    double variance = 0;
+    for (const auto &sample : samples) {
+      variance += std::pow(static_cast<double>(sample - mean), 2);
+    }
+    report.add("ksyms/" + name + "/lookup", total, samples.size(), variance);
+  }
+
+  report.pass();
+  return OK();
+}
+
+Result<> benchmark_cgroup(BenchmarkReport &report, BPFtrace &bpftrace)
+{
+  auto roots = util::get_cgroup_hierarchy_roots();
+  if (roots[1].empty()) {
+    report.fail();
+    return make_error<BenchmarkError>("no cgroup2 hierarchy is mounted");
+  }
+  const std::string scratch = roots[1].front() + "/bpftrace-benchmark-" +
+                              std::to_string(getpid());
+  if (mkdir(scratch.c_str(), 0755) < 0) {
+    report.fail();
+    return make_error<BenchmarkError>("cannot create " + scratch + ": " +
+                                      strerror(errno));
+  }
+
+  // Each round creates new cgroups and removes those of the previous round,
+  // like containers coming and going. Samples are the mean time of a single
+  // lookup within a round.
+  constexpr size_t ncgroups = 1000;
+  std::vector<std::string> live;
+  SCOPE_EXIT
+  {
+    for (const auto &path : live)
+      rmdir(path.c_str());
+    rmdir(scratch.c_str());
+  };
+
+  bpftrace.resources.cgroup_path_args.emplace_back("unified");
+  const uint64_t path_id = bpftrace.resources.cgroup_path_args.size() - 1;
+  auto resolve_all = [&](const std::vector<uint64_t> &ids) -> Result<int64_t> {
+    auto start = processor_time();
+    if (!start)
+      return start.takeError();
+    for (auto id : ids)
+      bpftrace.resolve_cgroup_path(path_id, id);
+    auto end = processor_time();
+    if (!end)
+      return end.takeError();
+    return delta(*start, *end) / static_cast<int64_t>(ids.size());
+  };
+
+  int64_t goal = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::milliseconds(100))
+                     .count();
+  std::vector<int64_t> new_samples, cached_samples, removed_samples;
+  std::vector<uint64_t> removed;
+  int64_t elapsed = 0;
+  for (size_t round = 0; new_samples.size() < 3 || elapsed < goal; round++) {
+    std::vector<std::string> created;
+    std::vector<uint64_t> ids;
+    for (size_t i = 0; i < ncgroups; i++) {
+      auto path = scratch + "/" + std::to_string(round) + "-" +
+                  std::to_string(i);
+      if (mkdir(path.c_str(), 0755) < 0) {
+        report.fail();
+        return make_error<BenchmarkError>("cannot create " + path + ": " +
+                                          strerror(errno));
+      }
+      created.push_back(path);
+      ids.push_back(util::resolve_cgroupid(path));
+    }
+    for (const auto &path : live)
+      rmdir(path.c_str());
+    live = std::move(created);
+
+    auto new_time = resolve_all(ids);
+    if (!new_time)
+      return new_time.takeError();
+    auto cached_time = resolve_all(ids);
+    if (!cached_time)
+      return cached_time.takeError();
+    new_samples.push_back(*new_time);
+    cached_samples.push_back(*cached_time);
+    elapsed += (*new_time + *cached_time) * ncgroups;
+
+    if (!removed.empty()) {
+      auto removed_time = resolve_all(removed);
+      if (!removed_time)
+        return removed_time.takeError();
+      removed_samples.push_back(*removed_time);
+    }
+    removed = std::move(ids);
+  }
+
+  report.add_samples("cgroup/new", new_samples);
+  report.add_samples("cgroup/cached", cached_samples);
+  report.add_samples("cgroup/removed", removed_samples);
+  report.pass();
+  return OK();
+}
+
+namespace {
+
+struct RunStats {
+  uint64_t cnt = 0;
+  uint64_t time_ns = 0;
+};
+
+Result<RunStats> run_stats(int fd)
+{
+  struct bpf_prog_info info = {};
+  uint32_t info_len = sizeof(info);
+  if (bpf_obj_get_info_by_fd(fd, &info, &info_len) != 0) {
+    return make_error<BenchmarkError>(std::string("bpf_obj_get_info_by_fd: ") +
+                                      strerror(errno));
+  }
+  return RunStats{ .cnt = info.run_cnt, .time_ns = info.run_time_ns };
+}
+
+struct BenchProg {
+  std::string name;
+  int fd;
+  std::vector<int64_t> samples;
+};
+
+} // namespace
+
+// Drives a program with BPF_PROG_TEST_RUN. Each sample is the mean time of a
+// single invocation within a batch, as counted by the kernel.
+static Result<> test_run_prog(BenchProg &prog)
+{
+  // Synthetic context: the arguments of a raw tracepoint, all zero.
+  std::array<uint64_t, 12> ctx = {};
+  constexpr int batch = 1000;
+  // Only some program types support repeat, the others are run in a loop.
+  bool use_repeat = true;
+  auto run_batch = [&]() -> Result<> {
+    if (use_repeat) {
+      LIBBPF_OPTS(bpf_test_run_opts,
+                  opts,
+                  .ctx_in = ctx.data(),
+                  .ctx_size_in = sizeof(ctx),
+                  .repeat = batch);
+      if (bpf_prog_test_run_opts(prog.fd, &opts) == 0)
+        return OK();
+      use_repeat = false;
+    }
+    for (int i = 0; i < batch; i++) {
+      LIBBPF_OPTS(bpf_test_run_opts,
+                  opts,
+                  .ctx_in = ctx.data(),
+                  .ctx_size_in = sizeof(ctx));
+      if (bpf_prog_test_run_opts(prog.fd, &opts) != 0) {
+        return make_error<BenchmarkError>("cannot run " + prog.name + ": " +
+                                          strerror(errno));
+      }
+    }
+    return OK();
+  };
+
+  int64_t goal = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::milliseconds(100))
+                     .count();
+  int64_t elapsed = 0;
+  while (prog.samples.size() < 3 || elapsed < goal) {
+    auto before = run_stats(prog.fd);
+    if (!before)
+      return before.takeError();
+    auto start = processor_time();
+    if (!start)
+      return start.takeError();
+    auto ok = run_batch();
+    if (!ok)
+      return ok.takeError();
+    auto end = processor_time();
+    if (!end)
+      return end.takeError();
+    auto after = run_stats(prog.fd);
+    if (!after)
+      return after.takeError();
+
+    elapsed += delta(*start, *end);
+    if (after->cnt == before->cnt) {
+      return make_error<BenchmarkError>("no run time statistics for " +
+                                        prog.name);
+    }
+    prog.samples.push_back((after->time_ns - before->time_ns) /
+                           (after->cnt - before->cnt));
+    if (prog.samples.size() >= 10000)
+      break;
+  }
+  return OK();
+}
+
+Result<> benchmark_probes(BenchmarkReport &report,
+                          BPFtrace &bpftrace,
+                          BpfBytecode &bytecode,
+                          std::vector<std::string> &&named_params)
+{
+  // Run time statistics are counted for as long as this fd is open.
+  int stats_fd = bpf_enable_stats(BPF_STATS_RUN_TIME);
+  if (stats_fd < 0) {
+    report.fail();
+    return make_error<BenchmarkError>(
+        std::string("cannot enable BPF run time statistics: ") +
+        strerror(errno));
+  }
+  SCOPE_EXIT
+  {
+    close(stats_fd);
+  };
+
+  auto named_param_vals = bpftrace.resources.global_vars.get_named_param_vals(
+      named_params);
+  if (!named_param_vals) {
+    report.fail();
+    return named_param_vals.takeError();
+  }
+  bytecode.update_global_vars(bpftrace, std::move(*named_param_vals));
+  if (bpftrace.load_bytecode(std::move(bytecode))) {
+    report.fail();
+    return make_error<BenchmarkError>("cannot load programs");
+  }
+
+  // Probes that bpftrace itself triggers (BEGIN, END and self probes) can be
+  // run directly. Nothing reads their output, so once the ring buffer is full
+  // this measures dropping events rather than emitting them.
+  std::vector<BenchProg> test_run;
+  for (const auto &[_, probe] : bpftrace.resources.special_probes) {
+    int fd = bpftrace.bytecode_.getProgramForProbe(probe).fd();
+    test_run.push_back(
+        BenchProg{ .name = probe.orig_name, .fd = fd, .samples = {} });
+  }
+  for (const auto &probe : bpftrace.resources.signal_probes) {
+    int fd = bpftrace.bytecode_.getProgramForProbe(probe).fd();
+    test_run.push_back(
+        BenchProg{ .name = probe.orig_name, .fd = fd, .samples = {} });
+  }
+  for (auto &prog : test_run) {
+    auto ok = test_run_prog(prog);
+    if (!ok) {
+      report.fail();
+      return ok.takeError();
+    }
+    report.add_samples(prog.name, prog.samples);
+  }
+
+  // All other probes are attached and measured while their events happen,
+  // in windows of 100 milliseconds for one second or, with -c, until the
+  // command exits. Probes expanded from a wildcard share a program.
+  std::vector<BenchProg> attached;
+  std::unordered_set<int> seen;
+  std::vector<std::unique_ptr<AttachedProbe>> attached_probes;
+  for (auto &probe : bpftrace.resources.probes) {
+    auto ap = bpftrace.attach_probe(probe, bpftrace.bytecode_);
+    if (!ap) {
+      report.fail();
+      return ap.takeError();
+    }
+    attached_probes.push_back(std::move(*ap));
+    int fd = bpftrace.bytecode_.getProgramForProbe(probe).fd();
+    if (seen.insert(fd).second)
+      attached.push_back(
+          BenchProg{ .name = probe.orig_name, .fd = fd, .samples = {} });
+  }
+
+  // Totals over the whole run, for comparing how often probes fire, e.g. with
+  // and without --cgroup.
+  std::vector<RunStats> first(attached.size());
+  std::vector<RunStats> last(attached.size());
+  if (!attached.empty()) {
+    auto &child = bpftrace.child_;
+    if (child)
+      child->run();
+    const auto window = std::chrono::milliseconds(100);
+    for (size_t i = 0; i < attached.size(); i++) {
+      auto stats = run_stats(attached[i].fd);
+      if (!stats)
+        return stats.takeError();
+      first[i] = last[i] = *stats;
+    }
+    for (int round = 0; child ? child->is_alive() : round < 10; round++) {
+      std::this_thread::sleep_for(window);
+      for (size_t i = 0; i < attached.size(); i++) {
+        auto stats = run_stats(attached[i].fd);
+        if (!stats)
+          return stats.takeError();
+        if (stats->cnt > last[i].cnt) {
+          attached[i].samples.push_back((stats->time_ns - last[i].time_ns) /
+                                        (stats->cnt - last[i].cnt));
+        }
+        last[i] = *stats;
+      }
+    }
+  }
+  for (size_t i = 0; i < attached.size(); i++) {
+    const auto &prog = attached[i];
+    if (prog.samples.empty())
+      report.add_empty(prog.name);
+    else
+      report.add_samples(prog.name, prog.samples);
+    report.add_value(prog.name + "/runs",
+                     static_cast<int64_t>(last[i].cnt - first[i].cnt),
+                     "runs");
+    report.add_value(prog.name + "/total",
+                     static_cast<int64_t>(last[i].time_ns - first[i].time_ns),
+                     "ns");
+  }
+
+  report.pass();
   return OK();
 }
 
@@ -1,12 +1,18 @@
 #pragma once
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "ast/pass_manager.h"
+#include "ksyms.h"
 #include "util/result.h"
 
 namespace bpftrace {
 
+class BPFtrace;
+class BpfBytecode;
+
 class TimerError : public ErrorInfo<TimerError> {
 public:
   TimerError(int err) : err_(err) {};
@@ -17,6 +23,75 @@ private:
   int err_;
 };
 
-Result<OK> benchmark(std::ostream &out, ast::PassManager &mgr);
+class BenchmarkError : public ErrorInfo<BenchmarkError> {
+public:
+  BenchmarkError(std::string msg) : msg_(std::move(msg)) {};
+  static char ID;
+  void log(llvm::raw_ostream &OS) const override;
+
+private:
+  std::string msg_;
+};
+
+// Collects the results of a benchmark. As text, every result is printed as
+// soon as it is added. As JSON, all results are printed together at the end,
+// as one object that can be compared with the report of another run.
+class BenchmarkReport {
+public:
+  BenchmarkReport(std::ostream &out, bool json) : out_(out), json_(json) {};
+
+  // Adds a timing of count runs, which took total nanoseconds together.
+  void add(const std::string &name,
+           int64_t total,
+           int64_t count,
+           double variance);
+  void add_samples(const std::string &name,
+                   const std::vector<int64_t> &samples);
+  // Adds a timing for which no runs could be measured.
+  void add_empty(const std::string &name);
+  // Adds a result that is not a timing, e.g. memory usage.
+  void add_value(const std::string &name,
+                 int64_t value,
+                 const std::string &unit);
+
+  void pass()
+  {
+    finish(true);
+  }
+  void fail()
+  {
+    finish(false);
+  }
+
+private:
+  void finish(bool pass);
+
+  std::ostream &out_;
+  bool json_;
+  std::vector<std::string> entries_;
+};
+
+// Measures every pass in mgr and, when running as root, the startup stages
+// that follow code generation: opening the BPF object, creating the maps,
+// loading the programs and attaching every probe.
+Result<OK> benchmark(BenchmarkReport &report,
+                     ast::PassManager &mgr,
+                     BPFtrace &bpftrace);
+
+// Compares the rate at which the kernel symbol backends resolve addresses.
+Result<OK> benchmark_ksyms(BenchmarkReport &report, Ksyms &ksyms);
+
+// Measures cgroup_path() resolution while cgroups are created and removed, in
+// a scratch cgroup below the cgroup2 root. Needs root.
+Result<OK> benchmark_cgroup(BenchmarkReport &report, BPFtrace &bpftrace);
+
+// Loads the programs and measures the time a single invocation of every probe
+// takes in the kernel. Probes that bpftrace triggers itself are run with
+// BPF_PROG_TEST_RUN, all others are attached and measured with the kernel's
+// run time statistics while their events happen. Needs root.
+Result<OK> benchmark_probes(BenchmarkReport &report,
+                            BPFtrace &bpftrace,
+                            BpfBytecode &bytecode,
+                            std::vector<std::string> &&named_params);
 
 } // namespace bpftrace
@@ -1,15 +1,19 @@
 #include "bpfbytecode.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <ctime>
 #include <stdexcept>
 
 #include "ast/passes/named_param.h"
 #include "bpftrace.h"
 #include "globalvars.h"
 #include "log.h"
+#include "map_planner.h"
 #include "util/bpf_names.h"
 #include "util/exceptions.h"
+#include "util/timing.h"
 #include "util/wildcard.h"
 
 #include <bpf/bpf.h>
@@ -128,14 +132,22 @@ void BpfBytecode::update_global_vars(BPFtrace &bpftrace,
 
 uint64_t BpfBytecode::get_event_loss_counter(BPFtrace &bpftrace, int max_cpu_id)
 {
-  auto *current_values = bpftrace.resources.global_vars.get_global_var(
-      bpf_object_.get(),
-      globalvars::EVENT_LOSS_COUNTER_SECTION_NAME,
-      section_names_to_global_vars_map_);
+  // The counter lives in a BPF_F_MMAPABLE global data section which libbpf
+  // maps into our address space at load time (at the same address as the
+  // initial value buffer). Resolve its location once so that the poll loop
+  // only does plain loads and no BTF lookups or syscalls.
+  if (!event_loss_counters_) {
+    event_loss_counters_ = bpftrace.resources.global_vars.get_global_var(
+        bpf_object_.get(),
+        globalvars::EVENT_LOSS_COUNTER_SECTION_NAME,
+        section_names_to_global_vars_map_);
+  }
+
+  // The section has one counter per CPU, up to and including max_cpu_id.
   uint64_t current_value = 0;
-  for (int i = 0; i < max_cpu_id; ++i) {
-    current_value += *current_values;
-    current_values++;
+  for (int i = 0; i <= max_cpu_id; ++i) {
+    current_value += std::atomic_ref<uint64_t>(event_loss_counters_[i])
+                         .load(std::memory_order_relaxed);
   }
 
   return current_value;
@@ -217,7 +229,15 @@ void BpfBytecode::load_progs(const RequiredResources &resources,
   prepare_progs(resources.probes, btf, feature, config);
   prepare_progs(resources.watchpoint_probes, btf, feature, config);
 
-  int res = bpf_object__load(bpf_object_.get());
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  load_start_ns_ = (1000000000ULL * ts.tv_sec) + ts.tv_nsec;
+  int res;
+  {
+    // Also creates the maps, but the verifier dominates.
+    util::TimingSpan span("verifier", "bpf_object__load");
+    res = bpf_object__load(bpf_object_.get());
+  }
 
   // If requested, print the entire verifier logs, even if loading succeeded.
   for (const auto &[name, prog] : programs_) {
@@ -228,8 +248,10 @@ void BpfBytecode::load_progs(const RequiredResources &resources,
     }
   }
 
-  if (res == 0)
+  if (res == 0) {
+    log_verified_insns();
     return;
+  }
 
   // If loading of bpf_object failed, we try to give user some hints of what
   // could've gone wrong.
@@ -299,6 +321,41 @@ void BpfBytecode::load_progs(const RequiredResources &resources,
   throw util::FatalUserException("Loading BPF object(s) failed.");
 }
 
+// The number of instructions the verifier processed is what makes loading
+// slow for large scripts, so report it to help reduce it.
+void BpfBytecode::log_verified_insns() const
+{
+  if (!bt_verbose)
+    return;
+
+  uint64_t total = 0;
+  size_t loaded = 0;
+  uint32_t max = 0;
+  std::string_view max_name;
+  for (const auto &[name, prog] : programs_) {
+    if (prog.fd() < 0)
+      continue;
+    struct bpf_prog_info info = {};
+    uint32_t info_len = sizeof(info);
+    if (bpf_obj_get_info_by_fd(prog.fd(), &info, &info_len) != 0)
+      return;
+    // Older kernels (before 5.16) do not report it.
+    if (info.verified_insns == 0)
+      return;
+    total += info.verified_insns;
+    loaded++;
+    if (info.verified_insns > max) {
+      max = info.verified_insns;
+      max_name = name;
+    }
+  }
+  if (total == 0)
+    return;
+
+  LOG(V1) << "Verified " << total << " instructions in " << loaded
+          << " programs, most in " << max_name << " (" << max << ")";
+}
+
 void BpfBytecode::prepare_progs(const std::vector<Probe> &probes,
                                 const BTF &btf,
                                 BPFfeature &feature,
@@ -368,6 +425,90 @@ int BpfBytecode::countStackMaps() const
   return n;
 }
 
+Result<OK> BpfBytecode::plan_map_memory(RequiredResources &resources,
+                                        const Config &config,
+                                        uint32_t ncpus)
+{
+  MapPlanner planner(ncpus, config.max_map_memory);
+
+  struct bpf_map *m;
+  bpf_map__for_each (m, bpf_object_.get()) {
+    std::string name = bpftrace_map_name(bpf_map__name(m));
+    auto map = maps_.find(name);
+
+    // User maps may be shrunk unless they were declared with an explicit size
+    // or only ever hold a single element. Stack maps are LRU maps already, a
+    // smaller one just means that some stacks get symbolized as missing.
+    //
+    // Multi-key aggregate maps (hist, lhist, tseries, quantiles) hold one
+    // element per bucket of every key. Evicting single buckets would silently
+    // skew the printed results, so they are shrunk but not turned into LRU
+    // maps. topk maps evict whole candidates and are LRU maps already.
+    bool resizable = false;
+    bool evictable = true;
+    if (map != maps_.end()) {
+      auto map_info = resources.maps_info.find(name);
+      if (map_info != resources.maps_info.end()) {
+        resizable = !map_info->second.is_declared &&
+                    map_info->second.max_entries > 1;
+        evictable = !map_info->second.value_type.IsMultiKeyMapTy();
+      } else
+        resizable = map->second.is_stack_map();
+    }
+
+    planner.add(MapPlanEntry{
+        .name = map != maps_.end() ? name : bpf_map__name(m),
+        .type = static_cast<libbpf::bpf_map_type>(bpf_map__type(m)),
+        .key_size = bpf_map__key_size(m),
+        .value_size = bpf_map__value_size(m),
+        .max_entries = bpf_map__max_entries(m),
+        .resizable = resizable,
+        .evictable = evictable,
+    });
+  }
+
+  auto ok = planner.plan();
+  if (!ok)
+    return ok.takeError();
+
+  for (const auto &entry : planner.entries()) {
+    if (!entry.resized)
+      continue;
+
+    auto &map = maps_.at(entry.name);
+    auto *bpf_map = bpf_object__find_map_by_name(bpf_object_.get(),
+                                                 map.bpf_name().c_str());
+    if (bpf_map__set_type(bpf_map,
+                          static_cast<enum ::bpf_map_type>(entry.type)) ||
+        bpf_map__set_max_entries(bpf_map, entry.max_entries))
+      LOG(BUG) << "Failed to resize map " << entry.name;
+    map = BpfMap(bpf_map);
+
+    auto map_info = resources.maps_info.find(entry.name);
+    if (map_info != resources.maps_info.end()) {
+      map_info->second.bpf_type = entry.type;
+      map_info->second.max_entries = entry.max_entries;
+    }
+    if (entry.evictable)
+      LOG(WARNING) << "Map " << entry.name << " was resized to "
+                   << entry.max_entries
+                   << " entries to fit in max_map_memory, it will evict the "
+                      "least recently used keys when full";
+    else
+      LOG(WARNING) << "Map " << entry.name << " was resized to "
+                   << entry.max_entries
+                   << " entries to fit in max_map_memory, updates of new "
+                      "keys will be dropped when full";
+  }
+
+  if (bt_verbose) {
+    std::stringstream report;
+    planner.report(report);
+    LOG(V1) << "Map memory:\n" << report.str();
+  }
+  return OK();
+}
+
 void BpfBytecode::set_map_ids(RequiredResources &resources)
 {
   for (auto &map : maps_) {
@@ -50,16 +50,29 @@ public:
   const BpfMap &getMap(MapType internal_type) const;
   const BpfMap &getMap(int map_id) const;
   void set_map_ids(RequiredResources &resources);
+  // Computes how much kernel memory the maps will take and shrinks the ones
+  // that may be shrunk if that exceeds config.max_map_memory. Must be called
+  // before set_map_ids() and load_progs().
+  Result<OK> plan_map_memory(RequiredResources &resources,
+                             const Config &config,
+                             uint32_t ncpus);
 
   const std::map<std::string, BpfMap> &maps() const;
   int countStackMaps() const;
 
+  // Boot time in ns at which load_progs() started loading the programs.
+  uint64_t load_start_ns() const
+  {
+    return load_start_ns_;
+  }
+
 private:
   void prepare_progs(const std::vector<Probe> &probes,
                      const BTF &btf,
                      BPFfeature &feature,
                      const Config &config);
   bool all_progs_loaded();
+  void log_verified_insns() const;
 
   // We need a custom deleter for bpf_object which will call bpf_object__close.
   // Note that it is not possible to run bpf_object__close in ~BpfBytecode
@@ -77,6 +90,12 @@ private:
   std::map<std::string, BpfProgram> programs_;
   std::unordered_map<std::string, struct bpf_map *>
       section_names_to_global_vars_map_;
+
+  // Per-CPU event loss counters, pointing into the mmap-ed global data
+  // section. Resolved lazily on the first read after the object is loaded.
+  uint64_t *event_loss_counters_ = nullptr;
+
+  uint64_t load_start_ns_ = 0;
 };
 
 class HelperVerifierError : public std::runtime_error {
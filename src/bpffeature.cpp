@@ -35,6 +35,8 @@ int BPFnofeature::parse(const char* str)
       kprobe_session_ = true;
     } else if (feat == "uprobe_multi") {
       uprobe_multi_ = true;
+    } else if (feat == "global_func") {
+      global_func_ = true;
     } else {
       return -1;
     }
@@ -251,6 +253,11 @@ bool BPFfeature::has_btf_func_global()
   if (has_btf_func_global_.has_value())
     return *has_btf_func_global_;
 
+  if (no_feature_.global_func_) {
+    has_btf_func_global_ = false;
+    return *has_btf_func_global_;
+  }
+
   /* static void x(int a) {} */
   __u32 types[] = {
     /* int */
@@ -583,6 +590,10 @@ std::string BPFfeature::report()
     { "for_each_map_elem", to_str(has_helper_for_each_map_elem()) },
     { "get_ns_current_pid_tgid", to_str(has_helper_get_ns_current_pid_tgid()) },
     { "lookup_percpu_elem", to_str(has_helper_map_lookup_percpu_elem()) },
+    { "strncmp", to_str(has_helper_strncmp()) },
+    { "get_current_ancestor_cgroup_id",
+      to_str(has_helper_get_current_ancestor_cgroup_id(
+          libbpf::BPF_PROG_TYPE_KPROBE)) },
   };
 
   std::vector<std::pair<std::string, std::string>> features = {
@@ -590,6 +601,7 @@ std::string BPFfeature::report()
     { "btf", to_str(has_btf()) },
     { "module btf", to_str(btf_.has_module_btf()) },
     { "map batch", to_str(has_map_batch()) },
+    { "global functions", to_str(has_btf_func_global()) },
   };
 
   std::vector<std::pair<std::string, std::string>> map_types = {
@@ -657,6 +669,40 @@ bool BPFfeature::has_fentry()
   return has_prog_fentry() && btf_.has_data();
 }
 
+bool BPFfeature::has_helper_get_current_ancestor_cgroup_id(
+    libbpf::bpf_prog_type prog_type)
+{
+  auto found = has_get_current_ancestor_cgroup_id_.find(prog_type);
+  if (found != has_get_current_ancestor_cgroup_id_.end())
+    return found->second;
+
+  bool result;
+  if (prog_type == libbpf::BPF_PROG_TYPE_TRACING) {
+    // Tracing programs cannot be loaded without a function to attach to, so
+    // load a real fentry program instead of looking at the verifier log.
+    struct bpf_insn insns[] = {
+      BPF_MOV64_IMM(BPF_REG_1, 0),
+      BPF_RAW_INSN(BPF_JMP | BPF_CALL,
+                   0,
+                   0,
+                   0,
+                   libbpf::BPF_FUNC_get_current_ancestor_cgroup_id),
+      BPF_MOV64_IMM(BPF_REG_0, 0),
+      BPF_EXIT_INSN(),
+    };
+    result = try_load(libbpf::BPF_PROG_TYPE_TRACING,
+                      insns,
+                      ARRAY_SIZE(insns),
+                      "sched_fork",
+                      libbpf::BPF_TRACE_FENTRY);
+  } else {
+    result = detect_helper(libbpf::BPF_FUNC_get_current_ancestor_cgroup_id,
+                           prog_type);
+  }
+  has_get_current_ancestor_cgroup_id_[prog_type] = result;
+  return result;
+}
+
 bool BPFfeature::has_iter(std::string name)
 {
   auto tracing_name = "bpf_iter_" + name;
@@ -4,6 +4,7 @@
 #include "kfuncs.h"
 #include <optional>
 #include <string>
+#include <unordered_map>
 
 #include <linux/bpf.h>
 
@@ -65,6 +66,7 @@ protected:
   bool kprobe_multi_{ false };
   bool kprobe_session_{ false };
   bool uprobe_multi_{ false };
+  bool global_func_{ false };
   friend class BPFfeature;
 };
 
@@ -100,6 +102,10 @@ public:
   // These are virtual so they can be overridden in tests by the mock
   virtual bool has_fentry();
   virtual bool has_kernel_func(Kfunc kfunc);
+  // The --cgroup filter calls this helper from every type of program it is
+  // compiled into, and helpers are enabled per program type.
+  virtual bool has_helper_get_current_ancestor_cgroup_id(
+      libbpf::bpf_prog_type prog_type);
 
   std::string report();
 
@@ -125,6 +131,7 @@ public:
   DEFINE_HELPER_TEST(get_ns_current_pid_tgid, libbpf::BPF_PROG_TYPE_KPROBE);
   DEFINE_HELPER_TEST(map_lookup_percpu_elem, libbpf::BPF_PROG_TYPE_KPROBE);
   DEFINE_HELPER_TEST(loop, libbpf::BPF_PROG_TYPE_KPROBE); // Added in 5.13.
+  DEFINE_HELPER_TEST(strncmp, libbpf::BPF_PROG_TYPE_KPROBE); // Added in 5.17.
   DEFINE_PROG_TEST(kprobe, libbpf::BPF_PROG_TYPE_KPROBE);
   DEFINE_PROG_TEST(tracepoint, libbpf::BPF_PROG_TYPE_TRACEPOINT);
   DEFINE_PROG_TEST(perf_event, libbpf::BPF_PROG_TYPE_PERF_EVENT);
@@ -142,6 +149,8 @@ protected:
   std::optional<bool> has_kernel_dwarf_;
 
   std::unordered_map<Kfunc, bool> available_kernel_funcs_;
+  std::unordered_map<libbpf::bpf_prog_type, bool>
+      has_get_current_ancestor_cgroup_id_;
 
 private:
   bool detect_map(libbpf::bpf_map_type map_type);
@@ -179,7 +179,8 @@ Result<HistogramMap> BpfMap::collect_histogram_data(const MapInfo &map_info,
 
     if (!values_by_key.contains(key_prefix)) {
       // New key - create a list of buckets for it
-      if (map_info.value_type.IsHistTy())
+      if (map_info.value_type.IsHistTy() ||
+          map_info.value_type.IsQuantilesTy())
         values_by_key[key_prefix] = BucketType(65 * 32);
       else
         values_by_key[key_prefix] = BucketType(1002);
@@ -254,6 +255,11 @@ libbpf::bpf_map_type get_bpf_map_type(const SizedType &val_type, bool scalar)
 {
   if (val_type.IsCountTy() && scalar) {
     return libbpf::BPF_MAP_TYPE_PERCPU_ARRAY;
+  } else if (val_type.IsTopkTy()) {
+    // topk() maps only hold candidate keys, the counts live in the sketch.
+    // Letting the kernel evict the least recently seen keys keeps the map
+    // bounded no matter how many distinct keys there are.
+    return libbpf::BPF_MAP_TYPE_LRU_HASH;
   } else if (val_type.NeedsPercpuMap()) {
     return libbpf::BPF_MAP_TYPE_PERCPU_HASH;
   } else {
@@ -132,6 +132,12 @@ inline std::string bpftrace_map_name(std::string_view bpf_map_name)
   return name;
 }
 
+// topk() maps keep their count-min sketch in a separate internal map.
+inline std::string topk_sketch_map_name(std::string_view bpftrace_map_name)
+{
+  return "cms_" + bpf_map_name(bpftrace_map_name);
+}
+
 inline bool is_bpf_map_clearable(libbpf::bpf_map_type map_type)
 {
   return map_type != libbpf::BPF_MAP_TYPE_ARRAY &&
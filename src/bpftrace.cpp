@@ -17,6 +17,7 @@
 #include <fcntl.h>
 #include <fstream>
 #include <glob.h>
+#include <iomanip>
 #include <iostream>
 #include <ranges>
 #include <regex>
@@ -41,7 +42,9 @@
 #include "bpftrace.h"
 #include "btf.h"
 #include "log.h"
+#include "offline_symbolizer.h"
 #include "printf.h"
+#include "prog_stats.h"
 #include "scopeguard.h"
 #include "util/bpf_names.h"
 #include "util/cgroup.h"
@@ -50,9 +53,11 @@
 #include "util/int_parser.h"
 #include "util/kernel.h"
 #include "util/paths.h"
+#include "util/sketch.h"
 #include "util/stats.h"
 #include "util/strings.h"
 #include "util/system.h"
+#include "util/timing.h"
 #include "util/wildcard.h"
 
 using namespace std::chrono_literals;
@@ -89,6 +94,8 @@ static void log_probe_attach_failure(const std::string &err_msg,
 BPFtrace::~BPFtrace()
 {
   close_pcaps();
+  if (run_stats_fd_ >= 0)
+    close(run_stats_fd_);
 }
 
 Probe BPFtrace::generateWatchpointSetupProbe(const ast::AttachPoint &ap,
@@ -254,6 +261,14 @@ void perf_event_printer(void *cb_cookie, void *data, int size)
     return;
   }
 
+  // Only printf() goes through the symbolizer pool, everything else must
+  // wait for the printf() output before it.
+  auto &symbolizer_pool = ctx->bpftrace.symbolizer_pool_;
+  if (symbolizer_pool && !symbolizer_pool->empty() &&
+      (printf_id < async_action::AsyncAction::printf ||
+       printf_id > async_action::AsyncAction::printf_end))
+    symbolizer_pool->drain();
+
   // async actions
   if (printf_id == async_action::AsyncAction::exit) {
     ctx->handlers.exit(data);
@@ -274,7 +289,7 @@ void perf_event_printer(void *cb_cookie, void *data, int size)
     ctx->handlers.time(data);
     return;
   } else if (printf_id == async_action::AsyncAction::join) {
-    ctx->handlers.join(data);
+    ctx->handlers.join(data, size);
     return;
   } else if (printf_id == async_action::AsyncAction::helper_error) {
     ctx->handlers.helper_error(data);
@@ -290,15 +305,15 @@ void perf_event_printer(void *cb_cookie, void *data, int size)
     return;
   } else if (printf_id >= async_action::AsyncAction::syscall &&
              printf_id <= async_action::AsyncAction::syscall_end) {
-    ctx->handlers.syscall(printf_id, arg_data);
+    ctx->handlers.syscall(printf_id, arg_data, size);
     return;
   } else if (printf_id >= async_action::AsyncAction::cat &&
              printf_id <= async_action::AsyncAction::cat_end) {
-    ctx->handlers.cat(printf_id, arg_data);
+    ctx->handlers.cat(printf_id, arg_data, size);
     return;
   } else if (printf_id >= async_action::AsyncAction::printf &&
              printf_id <= async_action::AsyncAction::printf_end) {
-    ctx->handlers.printf(printf_id, arg_data);
+    ctx->handlers.printf(printf_id, arg_data, size);
     return;
   } else {
     LOG(BUG) << "Unknown printf_id: " << static_cast<int64_t>(printf_id);
@@ -314,11 +329,81 @@ int ringbuf_printer(void *cb_cookie, void *data, size_t size)
 std::vector<std::unique_ptr<IPrintable>> BPFtrace::get_arg_values(
     Output &output,
     const std::vector<Field> &args,
-    uint8_t *arg_data)
+    uint8_t *arg_data,
+    size_t size,
+    std::vector<DeferredArg> *deferred)
 {
   std::vector<std::unique_ptr<IPrintable>> arg_values;
 
-  for (auto arg : args) {
+  // Symbols are resolved right away, or left to the caller. Everything that
+  // cannot wait, like reading the stack map or the executable of a process,
+  // is done here either way.
+  auto add_symbol = [&](DeferredArg::Resolve resolve) {
+    if (deferred) {
+      deferred->push_back(DeferredArg{ .index = arg_values.size(),
+                                       .resolve = std::move(resolve) });
+      arg_values.push_back(std::make_unique<PrintableString>(""));
+    } else {
+      arg_values.push_back(
+          std::make_unique<PrintableString>(resolve(ksyms_, usyms_)));
+    }
+  };
+  auto add_stack = [&](int64_t stackid,
+                       uint32_t nr_stack_frames,
+                       int32_t pid,
+                       int32_t probe_id,
+                       bool ustack,
+                       StackType stack_type) {
+    auto stack_trace = read_stack(stackid, nr_stack_frames, pid, stack_type);
+    if (!stack_trace) {
+      arg_values.push_back(std::make_unique<PrintableString>(""));
+      return;
+    }
+    std::shared_ptr<const ProcessSnapshot> process;
+    if (ustack && stack_type.mode != StackMode::raw &&
+        stack_type.mode != StackMode::build_id)
+      process = resolve_process(pid, probe_id);
+    add_symbol([this,
+                stack_trace = std::move(*stack_trace),
+                nr_stack_frames,
+                pid,
+                process,
+                ustack,
+                stack_type](Ksyms &ksyms, Usyms &usyms) {
+      return format_stack(stack_trace,
+                          nr_stack_frames,
+                          pid,
+                          process.get(),
+                          ustack,
+                          stack_type,
+                          8,
+                          ksyms,
+                          usyms);
+    });
+  };
+
+  // Packed strings and buffers follow each other, starting at the offset of
+  // the first one. Their size is only known once they are read, so they are
+  // checked against the size of the event one by one.
+  std::optional<size_t> packed_offset;
+  auto field_offset = [&](const Field &arg) -> size_t {
+    if (!arg.is_packed)
+      return arg.offset;
+    if (!packed_offset)
+      packed_offset = arg.offset;
+    return *packed_offset;
+  };
+  auto check_size = [&](size_t offset, size_t length) {
+    if (offset > size || length > size - offset)
+      throw util::FatalUserException(
+          "get_arg_values: argument of size " + std::to_string(length) +
+          " at offset " + std::to_string(offset) +
+          " does not fit in the event of size " + std::to_string(size));
+  };
+
+  for (const auto &arg : args) {
+    if (!arg.is_packed)
+      check_size(arg.offset, arg.type.GetSize());
     switch (arg.type.GetTy()) {
       case Type::integer:
         if (arg.type.IsSigned()) {
@@ -374,7 +459,7 @@ std::vector<std::unique_ptr<IPrintable>> BPFtrace::get_arg_values(
           // bpftrace represents enums as unsigned integers
           const auto &c_definitions = output.c_definitions();
           if (arg.type.IsEnumTy()) {
-            auto enum_name = arg.type.GetName();
+            const auto &enum_name = arg.type.GetName();
             if (c_definitions.enum_defs.contains(enum_name) &&
                 c_definitions.enum_defs.find(enum_name)->second.contains(val)) {
               arg_values.push_back(std::make_unique<PrintableEnum>(
@@ -392,31 +477,61 @@ std::vector<std::unique_ptr<IPrintable>> BPFtrace::get_arg_values(
         }
         break;
       case Type::string: {
-        auto *p = reinterpret_cast<char *>(arg_data + arg.offset);
+        size_t offset = field_offset(arg);
+        size_t max_length = arg.type.GetSize();
+        if (arg.is_packed) {
+          check_size(offset, 0);
+          max_length = std::min(max_length, size - offset);
+        }
+        auto *p = reinterpret_cast<char *>(arg_data + offset);
+        size_t length = strnlen(p, max_length);
+        if (arg.is_packed) {
+          // Without the NUL, a packed string must take up its full size.
+          size_t packed_size = std::min<size_t>(length + 1,
+                                                arg.type.GetSize());
+          check_size(offset, packed_size);
+          packed_offset = offset + packed_size;
+        }
         arg_values.push_back(std::make_unique<PrintableString>(
-            std::string(p, strnlen(p, arg.type.GetSize())),
+            std::string(p, length),
             config_->max_strlen,
             config_->str_trunc_trailer.c_str()));
         break;
       }
       case Type::buffer: {
-        auto length =
-            reinterpret_cast<AsyncEvent::Buf *>(arg_data + arg.offset)->length;
-        arg_values.push_back(std::make_unique<PrintableBuffer>(
-            reinterpret_cast<AsyncEvent::Buf *>(arg_data + arg.offset)->content,
-            length));
+        size_t offset = field_offset(arg);
+        if (arg.is_packed)
+          check_size(offset, sizeof(AsyncEvent::Buf));
+        auto *buf = reinterpret_cast<AsyncEvent::Buf *>(arg_data + offset);
+        size_t length = std::min<size_t>(
+            buf->length, arg.type.GetSize() - sizeof(AsyncEvent::Buf));
+        if (arg.is_packed) {
+          check_size(offset, sizeof(AsyncEvent::Buf) + length);
+          packed_offset = offset + sizeof(AsyncEvent::Buf) + length;
+        }
+        arg_values.push_back(
+            std::make_unique<PrintableBuffer>(buf->content, length));
         break;
       }
-      case Type::ksym_t:
-        arg_values.push_back(std::make_unique<PrintableString>(resolve_ksym(
-            *reinterpret_cast<uint64_t *>(arg_data + arg.offset))));
+      case Type::ksym_t: {
+        auto addr = *reinterpret_cast<uint64_t *>(arg_data + arg.offset);
+        add_symbol([addr](Ksyms &ksyms, Usyms &) {
+          return ksyms.resolve(addr, false, false, false).front();
+        });
         break;
-      case Type::usym_t:
-        arg_values.push_back(std::make_unique<PrintableString>(resolve_usym(
-            *reinterpret_cast<uint64_t *>(arg_data + arg.offset),
-            *reinterpret_cast<int32_t *>(arg_data + arg.offset + 8),
-            *reinterpret_cast<int32_t *>(arg_data + arg.offset + 12))));
+      }
+      case Type::usym_t: {
+        auto addr = *reinterpret_cast<uint64_t *>(arg_data + arg.offset);
+        auto pid = *reinterpret_cast<int32_t *>(arg_data + arg.offset + 8);
+        auto probe_id = *reinterpret_cast<int32_t *>(arg_data + arg.offset +
+                                                     12);
+        add_symbol([addr, pid, process = resolve_process(pid, probe_id)](
+                       Ksyms &, Usyms &usyms) {
+          return usyms.resolve(addr, pid, *process, false, false, false)
+              .front();
+        });
         break;
+      }
       case Type::inet:
         arg_values.push_back(std::make_unique<PrintableString>(resolve_inet(
             *reinterpret_cast<int64_t *>(arg_data + arg.offset),
@@ -427,24 +542,20 @@ std::vector<std::unique_ptr<IPrintable>> BPFtrace::get_arg_values(
             resolve_uid(*reinterpret_cast<uint64_t *>(arg_data + arg.offset))));
         break;
       case Type::kstack_t:
-        arg_values.push_back(std::make_unique<PrintableString>(
-            get_stack(*reinterpret_cast<int64_t *>(arg_data + arg.offset),
-                      *reinterpret_cast<uint32_t *>(arg_data + arg.offset + 8),
-                      -1,
-                      -1,
-                      false,
-                      arg.type.stack_type,
-                      8)));
+        add_stack(*reinterpret_cast<int64_t *>(arg_data + arg.offset),
+                  *reinterpret_cast<uint32_t *>(arg_data + arg.offset + 8),
+                  -1,
+                  -1,
+                  false,
+                  arg.type.stack_type);
         break;
       case Type::ustack_t:
-        arg_values.push_back(std::make_unique<PrintableString>(
-            get_stack(*reinterpret_cast<int64_t *>(arg_data + arg.offset),
-                      *reinterpret_cast<uint32_t *>(arg_data + arg.offset + 8),
-                      *reinterpret_cast<int32_t *>(arg_data + arg.offset + 16),
-                      *reinterpret_cast<int32_t *>(arg_data + arg.offset + 20),
-                      true,
-                      arg.type.stack_type,
-                      8)));
+        add_stack(*reinterpret_cast<int64_t *>(arg_data + arg.offset),
+                  *reinterpret_cast<uint32_t *>(arg_data + arg.offset + 8),
+                  *reinterpret_cast<int32_t *>(arg_data + arg.offset + 16),
+                  *reinterpret_cast<int32_t *>(arg_data + arg.offset + 20),
+                  true,
+                  arg.type.stack_type);
         break;
       case Type::timestamp:
         arg_values.push_back(
@@ -515,6 +626,7 @@ Result<std::unique_ptr<AttachedProbe>> BPFtrace::attach_probe(
     Probe &probe,
     const BpfBytecode &bytecode)
 {
+  util::TimingSpan span("attach", probe.name);
   const auto &program = bytecode.getProgramForProbe(probe);
   std::optional<pid_t> pid = child_ ? std::make_optional(child_->pid())
                                     : this->pid();
@@ -630,13 +742,13 @@ int BPFtrace::prerun() const
   return 0;
 }
 
-int BPFtrace::run(Output &out, BpfBytecode bytecode)
+int BPFtrace::load_bytecode(BpfBytecode bytecode)
 {
-  int err = prerun();
-  if (err)
-    return err;
-
   bytecode_ = std::move(bytecode);
+  if (auto ok = bytecode_.plan_map_memory(resources, *config_, ncpus_); !ok) {
+    LOG(ERROR) << ok.takeError();
+    return -1;
+  }
   bytecode_.set_map_ids(resources);
 
   try {
@@ -655,6 +767,18 @@ int BPFtrace::run(Output &out, BpfBytecode bytecode)
     LOG(ERROR) << e.what();
     return -1;
   }
+  return 0;
+}
+
+int BPFtrace::run(Output &out, BpfBytecode bytecode)
+{
+  int err = prerun();
+  if (err)
+    return err;
+
+  err = load_bytecode(std::move(bytecode));
+  if (err)
+    return err;
 
   async_action::AsyncHandlers handlers(*this, out);
   PerfEventContext ctx(*this, handlers, out);
@@ -666,6 +790,18 @@ int BPFtrace::run(Output &out, BpfBytecode bytecode)
     teardown_output();
   };
 
+  if (config_->symbolication_threads > 0)
+    symbolizer_pool_ = std::make_unique<SymbolizerPool>(
+        *config_, config_->symbolication_threads);
+  SCOPE_EXIT
+  {
+    // The pending output refers to handlers.
+    if (symbolizer_pool_) {
+      symbolizer_pool_->drain();
+      symbolizer_pool_.reset();
+    }
+  };
+
   err = create_pcaps();
   if (err) {
     LOG(ERROR) << "Failed to create pcap file(s)";
@@ -686,6 +822,26 @@ int BPFtrace::run(Output &out, BpfBytecode bytecode)
     }
   }
 
+  // Kernel frames of stacks in build_id mode are symbolized offline, which
+  // needs the kernel symbols of this boot.
+  const auto build_id_maps = "stack_" +
+                             STACK_MODE_NAME_MAP.at(StackMode::build_id) + "_";
+  for (const auto &[name, map] : bytecode_.maps()) {
+    if (name.starts_with(build_id_maps)) {
+      if (!save_kallsyms_snapshot())
+        LOG(WARNING) << "Cannot save kernel symbols, kernel stack frames "
+                        "will not be symbolized offline";
+      break;
+    }
+  }
+
+  if (prog_stats_) {
+    run_stats_fd_ = enable_run_stats();
+    if (run_stats_fd_ < 0 && !run_stats_enabled(run_stats_fd_))
+      LOG(WARNING) << "Cannot enable BPF run time statistics, --stats will "
+                      "only show load statistics";
+  }
+
   int num_special_attached = 0;
 
   auto begin_probe = resources.special_probes.find("BEGIN");
@@ -717,6 +873,8 @@ int BPFtrace::run(Output &out, BpfBytecode bytecode)
     }
   }
 
+  auto attach_start = std::chrono::steady_clock::now();
+
   // The kernel appears to fire some probes in the order that they were
   // attached and others in reverse order. In order to make sure that blocks
   // are executed in the same order they were declared, iterate over the probes
@@ -783,6 +941,17 @@ int BPFtrace::run(Output &out, BpfBytecode bytecode)
 
   auto total_attached = num_attached + num_special_attached;
 
+  if (bt_verbose) {
+    using ms = std::chrono::duration<double, std::milli>;
+    auto attach_time = ms(std::chrono::steady_clock::now() - attach_start);
+    LOG(V1) << "Attached " << total_attached << " probes in " << std::fixed
+            << std::setprecision(1) << attach_time.count() << "ms";
+    if (uprobe_resolve_stats_.count > 0)
+      LOG(V1) << "Resolved " << uprobe_resolve_stats_.count
+              << " uprobe offsets in " << std::fixed << std::setprecision(1)
+              << ms(uprobe_resolve_stats_.time).count() << "ms";
+  }
+
   if (total_attached == 0) {
     LOG(ERROR) << "Attachment failed for all probes.";
     return -1;
@@ -957,6 +1126,9 @@ void BPFtrace::poll_output(Output &out, bool drain)
         do_poll_ringbuf = false;
       }
     }
+
+    if (symbolizer_pool_)
+      symbolizer_pool_->emit_ready();
     if (!poll_skboutput && !do_poll_ringbuf) {
       return;
     }
@@ -971,6 +1143,9 @@ void BPFtrace::poll_output(Output &out, bool drain)
     if (BPFtrace::sigusr1_recv) {
       BPFtrace::sigusr1_recv = false;
 
+      if (prog_stats_)
+        print_prog_stats(out);
+
       for (auto fd : sigusr1_prog_fds_) {
         if (::bpf_prog_test_run_opts(fd, nullptr)) {
           LOG(ERROR) << "Failed to run signal probe";
@@ -1008,6 +1183,23 @@ void BPFtrace::poll_event_loss(Output &out)
   }
 }
 
+void BPFtrace::print_prog_stats(Output &out)
+{
+  if (dry_run)
+    return;
+
+  // The most expensive programs first: by run time if it is counted, by
+  // verifier work otherwise.
+  auto stats = collect_prog_stats(resources, bytecode_);
+  bool has_run_stats = run_stats_enabled(run_stats_fd_);
+  std::ranges::stable_sort(stats, [&](const auto &a, const auto &b) {
+    if (has_run_stats)
+      return a.run_time_ns > b.run_time_ns;
+    return a.verified_insns > b.verified_insns;
+  });
+  out.prog_stats(stats, has_run_stats);
+}
+
 int BPFtrace::print_maps(Output &out)
 {
   if (dry_run)
@@ -1032,10 +1224,13 @@ int BPFtrace::print_map(Output &out,
 {
   const auto &map_info = resources.maps_info.at(map.name());
   const auto &value_type = map_info.value_type;
-  if (value_type.IsHistTy() || value_type.IsLhistTy())
+  if (value_type.IsHistTy() || value_type.IsLhistTy() ||
+      value_type.IsQuantilesTy())
     return print_map_hist(out, map, top, div);
   else if (value_type.IsTSeriesTy())
     return print_map_tseries(out, map);
+  else if (value_type.IsTopkTy())
+    return print_map_topk(out, map, top);
 
   uint64_t nvalues = map.is_per_cpu_type() ? ncpus_ : 1;
   auto values_by_key = map.collect_elements(nvalues);
@@ -1083,6 +1278,19 @@ int BPFtrace::print_map(Output &out,
                                  util::avg_value<uint64_t>(b.second, nvalues);
                         });
     }
+  } else if (value_type.IsDistinctTy()) {
+    // Merging the registers of every CPU is too expensive to redo on each
+    // comparison, so estimate every key once up front.
+    std::vector<std::pair<uint64_t, MapElements::value_type>> estimated;
+    estimated.reserve(values_by_key->size());
+    for (auto &kv : *values_by_key)
+      estimated.emplace_back(util::distinct_value(kv.second, nvalues),
+                             std::move(kv));
+    std::ranges::sort(estimated, [](const auto &a, const auto &b) {
+      return a.first < b.first;
+    });
+    for (size_t i = 0; i < estimated.size(); i++)
+      (*values_by_key)[i] = std::move(estimated[i].second);
   } else {
     sort_by_key(map_info.key_type, *values_by_key);
   };
@@ -1167,6 +1375,51 @@ int BPFtrace::print_map_tseries(Output &out, const BpfMap &map)
   return 0;
 }
 
+int BPFtrace::print_map_topk(Output &out, const BpfMap &map, uint32_t top)
+{
+  // A topk-map only holds the candidate keys (and their hash), their counts
+  // are estimated from the count-min sketch stored in a separate map.
+  const auto &map_info = resources.maps_info.at(map.name());
+  if (!std::holds_alternative<TopkArgs>(map_info.detail))
+    LOG(BUG) << "call to topk with missing \"k\" argument";
+  uint32_t k = std::get<TopkArgs>(map_info.detail).k;
+
+  auto candidates = map.collect_elements(1);
+  if (!candidates) {
+    LOG(ERROR) << "Failed to collect key-value pairs: "
+               << candidates.takeError();
+    return -1;
+  }
+
+  const auto &sketch_map = bytecode_.getMap(topk_sketch_map_name(map.name()));
+  uint32_t sketch_key = 0;
+  std::vector<uint8_t> sketch_values(util::TOPK_SKETCH_ROWS *
+                                     util::TOPK_SKETCH_COLS * sizeof(uint32_t) *
+                                     ncpus_);
+  auto ok = sketch_map.lookup_elem(&sketch_key, sketch_values.data());
+  if (!ok) {
+    LOG(ERROR) << "Failed to read topk sketch: " << ok.takeError();
+    return -1;
+  }
+  auto sketch = util::topk_merge_sketch(sketch_values, ncpus_);
+
+  std::vector<std::pair<KeyType, uint64_t>> estimates_by_key;
+  for (const auto &[key, value] : *candidates) {
+    auto hash = util::read_data<uint64_t>(value.data());
+    estimates_by_key.emplace_back(key, util::topk_estimate(sketch, hash));
+  }
+  std::ranges::sort(estimates_by_key,
+                    [&](auto &a, auto &b) { return a.second < b.second; });
+
+  // Only the k heaviest keys are reported, print() can narrow this further.
+  if (top == 0 || top > k)
+    top = k;
+
+  out.map_topk(
+      *this, map, top, estimates_by_key, util::topk_error_bound(sketch));
+  return 0;
+}
+
 std::optional<std::string> BPFtrace::get_watchpoint_binary_path() const
 {
   if (child_) {
@@ -1189,23 +1442,77 @@ std::string BPFtrace::get_stack(int64_t stackid,
                                 bool ustack,
                                 StackType stack_type,
                                 int indent)
+{
+  auto stack_trace = read_stack(stackid, nr_stack_frames, pid, stack_type);
+  if (!stack_trace)
+    return "";
+
+  // All frames of a stack belong to the same process, look it up only once.
+  std::shared_ptr<const ProcessSnapshot> process;
+  if (ustack && stack_type.mode != StackMode::raw &&
+      stack_type.mode != StackMode::build_id)
+    process = resolve_process(pid, probe_id);
+
+  return format_stack(*stack_trace,
+                      nr_stack_frames,
+                      pid,
+                      process.get(),
+                      ustack,
+                      stack_type,
+                      indent,
+                      ksyms_,
+                      usyms_);
+}
+
+std::optional<std::vector<uint64_t>> BPFtrace::read_stack(
+    int64_t stackid,
+    uint32_t nr_stack_frames,
+    int32_t pid,
+    StackType stack_type) const
 {
   struct stack_key stack_key = { .stackid = stackid,
                                  .nr_stack_frames = nr_stack_frames };
-  auto stack_trace = std::vector<uint64_t>(stack_type.limit);
+  auto stack_trace = std::vector<uint64_t>(stack_type.value_words());
   auto map = bytecode_.getMap(stack_type.name());
   auto ok = map.lookup_elem(&stack_key, stack_trace.data());
   if (!ok) {
     LOG(ERROR) << "failed to look up stack id: " << stackid
                << " stack length: " << nr_stack_frames << " (pid " << pid
                << "): " << ok.takeError();
-    return "";
+    return std::nullopt;
   }
+  return stack_trace;
+}
 
+std::string BPFtrace::format_stack(const std::vector<uint64_t> &stack_trace,
+                                   uint32_t nr_stack_frames,
+                                   int32_t pid,
+                                   const ProcessSnapshot *process,
+                                   bool ustack,
+                                   StackType stack_type,
+                                   int indent,
+                                   Ksyms &ksyms,
+                                   Usyms &usyms) const
+{
   std::ostringstream stack;
   std::string padding(indent, ' ');
 
   stack << "\n";
+  if (stack_type.mode == StackMode::build_id) {
+    // Left for OfflineSymbolizer, nothing is resolved here.
+    for (uint32_t i = 0; i < nr_stack_frames; ++i) {
+      if (ustack) {
+        BuildIdFrame frame;
+        memcpy(&frame, &stack_trace.at(4 * i), sizeof(frame));
+        stack << padding << format_build_id_frame(frame) << std::endl;
+      } else {
+        stack << padding << format_kernel_frame(stack_trace.at(i))
+              << std::endl;
+      }
+    }
+    return stack.str();
+  }
+
   for (uint32_t i = 0; i < nr_stack_frames;) {
     uint64_t addr = stack_trace.at(i);
     if (stack_type.mode == StackMode::raw) {
@@ -1215,17 +1522,17 @@ std::string BPFtrace::get_stack(int64_t stackid,
     }
     std::vector<std::string> syms;
     if (!ustack)
-      syms = resolve_ksym_stack(addr,
-                                true,
-                                stack_type.mode == StackMode::perf,
-                                config_->show_debug_info);
+      syms = ksyms.resolve(addr,
+                           true,
+                           stack_type.mode == StackMode::perf,
+                           config_->show_debug_info);
     else
-      syms = resolve_usym_stack(addr,
-                                pid,
-                                probe_id,
-                                true,
-                                stack_type.mode == StackMode::perf,
-                                config_->show_debug_info);
+      syms = usyms.resolve(addr,
+                           pid,
+                           *process,
+                           true,
+                           stack_type.mode == StackMode::perf,
+                           config_->show_debug_info);
 
     std::string sym;
     for (size_t sym_idx = 0; i < nr_stack_frames && sym_idx < syms.size();) {
@@ -1239,8 +1546,9 @@ std::string BPFtrace::get_stack(int64_t stackid,
                 << std::endl;
           break;
         case StackMode::raw:
-          LOG(BUG) << "StackMode::raw should have been processed before "
-                      "symbolication.";
+        case StackMode::build_id:
+          LOG(BUG) << "StackMode::" << STACK_MODE_NAME_MAP.at(stack_type.mode)
+                   << " should have been processed before symbolication.";
           break;
       }
       ++i;
@@ -1471,8 +1779,10 @@ std::string BPFtrace::resolve_mac_address(const uint8_t *mac_addr) const
 std::string BPFtrace::resolve_cgroup_path(uint64_t cgroup_path_id,
                                           uint64_t cgroup_id) const
 {
+  if (!cgroup_roots_)
+    cgroup_roots_ = util::get_cgroup_hierarchy_roots();
   auto paths = util::get_cgroup_paths(
-      cgroup_id, resources.cgroup_path_args[cgroup_path_id]);
+      cgroup_id, resources.cgroup_path_args[cgroup_path_id], *cgroup_roots_);
   std::stringstream result;
   for (auto &pair : paths) {
     if (pair.second.empty())
@@ -1520,22 +1830,59 @@ std::string BPFtrace::resolve_inet(int af, const uint8_t *inet) const
 
 std::string BPFtrace::resolve_usym(uint64_t addr, int32_t pid, int32_t probe_id)
 {
-  auto syms = resolve_usym_stack(addr, pid, probe_id, false, false, false);
+  auto syms = resolve_usym_stack(
+      addr, pid, *resolve_process(pid, probe_id), false, false, false);
   assert(syms.size() == 1);
   return syms.front();
 }
 
-std::vector<std::string> BPFtrace::resolve_usym_stack(uint64_t addr,
-                                                      int32_t pid,
-                                                      int32_t probe_id,
-                                                      bool show_offset,
-                                                      bool perf_mode,
-                                                      bool show_debug_info)
+std::shared_ptr<const ProcessSnapshot> BPFtrace::resolve_process(
+    int32_t pid,
+    int32_t probe_id)
 {
-  std::string pid_exe;
+  auto now = std::chrono::steady_clock::now();
+  auto cached = process_cache_.find(pid);
+  if (cached != process_cache_.end() &&
+      now - cached->second.checked < PROCESS_RECHECK_INTERVAL)
+    return cached->second.snapshot;
+
+  auto start_time = util::get_pid_start_time(pid);
   auto res = util::get_pid_exe(pid);
+  if (cached != process_cache_.end()) {
+    // A process that is gone is kept as it was. It is the same process if it
+    // has the same start time and has not exec-ed since, its executable
+    // cannot be read anymore while it exits.
+    const auto &snapshot = *cached->second.snapshot;
+    if (!start_time || (*start_time == snapshot.start_time &&
+                        (!res || *res == snapshot.exe))) {
+      cached->second.checked = now;
+      return cached->second.snapshot;
+    }
+  }
+
+  if (res && start_time) {
+    auto snapshot = std::make_shared<ProcessSnapshot>();
+    snapshot->exe = *res;
+    snapshot->start_time = *start_time;
+    snapshot->mappings = util::get_exec_mappings(pid);
+    for (const auto &mapping : snapshot->mappings)
+      snapshot->build_ids.push_back(util::get_elf_build_id(mapping.path));
+
+    auto [_, inserted] = process_cache_.insert_or_assign(
+        pid, CachedProcess{ .snapshot = snapshot, .checked = now });
+    if (inserted) {
+      process_order_.push_back(pid);
+      if (process_order_.size() > MAX_PROCESS_CACHE_SIZE) {
+        process_cache_.erase(process_order_.front());
+        process_order_.pop_front();
+      }
+    }
+    return snapshot;
+  }
+
+  auto snapshot = std::make_shared<ProcessSnapshot>();
   if (res) {
-    pid_exe = *res;
+    snapshot->exe = *res;
   } else if (probe_id != -1) {
     // sometimes program cannot be determined from PID, typically when the
     // process does not exist anymore; in that case, try to get program name
@@ -1549,11 +1896,22 @@ std::vector<std::string> BPFtrace::resolve_usym_stack(uint64_t addr,
       // to avoid incorrect symbol resolutions
       size_t start = probe_full.find(':') + 1;
       size_t end = probe_full.find(':', start);
-      pid_exe = probe_full.substr(start, end - start);
+      snapshot->exe = probe_full.substr(start, end - start);
     }
   }
+  return snapshot;
+}
+
+std::vector<std::string> BPFtrace::resolve_usym_stack(
+    uint64_t addr,
+    int32_t pid,
+    const ProcessSnapshot &process,
+    bool show_offset,
+    bool perf_mode,
+    bool show_debug_info)
+{
   return usyms_.resolve(
-      addr, pid, pid_exe, show_offset, perf_mode, show_debug_info);
+      addr, pid, process, show_offset, perf_mode, show_debug_info);
 }
 
 std::string BPFtrace::resolve_probe(uint64_t probe_id) const
@@ -1725,7 +2083,7 @@ Dwarf *BPFtrace::get_dwarf(const ast::AttachPoint &attachpoint)
 
 int BPFtrace::create_pcaps()
 {
-  for (auto arg : resources.skboutput_args_) {
+  for (const auto &arg : resources.skboutput_args_) {
     auto file = std::get<0>(arg);
 
     if (pcap_writers_.contains(file)) {
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
 #include <bcc/bcc_syms.h>
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
@@ -33,6 +37,7 @@
 #include "procmon.h"
 #include "required_resources.h"
 #include "struct.h"
+#include "symbolizer_pool.h"
 #include "types.h"
 #include "usyms.h"
 #include "util/cpus.h"
@@ -50,6 +55,23 @@ struct stack_key {
   int64_t nr_stack_frames;
 };
 
+// An argument of BPFtrace::get_arg_values() whose symbolization was left to
+// the caller. The value at index is a placeholder for the result of resolve.
+struct DeferredArg {
+  using Resolve = std::function<std::string(Ksyms &, Usyms &)>;
+  size_t index;
+  Resolve resolve;
+};
+
+// The cgroup given with --cgroup. Only tasks in this cgroup2 cgroup or in its
+// descendants are traced.
+struct CgroupFilter {
+  std::string path;
+  uint64_t id;
+  // Depth below the root of the cgroup2 hierarchy, the root is level 0.
+  int level;
+};
+
 enum class DebugStage;
 
 // globals
@@ -65,7 +87,8 @@ enum class DebugStage {
   CodegenOpt,
   Disassemble,
   Libbpf,
-  Verifier
+  Verifier,
+  Timing
 };
 
 const std::unordered_map<std::string_view, DebugStage> debug_stages = {
@@ -79,6 +102,7 @@ const std::unordered_map<std::string_view, DebugStage> debug_stages = {
 #endif
   { "libbpf", DebugStage::Libbpf },
   { "verifier", DebugStage::Verifier },
+  { "timing", DebugStage::Timing },
   // clang-format on
 };
 
@@ -120,12 +144,15 @@ public:
                                      const ast::Probe &probe);
   int num_probes() const;
   int prerun() const;
+  // Loads the programs and maps into the kernel, without attaching them.
+  int load_bytecode(BpfBytecode bytecode);
   int run(Output &out, BpfBytecode bytecode);
   virtual Result<std::unique_ptr<AttachedProbe>> attach_probe(
       Probe &probe,
       const BpfBytecode &bytecode);
   int run_iter();
   int print_maps(Output &out);
+  void print_prog_stats(Output &out);
   int print_map(Output &out, const BpfMap &map, uint32_t top, uint32_t div);
   std::string get_stack(int64_t stackid,
                         uint32_t nr_stack_frames,
@@ -157,10 +184,14 @@ public:
   std::string resolve_cgroup_path(uint64_t cgroup_path_id,
                                   uint64_t cgroup_id) const;
   std::string resolve_probe(uint64_t probe_id) const;
+  // Resolves symbols and stacks in args, unless deferred is given, in which
+  // case that is left to the caller.
   std::vector<std::unique_ptr<IPrintable>> get_arg_values(
       Output &output,
       const std::vector<Field> &args,
-      uint8_t *arg_data);
+      uint8_t *arg_data,
+      size_t size,
+      std::vector<DeferredArg> *deferred = nullptr);
   void add_param(const std::string &param);
   std::string get_param(size_t index) const;
   size_t num_params() const;
@@ -199,6 +230,10 @@ public:
   const util::FuncsModulesMap &get_raw_tracepoints() const;
   util::KConfig kconfig;
   std::vector<std::unique_ptr<AttachedProbe>> attached_probes_;
+  UprobeResolveStats uprobe_resolve_stats_;
+  // Symbolizes printf() arguments off the event loop, only while running and
+  // if symbolication_threads is set.
+  std::unique_ptr<SymbolizerPool> symbolizer_pool_;
   std::vector<int> sigusr1_prog_fds_;
 
   unsigned int join_argnum_ = 16;
@@ -210,12 +245,15 @@ public:
   bool safe_mode_ = true;
   bool has_usdt_ = false;
   bool usdt_file_activation_ = false;
+  // Print per-program statistics at exit and on SIGUSR1 (--stats).
+  bool prog_stats_ = false;
   int helper_check_level_ = 1;
   uint64_t max_ast_nodes_ = std::numeric_limits<uint64_t>::max();
   bool debug_output_ = false;
   std::optional<struct timespec> boottime_;
   std::optional<struct timespec> delta_taitime_;
   bool need_recursion_check_ = false;
+  std::optional<CgroupFilter> cgroup_filter_;
 
   static void sort_by_key(
       const SizedType &key,
@@ -242,6 +280,19 @@ public:
 private:
   Ksyms ksyms_;
   Usyms usyms_;
+  // Snapshot of every process seen in a user stack or symbol. Keeps
+  // symbolization working for processes that exited before their events were
+  // printed. Lookups do not touch procfs, an entry is only checked again for
+  // exec() or a reused pid once PROCESS_RECHECK_INTERVAL has passed. The
+  // oldest entries are evicted first.
+  struct CachedProcess {
+    std::shared_ptr<const ProcessSnapshot> snapshot;
+    std::chrono::steady_clock::time_point checked;
+  };
+  static constexpr size_t MAX_PROCESS_CACHE_SIZE = 16384;
+  static constexpr auto PROCESS_RECHECK_INTERVAL = std::chrono::seconds(1);
+  std::unordered_map<int32_t, CachedProcess> process_cache_;
+  std::deque<int32_t> process_order_;
   std::vector<std::string> params_;
 
   std::vector<std::unique_ptr<void, void (*)(void *)>> open_perf_buffers_;
@@ -256,9 +307,24 @@ private:
                                               bool show_offset,
                                               bool perf_mode,
                                               bool show_debug_info);
+  std::shared_ptr<const ProcessSnapshot> resolve_process(int32_t pid,
+                                                         int32_t probe_id);
+  std::optional<std::vector<uint64_t>> read_stack(int64_t stackid,
+                                                  uint32_t nr_stack_frames,
+                                                  int32_t pid,
+                                                  StackType stack_type) const;
+  std::string format_stack(const std::vector<uint64_t> &stack_trace,
+                           uint32_t nr_stack_frames,
+                           int32_t pid,
+                           const ProcessSnapshot *process,
+                           bool ustack,
+                           StackType stack_type,
+                           int indent,
+                           Ksyms &ksyms,
+                           Usyms &usyms) const;
   std::vector<std::string> resolve_usym_stack(uint64_t addr,
                                               int32_t pid,
-                                              int32_t probe_id,
+                                              const ProcessSnapshot &process,
                                               bool show_offset,
                                               bool perf_mode,
                                               bool show_debug_info);
@@ -271,6 +337,7 @@ private:
                      uint32_t top,
                      uint32_t div);
   int print_map_tseries(Output &out, const BpfMap &map);
+  int print_map_topk(Output &out, const BpfMap &map, uint32_t top);
   static uint64_t read_address_from_output(std::string output);
   struct bcc_symbol_option &get_symbol_opts();
   Probe generate_probe(const ast::AttachPoint &ap,
@@ -278,6 +345,8 @@ private:
                        int usdt_location_idx = 0);
   bool has_iter_ = false;
   int epollfd_ = -1;
+  // Keeps BPF run time statistics enabled, if --stats asked for them.
+  int run_stats_fd_ = -1;
   struct ring_buffer *ringbuf_ = nullptr;
   uint64_t event_loss_count_ = 0;
 
@@ -286,6 +355,9 @@ private:
   // functions.
   mutable util::FuncsModulesMap traceable_funcs_;
   mutable util::FuncsModulesMap raw_tracepoints_;
+  // cgroup hierarchy mount points, read on the first cgroup_path().
+  mutable std::optional<std::array<std::vector<std::string>, 2>>
+      cgroup_roots_;
   std::unordered_map<std::string, std::unique_ptr<Dwarf>> dwarves_;
 };
 
@@ -32,6 +32,7 @@
 #include "probe_matcher.h"
 #include "tracefs/tracefs.h"
 #include "types.h"
+#include "util/timing.h"
 
 namespace bpftrace {
 
@@ -67,6 +68,7 @@ void BTF::load_vmlinux_btf()
     return;
   }
   state = ERROR;
+  util::TimingSpan span("btf", "vmlinux");
   // Try to get BTF file from BPFTRACE_BTF env
   char *path = std::getenv("BPFTRACE_BTF");
   if (path) {
@@ -134,6 +136,7 @@ void BTF::load_module_btfs(const std::set<std::string> &modules)
   load_vmlinux_btf();
   if ((bpftrace_ && !has_module_btf()) || state != VMLINUX_LOADED)
     return;
+  util::TimingSpan span("btf", "modules");
 
   // Note that we cannot parse BTFs from /sys/kernel/btf/ as we need BTF object
   // IDs, so the only way is to iterate through all loaded BTF objects
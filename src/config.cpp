@@ -269,12 +269,15 @@ const std::map<std::string, AnyParser> CONFIG_KEY_MAP = {
   { "max_bpf_progs", CONFIG_FIELD_PARSER(max_bpf_progs) },
   { "max_cat_bytes", CONFIG_FIELD_PARSER(max_cat_bytes) },
   { "max_map_keys", CONFIG_FIELD_PARSER(max_map_keys) },
+  { "max_map_memory", CONFIG_FIELD_PARSER(max_map_memory) },
   { "max_probes", CONFIG_FIELD_PARSER(max_probes) },
   { "max_strlen", CONFIG_FIELD_PARSER(max_strlen) },
   { "on_stack_limit", CONFIG_FIELD_PARSER(on_stack_limit) },
   { "perf_rb_pages", CONFIG_FIELD_PARSER(perf_rb_pages) },
   { "stack_mode", CONFIG_FIELD_PARSER(stack_mode) },
   { "str_trunc_trailer", CONFIG_FIELD_PARSER(str_trunc_trailer) },
+  { "symbolication_threads", CONFIG_FIELD_PARSER(symbolication_threads) },
+  { "upgrade_probes", CONFIG_FIELD_PARSER(upgrade_probes) },
   { "missing_probes", CONFIG_FIELD_PARSER(missing_probes) },
   { "print_maps_on_exit", CONFIG_FIELD_PARSER(print_maps_on_exit) },
   { "use_blazesym", CONFIG_FIELD_PARSER(use_blazesym) },
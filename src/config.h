@@ -43,6 +43,7 @@ public:
   bool cpp_demangle = true;
   bool lazy_symbolication = true;
   bool print_maps_on_exit = true;
+  bool upgrade_probes = false;
   ConfigUnstable unstable_macro = ConfigUnstable::warn;
   ConfigUnstable unstable_map_decl = ConfigUnstable::warn;
   ConfigUnstable unstable_import = ConfigUnstable::error;
@@ -58,10 +59,12 @@ public:
   uint64_t max_bpf_progs = 1024;
   uint64_t max_cat_bytes = 10240;
   uint64_t max_map_keys = 4096;
+  uint64_t max_map_memory = 0;
   uint64_t max_probes = 1024;
   uint64_t max_strlen = 1024;
   uint64_t on_stack_limit = 32;
   uint64_t perf_rb_pages = 64;
+  uint64_t symbolication_threads = 0;
   std::string license = "GPL";
   std::string str_trunc_trailer = "..";
   ConfigMissingProbes missing_probes = ConfigMissingProbes::error;
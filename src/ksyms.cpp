@@ -7,6 +7,7 @@
 
 #include "ksyms.h"
 #include "scopeguard.h"
+#include "util/timing.h"
 
 namespace {
 std::string stringify_addr(uint64_t addr)
@@ -93,6 +94,31 @@ std::string Ksyms::resolve_bcc(uint64_t addr, bool show_offset)
   return stringify_addr(addr);
 }
 
+const util::KallsymsIndex *Ksyms::kallsyms()
+{
+  if (!kallsyms_loaded_) {
+    util::TimingSpan span("symbols", "kallsyms");
+    kallsyms_loaded_ = kallsyms_.load();
+  }
+  return *kallsyms_loaded_ ? &kallsyms_ : nullptr;
+}
+
+std::string Ksyms::resolve_kallsyms(uint64_t addr, bool show_offset)
+{
+  auto sym = kallsyms_.lookup(addr);
+  // The address may belong to a module loaded after the index was built.
+  if (!sym && kallsyms_.reload_if_modules_changed())
+    sym = kallsyms_.lookup(addr);
+  if (!sym)
+    return stringify_addr(addr);
+
+  std::ostringstream symbol;
+  symbol << sym->name;
+  if (show_offset)
+    symbol << "+" << addr - sym->start;
+  return symbol.str();
+}
+
 #ifdef HAVE_BLAZESYM
 std::vector<std::string> Ksyms::resolve_blazesym_impl(uint64_t addr,
                                                       bool show_offset,
@@ -175,14 +201,40 @@ std::vector<std::string> Ksyms::resolve_blazesym(uint64_t addr,
 #endif
 
 std::vector<std::string> Ksyms::resolve(uint64_t addr,
+                                        bool show_offset,
+                                        bool perf_mode,
+                                        bool show_debug_info)
+{
+#ifdef HAVE_BLAZESYM
+  if (config_.use_blazesym)
+    return resolve(
+        Backend::blazesym, addr, show_offset, perf_mode, show_debug_info);
+#endif
+  if (kallsyms())
+    return resolve(
+        Backend::kallsyms, addr, show_offset, perf_mode, show_debug_info);
+  return resolve(Backend::bcc, addr, show_offset, perf_mode, show_debug_info);
+}
+
+std::vector<std::string> Ksyms::resolve(Backend backend,
+                                        uint64_t addr,
                                         bool show_offset,
                                         [[maybe_unused]] bool perf_mode,
                                         [[maybe_unused]] bool show_debug_info)
 {
+  switch (backend) {
+    case Backend::kallsyms:
+      if (kallsyms())
+        return std::vector<std::string>{ resolve_kallsyms(addr, show_offset) };
+      break;
+    case Backend::blazesym:
 #ifdef HAVE_BLAZESYM
-  if (config_.use_blazesym)
-    return resolve_blazesym(addr, show_offset, perf_mode, show_debug_info);
+      return resolve_blazesym(addr, show_offset, perf_mode, show_debug_info);
 #endif
+      break;
+    case Backend::bcc:
+      break;
+  }
   return std::vector<std::string>{ resolve_bcc(addr, show_offset) };
 }
 
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "config.h"
+#include "util/kallsyms.h"
 
 namespace bpftrace {
 class Config;
@@ -16,14 +17,33 @@ public:
   Ksyms(Ksyms &) = delete;
   Ksyms &operator=(const Ksyms &) = delete;
 
+  enum class Backend {
+    kallsyms,
+    bcc,
+    blazesym,
+  };
+
+  // Symbols are resolved with the in-process kallsyms index. The other
+  // backends are only used when it is not available, or for benchmarking.
   std::vector<std::string> resolve(uint64_t addr,
                                    bool show_offset,
                                    bool perf_mode,
                                    bool show_debug_info);
+  std::vector<std::string> resolve(Backend backend,
+                                   uint64_t addr,
+                                   bool show_offset,
+                                   bool perf_mode,
+                                   bool show_debug_info);
+
+  // Returns the kallsyms index, loading it on first use, or nullptr if
+  // kallsyms is not readable.
+  const util::KallsymsIndex *kallsyms();
 
 private:
   const Config &config_;
   void *ksyms_{ nullptr };
+  util::KallsymsIndex kallsyms_;
+  std::optional<bool> kallsyms_loaded_;
 
 #ifdef HAVE_BLAZESYM
   struct blaze_symbolizer *symbolizer_{ nullptr };
@@ -39,5 +59,6 @@ private:
 #endif
 
   std::string resolve_bcc(uint64_t addr, bool show_offset);
+  std::string resolve_kallsyms(uint64_t addr, bool show_offset);
 };
 } // namespace bpftrace
@@ -45,14 +45,19 @@
 #include "globalvars.h"
 #include "lockdown.h"
 #include "log.h"
+#include "offline_symbolizer.h"
 #include "output.h"
 #include "probe_matcher.h"
 #include "procmon.h"
 #include "run_bpftrace.h"
+#include "scopeguard.h"
+#include "util/cgroup.h"
 #include "util/env.h"
+#include "util/exceptions.h"
 #include "util/int_parser.h"
 #include "util/kernel.h"
 #include "util/strings.h"
+#include "util/timing.h"
 #include "version.h"
 
 using namespace bpftrace;
@@ -69,6 +74,9 @@ enum class TestMode {
   NONE = 0,
   CODEGEN,
   BENCHMARK,
+  KSYMS_BENCHMARK,
+  CGROUP_BENCHMARK,
+  PROBE_BENCHMARK,
 };
 
 enum class BuildMode {
@@ -94,6 +102,9 @@ enum Options {
   NO_FEATURE,
   DEBUG,
   DRY_RUN,
+  SYMBOLIZE,
+  CGROUP,
+  STATS,
 };
 
 constexpr auto FULL_SEARCH = "*:*";
@@ -120,6 +131,7 @@ void usage(std::ostream& out)
   out << "                   list kernel probes or probes in a program" << std::endl;
   out << "    -p PID         filter actions and enable USDT probes on PID" << std::endl;
   out << "    -c 'CMD'       run CMD and enable USDT probes on resulting process" << std::endl;
+  out << "    --cgroup PATH  only trace tasks in the cgroup2 cgroup PATH and below it" << std::endl;
   out << "    --no-feature FEATURE[,FEATURE]" << std::endl;
   out << "                   disable use of detected features" << std::endl;
   out << "    --usdt-file-activation" << std::endl;
@@ -130,12 +142,15 @@ void usage(std::ostream& out)
   out << "    -k             emit a warning when probe read helpers return an error" << std::endl;
   out << "    -V, --version  bpftrace version" << std::endl;
   out << "    --no-warnings  disable all warning messages" << std::endl;
+  out << "    --stats        print verifier and run time statistics per probe at exit and on SIGUSR1" << std::endl;
+  out << "    --symbolize DIR [FILE]" << std::endl;
+  out << "                   symbolize build_id stacks in FILE or stdin with binaries in DIR" << std::endl;
   out << std::endl;
   out << "TROUBLESHOOTING OPTIONS:" << std::endl;
   out << "    -v                      verbose messages" << std::endl;
   out << "    --dry-run               terminate execution right after attaching all the probes" << std::endl;
   out << "    -d STAGE                debug info for various stages of bpftrace execution" << std::endl;
-  out << "                            ('all', 'ast', 'codegen', 'codegen-opt', 'dis', 'libbpf', 'verifier')" << std::endl;
+  out << "                            ('all', 'ast', 'codegen', 'codegen-opt', 'dis', 'libbpf', 'verifier', 'timing')" << std::endl;
   out << "    --emit-elf FILE         (dry run) generate ELF file with bpf programs and write to FILE" << std::endl;
   out << "    --emit-llvm FILE        write LLVM IR to FILE.original.ll and FILE.optimized.ll" << std::endl;
   out << std::endl;
@@ -301,10 +316,12 @@ std::vector<std::string> extra_flags(
 
 struct Args {
   std::string pid_str;
+  std::string cgroup_path;
   std::string cmd_str;
   bool listing = false;
   bool safe_mode = true;
   bool usdt_file_activation = false;
+  bool stats = false;
   int helper_check_level = 1;
   bool no_warnings = false;
   TestMode test_mode = TestMode::NONE;
@@ -316,6 +333,7 @@ struct Args {
   std::string output_elf;
   std::string output_llvm;
   std::string aot;
+  std::string symbolize_dir;
   BPFnofeature no_feature;
   OutputBufferConfig obc = OutputBufferConfig::UNSET;
   BuildMode build_mode = BuildMode::DYNAMIC;
@@ -369,8 +387,10 @@ static bool parse_debug_stages(const std::string& arg)
     if (debug_stages.contains(stage)) {
       bt_debug.insert(debug_stages.at(stage));
     } else if (stage == "all") {
+      // Timing writes a file instead of printing, so it is not included.
       for (const auto& [_, s] : debug_stages)
-        bt_debug.insert(s);
+        if (s != DebugStage::Timing)
+          bt_debug.insert(s);
     } else {
       LOG(ERROR) << "USAGE: invalid option for -d: " << stage;
       return false;
@@ -446,6 +466,18 @@ Args parse_args(int argc, char* argv[])
             .has_arg = no_argument,
             .flag = nullptr,
             .val = Options::DRY_RUN },
+    option{ .name = "symbolize",
+            .has_arg = required_argument,
+            .flag = nullptr,
+            .val = Options::SYMBOLIZE },
+    option{ .name = "cgroup",
+            .has_arg = required_argument,
+            .flag = nullptr,
+            .val = Options::CGROUP },
+    option{ .name = "stats",
+            .has_arg = no_argument,
+            .flag = nullptr,
+            .val = Options::STATS },
     option{ .name = nullptr, .has_arg = 0, .flag = nullptr, .val = 0 }, // Must
                                                                         // be
                                                                         // last
@@ -477,8 +509,15 @@ Args parse_args(int argc, char* argv[])
           args.test_mode = TestMode::CODEGEN;
         } else if (std::strcmp(optarg, "benchmark") == 0)
           args.test_mode = TestMode::BENCHMARK;
+        else if (std::strcmp(optarg, "ksyms") == 0)
+          args.test_mode = TestMode::KSYMS_BENCHMARK;
+        else if (std::strcmp(optarg, "cgroup") == 0)
+          args.test_mode = TestMode::CGROUP_BENCHMARK;
+        else if (std::strcmp(optarg, "probes") == 0)
+          args.test_mode = TestMode::PROBE_BENCHMARK;
         else {
-          LOG(ERROR) << "USAGE: --test can only be 'codegen'.";
+          LOG(ERROR) << "USAGE: --test can only be 'codegen', 'benchmark', "
+                        "'ksyms', 'cgroup' or 'probes'.";
           exit(1);
         }
         break;
@@ -489,13 +528,16 @@ Args parse_args(int argc, char* argv[])
       case Options::NO_FEATURE: // --no-feature
         if (args.no_feature.parse(optarg)) {
           LOG(ERROR) << "USAGE: --no-feature can only have values "
-                        "'kprobe_multi,kprobe_session,uprobe_multi'.";
+                        "'kprobe_multi,kprobe_session,uprobe_multi,global_func'.";
           exit(1);
         }
         break;
       case Options::DRY_RUN:
         dry_run = true;
         break;
+      case Options::SYMBOLIZE:
+        args.symbolize_dir = optarg;
+        break;
       case 'o':
         args.output_file = optarg;
         break;
@@ -532,6 +574,9 @@ Args parse_args(int argc, char* argv[])
       case 'p':
         args.pid_str = optarg;
         break;
+      case Options::CGROUP: // --cgroup
+        args.cgroup_path = optarg;
+        break;
       case 'I':
         args.include_dirs.emplace_back(optarg);
         break;
@@ -550,6 +595,9 @@ Args parse_args(int argc, char* argv[])
       case Options::UNSAFE:
         args.safe_mode = false;
         break;
+      case Options::STATS:
+        args.stats = true;
+        break;
       case 'b':
       case Options::BTF:
         break;
@@ -597,6 +645,29 @@ Args parse_args(int argc, char* argv[])
     exit(1);
   }
 
+  // The cgroup id is only valid on this machine, until the cgroup is removed.
+  if (!args.cgroup_path.empty() &&
+      args.build_mode == BuildMode::AHEAD_OF_TIME) {
+    LOG(ERROR) << "Cannot use --cgroup with --aot";
+    exit(1);
+  }
+
+  // The kernel symbols and cgroup benchmarks do not need a program.
+  if (args.test_mode == TestMode::KSYMS_BENCHMARK ||
+      args.test_mode == TestMode::CGROUP_BENCHMARK)
+    return args;
+
+  // The symbolizer reads output of an earlier run, not a program.
+  if (!args.symbolize_dir.empty()) {
+    if (optind < argc - 1) {
+      LOG(ERROR) << "USAGE: --symbolize takes at most one input file";
+      exit(1);
+    }
+    if (optind == argc - 1 && std::string(argv[optind]) != "-")
+      args.filename = argv[optind];
+    return args;
+  }
+
   if (args.listing) {
     // Expect zero or one positional arguments
     if (optind == argc) {
@@ -680,10 +751,67 @@ static ast::ASTContext buildListProgram(const std::string& search)
   return ast;
 }
 
+static int symbolize(const Args& args, std::ostream& out)
+{
+  // A snapshot next to the binaries wins over the one of the current boot,
+  // the stacks were likely recorded on another machine.
+  std::optional<std::filesystem::path> kallsyms =
+      std::filesystem::path(args.symbolize_dir) / "kallsyms";
+  std::error_code ec;
+  if (!std::filesystem::exists(*kallsyms, ec))
+    kallsyms = kallsyms_snapshot_path();
+
+  OfflineSymbolizer symbolizer(args.symbolize_dir, kallsyms);
+  if (!symbolizer.has_kallsyms())
+    LOG(WARNING) << "No kernel symbols found, kernel frames will not be "
+                    "symbolized";
+
+  if (args.filename.empty()) {
+    symbolizer.symbolize(std::cin, out);
+    return 0;
+  }
+  std::ifstream in(args.filename);
+  if (in.fail()) {
+    LOG(ERROR) << "Failed to open input file: \"" << args.filename
+               << "\": " << strerror(errno);
+    return 1;
+  }
+  symbolizer.symbolize(in, out);
+  return 0;
+}
+
+// Writes the spans recorded with -d timing as a Chrome trace and prints the
+// total time of every stage.
+static void write_timing()
+{
+  const auto& timeline = util::timeline();
+  if (timeline.empty())
+    return;
+
+  std::string path = "bpftrace-timing-" + std::to_string(getpid()) + ".json";
+  if (const char* env = std::getenv("BPFTRACE_TIMING_FILE"))
+    path = env;
+  std::ofstream out(path);
+  timeline.write_trace(out);
+  if (out)
+    std::cerr << "Timing trace written to " << path << std::endl;
+  else
+    LOG(WARNING) << "Failed to write timing trace to " << path;
+
+  std::cerr << "Timing totals per stage (ms, spans):" << std::endl;
+  timeline.print_totals(std::cerr);
+}
+
 int main(int argc, char* argv[])
 {
   Log::get().set_colorize(is_colorize());
   Args args = parse_args(argc, argv);
+  if (bt_debug.contains(DebugStage::Timing))
+    util::enable_timing();
+  SCOPE_EXIT
+  {
+    write_timing();
+  };
   std::ostream* os = &std::cout;
   std::ofstream outputstream;
   if (!args.output_file.empty()) {
@@ -696,6 +824,9 @@ int main(int argc, char* argv[])
     os = &outputstream;
   }
 
+  if (!args.symbolize_dir.empty())
+    return symbolize(args, *os);
+
   switch (args.obc) {
     case OutputBufferConfig::UNSET:
     case OutputBufferConfig::LINE:
@@ -723,11 +854,33 @@ int main(int argc, char* argv[])
                          [&](bool x) { bpftrace.debug_output_ = x; });
 
   bpftrace.usdt_file_activation_ = args.usdt_file_activation;
+  bpftrace.prog_stats_ = args.stats;
   bpftrace.safe_mode_ = args.safe_mode;
   bpftrace.helper_check_level_ = args.helper_check_level;
   bpftrace.boottime_ = get_boottime();
   bpftrace.delta_taitime_ = get_delta_taitime();
 
+  if (args.test_mode == TestMode::KSYMS_BENCHMARK) {
+    Ksyms ksyms(*bpftrace.config_);
+    BenchmarkReport report(std::cout, args.output_format == "json");
+    auto ok = benchmark_ksyms(report, ksyms);
+    if (!ok) {
+      std::cerr << "Benchmark error: " << ok.takeError();
+      return 1;
+    }
+    return 0;
+  }
+
+  if (args.test_mode == TestMode::CGROUP_BENCHMARK) {
+    BenchmarkReport report(std::cout, args.output_format == "json");
+    auto ok = benchmark_cgroup(report, bpftrace);
+    if (!ok) {
+      std::cerr << "Benchmark error: " << ok.takeError();
+      return 1;
+    }
+    return 0;
+  }
+
   if (!args.pid_str.empty()) {
     auto maybe_pid = util::to_uint(args.pid_str);
     if (!maybe_pid) {
@@ -750,6 +903,25 @@ int main(int argc, char* argv[])
     }
   }
 
+  if (!args.cgroup_path.empty()) {
+    auto level = util::get_cgroup_level(args.cgroup_path);
+    if (!level) {
+      LOG(ERROR) << "--cgroup: " << args.cgroup_path
+                 << " is not a directory in a cgroup2 hierarchy";
+      exit(1);
+    }
+    try {
+      bpftrace.cgroup_filter_ = CgroupFilter{
+        .path = args.cgroup_path,
+        .id = util::resolve_cgroupid(args.cgroup_path),
+        .level = *level,
+      };
+    } catch (const util::FatalUserException& e) {
+      LOG(ERROR) << e.what();
+      exit(1);
+    }
+  }
+
   if (!args.cmd_str.empty()) {
     bpftrace.cmd_ = args.cmd_str;
     try {
@@ -973,8 +1145,11 @@ int main(int argc, char* argv[])
   pm.add(ast::CreateLinkPass());
 
   if (args.test_mode == TestMode::BENCHMARK) {
-    info(args.no_feature);
-    auto ok = benchmark(std::cout, pm);
+    bool json = args.output_format == "json";
+    if (!json)
+      info(args.no_feature);
+    BenchmarkReport report(std::cout, json);
+    auto ok = benchmark(report, pm, bpftrace);
     if (!ok) {
       std::cerr << "Benchmark error: " << ok.takeError();
       return 1;
@@ -1005,6 +1180,18 @@ int main(int argc, char* argv[])
   if (args.test_mode == TestMode::CODEGEN)
     return 0;
 
+  if (args.test_mode == TestMode::PROBE_BENCHMARK) {
+    auto& bytecode = pmresult->get<BpfBytecode>();
+    BenchmarkReport report(std::cout, args.output_format == "json");
+    auto ok = benchmark_probes(
+        report, bpftrace, bytecode, std::move(args.named_params));
+    if (!ok) {
+      std::cerr << "Benchmark error: " << ok.takeError();
+      return 1;
+    }
+    return 0;
+  }
+
   // Our output requires the parsed C definitions in order to map enum values to
   // the suitable display name.
   auto& c_definitions = pmresult->get<ast::CDefinitions>();
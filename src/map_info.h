@@ -82,22 +82,56 @@ private:
   }
 };
 
+struct TopkArgs {
+  long k = -1;
+
+  bool operator==(const TopkArgs &other)
+  {
+    return k == other.k;
+  }
+  bool operator!=(const TopkArgs &other)
+  {
+    return !(*this == other);
+  }
+
+private:
+  friend class cereal::access;
+  template <typename Archive>
+  void serialize(Archive &archive)
+  {
+    archive(k);
+  }
+};
+
 struct MapInfo {
   SizedType key_type;
   SizedType value_type;
-  std::variant<std::monostate, HistogramArgs, LinearHistogramArgs, TSeriesArgs>
+  std::variant<std::monostate,
+               HistogramArgs,
+               LinearHistogramArgs,
+               TSeriesArgs,
+               TopkArgs>
       detail;
   int id = -1;
   int max_entries = -1;
   libbpf::bpf_map_type bpf_type = libbpf::BPF_MAP_TYPE_HASH;
   bool is_scalar = false;
+  // Whether the map was declared with an explicit type and size.
+  bool is_declared = false;
 
 private:
   friend class cereal::access;
   template <typename Archive>
   void serialize(Archive &archive)
   {
-    archive(key_type, value_type, detail, id, max_entries, bpf_type, is_scalar);
+    archive(key_type,
+            value_type,
+            detail,
+            id,
+            max_entries,
+            bpf_type,
+            is_scalar,
+            is_declared);
   }
 };
 
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "bpfmap.h"
+#include "map_planner.h"
+
+namespace bpftrace {
+
+char MapBudgetError::ID;
+
+void MapBudgetError::log(llvm::raw_ostream &OS) const
+{
+  OS << "maps that cannot be resized need " << fixed_
+     << " bytes, which exceeds max_map_memory (" << budget_ << " bytes)";
+}
+
+namespace {
+
+// Per-element overhead of the kernel's htab_elem (hash node, LRU node or
+// per-CPU pointer, padding), rounded up to what it is on 64-bit kernels.
+constexpr uint64_t HTAB_ELEM_OVERHEAD = 48;
+
+uint64_t round_up8(uint64_t size)
+{
+  return (size + 7) & ~7ULL;
+}
+
+bool is_hash_type(libbpf::bpf_map_type type)
+{
+  return type == libbpf::BPF_MAP_TYPE_HASH ||
+         type == libbpf::BPF_MAP_TYPE_PERCPU_HASH ||
+         type == libbpf::BPF_MAP_TYPE_LRU_HASH ||
+         type == libbpf::BPF_MAP_TYPE_LRU_PERCPU_HASH;
+}
+
+libbpf::bpf_map_type lru_type(libbpf::bpf_map_type type)
+{
+  switch (type) {
+    case libbpf::BPF_MAP_TYPE_HASH:
+      return libbpf::BPF_MAP_TYPE_LRU_HASH;
+    case libbpf::BPF_MAP_TYPE_PERCPU_HASH:
+      return libbpf::BPF_MAP_TYPE_LRU_PERCPU_HASH;
+    default:
+      return type;
+  }
+}
+
+std::string format_size(uint64_t bytes)
+{
+  static const char *units[] = { "B", "KiB", "MiB", "GiB" };
+  size_t unit = 0;
+  auto value = static_cast<double>(bytes);
+  while (value >= 1024 && unit < std::size(units) - 1) {
+    value /= 1024;
+    unit++;
+  }
+  std::ostringstream out;
+  if (unit == 0)
+    out << bytes << units[unit];
+  else
+    out << std::fixed << std::setprecision(1) << value << units[unit];
+  return out.str();
+}
+
+} // namespace
+
+uint64_t map_memory_size(libbpf::bpf_map_type type,
+                         uint32_t key_size,
+                         uint32_t value_size,
+                         uint32_t max_entries,
+                         uint32_t ncpus)
+{
+  const uint64_t entries = max_entries;
+  const uint64_t key = round_up8(key_size);
+  const uint64_t value = round_up8(value_size);
+
+  switch (type) {
+    case libbpf::BPF_MAP_TYPE_HASH:
+    case libbpf::BPF_MAP_TYPE_LRU_HASH:
+      return entries * (HTAB_ELEM_OVERHEAD + key + value);
+    case libbpf::BPF_MAP_TYPE_PERCPU_HASH:
+    case libbpf::BPF_MAP_TYPE_LRU_PERCPU_HASH:
+      // The element only stores a pointer to the per-CPU values.
+      return entries * (HTAB_ELEM_OVERHEAD + key + 8 + (value * ncpus));
+    case libbpf::BPF_MAP_TYPE_ARRAY:
+      return entries * value;
+    case libbpf::BPF_MAP_TYPE_PERCPU_ARRAY:
+      return entries * value * ncpus;
+    case libbpf::BPF_MAP_TYPE_RINGBUF:
+      // max_entries is the size of the buffer in bytes.
+      return entries;
+    case libbpf::BPF_MAP_TYPE_PERF_EVENT_ARRAY:
+      // The perf buffers themselves are mmap-ed separately.
+      return entries * sizeof(uint64_t);
+    default:
+      return entries * (static_cast<uint64_t>(key_size) + value_size);
+  }
+}
+
+void MapPlanner::add(MapPlanEntry entry)
+{
+  entries_.push_back(std::move(entry));
+}
+
+uint64_t MapPlanner::size(const MapPlanEntry &entry) const
+{
+  return map_memory_size(entry.type,
+                         entry.key_size,
+                         entry.value_size,
+                         entry.max_entries,
+                         ncpus_);
+}
+
+uint64_t MapPlanner::total_size() const
+{
+  uint64_t total = 0;
+  for (const auto &entry : entries_)
+    total += size(entry);
+  return total;
+}
+
+Result<OK> MapPlanner::plan()
+{
+  if (budget_ == 0 || total_size() <= budget_)
+    return OK();
+
+  uint64_t fixed = 0;
+  uint64_t resizable = 0;
+  for (const auto &entry : entries_) {
+    if (entry.resizable && is_hash_type(entry.type))
+      resizable += size(entry);
+    else
+      fixed += size(entry);
+  }
+  if (fixed >= budget_)
+    return make_error<MapBudgetError>(fixed, budget_);
+
+  // Shrink all resizable maps by the same factor. Every map keeps at least
+  // one entry, which may leave the total slightly above the budget for
+  // programs with a very large number of maps.
+  const double ratio = static_cast<double>(budget_ - fixed) /
+                       static_cast<double>(resizable);
+  for (auto &entry : entries_) {
+    if (!entry.resizable || !is_hash_type(entry.type))
+      continue;
+    auto max_entries = static_cast<uint32_t>(
+        static_cast<double>(entry.max_entries) * ratio);
+    entry.max_entries = std::max<uint32_t>(max_entries, 1);
+    if (entry.evictable)
+      entry.type = lru_type(entry.type);
+    entry.resized = true;
+  }
+  return OK();
+}
+
+void MapPlanner::report(std::ostream &out) const
+{
+  size_t name_width = 4;
+  for (const auto &entry : entries_)
+    name_width = std::max(name_width, entry.name.size());
+
+  out << std::left << std::setw(name_width) << "map" << "  "
+      << std::setw(20) << "type" << std::right << std::setw(6) << "key"
+      << std::setw(8) << "value" << std::setw(10) << "entries"
+      << std::setw(12) << "memory" << std::endl;
+  for (const auto &entry : entries_) {
+    out << std::left << std::setw(name_width) << entry.name << "  "
+        << std::setw(20) << get_bpf_map_type_str(entry.type) << std::right
+        << std::setw(6) << entry.key_size << std::setw(8) << entry.value_size
+        << std::setw(10) << entry.max_entries << std::setw(12)
+        << format_size(size(entry)) << (entry.resized ? " (resized)" : "")
+        << std::endl;
+  }
+  out << "total map memory: " << format_size(total_size()) << " ("
+      << ncpus_ << " possible CPUs";
+  if (budget_ != 0)
+    out << ", budget " << format_size(budget_);
+  out << ")" << std::endl;
+}
+
+} // namespace bpftrace
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "util/result.h"
+
+namespace libbpf {
+#include "libbpf/bpf.h"
+} // namespace libbpf
+
+namespace bpftrace {
+
+class MapBudgetError : public ErrorInfo<MapBudgetError> {
+public:
+  MapBudgetError(uint64_t fixed, uint64_t budget)
+      : fixed_(fixed), budget_(budget) {};
+  static char ID;
+  void log(llvm::raw_ostream &OS) const override;
+
+private:
+  uint64_t fixed_;
+  uint64_t budget_;
+};
+
+// Approximate amount of kernel memory a map pins once it is created. Hash maps
+// are preallocated, so this is the same whether the map is full or not.
+// Per-CPU maps hold a copy of every value for each possible CPU.
+uint64_t map_memory_size(libbpf::bpf_map_type type,
+                         uint32_t key_size,
+                         uint32_t value_size,
+                         uint32_t max_entries,
+                         uint32_t ncpus);
+
+struct MapPlanEntry {
+  std::string name;
+  libbpf::bpf_map_type type;
+  uint32_t key_size;
+  uint32_t value_size;
+  uint32_t max_entries;
+
+  // Whether the planner may shrink the map to fit the budget.
+  bool resizable = false;
+
+  // Whether a shrunk hash map may be switched to its LRU variant. Maps that
+  // keep one element per bucket of an aggregation (e.g. hist()) must not
+  // lose single elements, so they are shrunk but keep their type.
+  bool evictable = true;
+
+  // Set by MapPlanner::plan() when the map has been shrunk.
+  bool resized = false;
+};
+
+// Computes the memory footprint of all maps of a program and, if the total
+// exceeds the budget, shrinks the resizable maps proportionally so that it
+// fits. Resized hash maps are switched to their LRU variants, unless they are
+// not evictable, so that a full map evicts old keys instead of failing new
+// updates.
+class MapPlanner {
+public:
+  // A budget of 0 means there is no limit.
+  MapPlanner(uint32_t ncpus, uint64_t budget) : ncpus_(ncpus), budget_(budget)
+  {
+  }
+
+  void add(MapPlanEntry entry);
+  Result<OK> plan();
+
+  uint64_t size(const MapPlanEntry &entry) const;
+  uint64_t total_size() const;
+  const std::vector<MapPlanEntry> &entries() const
+  {
+    return entries_;
+  }
+
+  void report(std::ostream &out) const;
+
+private:
+  uint32_t ncpus_;
+  uint64_t budget_;
+  std::vector<MapPlanEntry> entries_;
+};
+
+} // namespace bpftrace
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+#include "log.h"
+#include "offline_symbolizer.h"
+#include "util/cache.h"
+
+namespace bpftrace {
+
+namespace {
+
+constexpr std::string_view KERNEL_FRAME_PREFIX = "kernel";
+constexpr size_t BUILD_ID_HEX_SIZE = 2 * sizeof(BuildIdFrame::build_id);
+
+std::string to_hex(uint64_t value)
+{
+  std::ostringstream out;
+  out << "0x" << std::hex << value;
+  return out.str();
+}
+
+bool is_hex(char c)
+{
+  return std::isdigit(c) || (c >= 'a' && c <= 'f');
+}
+
+std::optional<std::string> get_boot_id()
+{
+  std::ifstream file("/proc/sys/kernel/random/boot_id");
+  std::string boot_id;
+  if (!std::getline(file, boot_id) || boot_id.empty())
+    return std::nullopt;
+  return boot_id;
+}
+
+// Build-ids in stacks are always 20 bytes, shorter ones are zero-padded.
+std::string pad_build_id(std::string build_id)
+{
+  if (build_id.size() < BUILD_ID_HEX_SIZE)
+    build_id.resize(BUILD_ID_HEX_SIZE, '0');
+  return build_id;
+}
+
+} // namespace
+
+std::string format_build_id_frame(const BuildIdFrame &frame)
+{
+  if (frame.status != BuildIdFrame::VALID)
+    return to_hex(frame.ip);
+
+  static constexpr char digits[] = "0123456789abcdef";
+  std::string result;
+  result.reserve(BUILD_ID_HEX_SIZE + 20);
+  for (uint8_t byte : frame.build_id) {
+    result += digits[byte >> 4];
+    result += digits[byte & 0xf];
+  }
+  result += "+" + to_hex(frame.offset);
+  return result;
+}
+
+std::string format_kernel_frame(uint64_t addr)
+{
+  return std::string(KERNEL_FRAME_PREFIX) + "+" + to_hex(addr);
+}
+
+std::optional<std::filesystem::path> kallsyms_snapshot_path()
+{
+  auto boot_id = get_boot_id();
+  if (!boot_id)
+    return std::nullopt;
+  auto cache_dir = util::get_cache_subdir("kallsyms");
+  if (!cache_dir)
+    return std::nullopt;
+  return *cache_dir / *boot_id;
+}
+
+bool save_kallsyms_snapshot()
+{
+  auto path = kallsyms_snapshot_path();
+  if (!path)
+    return false;
+
+  std::ifstream kallsyms("/proc/kallsyms");
+  if (!kallsyms)
+    return false;
+
+  // Write to a temporary file and rename it so that a symbolizer running at
+  // the same time never sees a partial snapshot.
+  std::error_code ec;
+  auto tmp_path = path->string() + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream out(tmp_path);
+    out << kallsyms.rdbuf();
+    if (!out) {
+      std::filesystem::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmp_path, *path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  LOG(V1) << "Saved kernel symbols for offline symbolization to " << *path;
+  // A snapshot takes a few megabytes, only those of the last boots are kept.
+  util::trim_cache_dir(path->parent_path(), 64 << 20);
+  return true;
+}
+
+OfflineSymbolizer::OfflineSymbolizer(
+    std::filesystem::path debug_dir,
+    const std::optional<std::filesystem::path> &kallsyms)
+    : debug_dir_(std::move(debug_dir))
+{
+  if (!kallsyms)
+    return;
+  std::ifstream kallsyms_file(*kallsyms);
+  // Module sizes are not known, so addresses past the last symbol of a
+  // module resolve to that symbol.
+  std::istringstream modules;
+  if (kallsyms_file)
+    kallsyms_.load(kallsyms_file, modules);
+}
+
+std::string OfflineSymbolizer::symbolize_line(std::string_view line)
+{
+  std::string result;
+  size_t copied = 0;
+  size_t pos = 0;
+  while ((pos = line.find("+0x", pos)) != std::string_view::npos) {
+    size_t addr_start = pos + 3;
+    size_t addr_end = addr_start;
+    while (addr_end < line.size() && is_hex(line[addr_end]))
+      addr_end++;
+    if (addr_end == addr_start) {
+      pos = addr_start;
+      continue;
+    }
+    uint64_t addr = std::strtoull(
+        std::string(line.substr(addr_start, addr_end - addr_start)).c_str(),
+        nullptr,
+        16);
+
+    // Frames can follow other characters than whitespace, e.g. the "\n"
+    // escape in JSON output, so look for the exact frame formats.
+    size_t frame_start = std::string_view::npos;
+    std::optional<std::string> symbol;
+    if (pos >= KERNEL_FRAME_PREFIX.size() &&
+        line.substr(pos - KERNEL_FRAME_PREFIX.size(),
+                    KERNEL_FRAME_PREFIX.size()) == KERNEL_FRAME_PREFIX) {
+      frame_start = pos - KERNEL_FRAME_PREFIX.size();
+      symbol = resolve_kernel(addr);
+    } else if (pos >= BUILD_ID_HEX_SIZE) {
+      size_t id_start = pos - BUILD_ID_HEX_SIZE;
+      auto build_id = line.substr(id_start, BUILD_ID_HEX_SIZE);
+      if (std::ranges::all_of(build_id, is_hex) &&
+          (id_start == 0 || !is_hex(line[id_start - 1]))) {
+        frame_start = id_start;
+        symbol = resolve_user(std::string(build_id), addr);
+      }
+    }
+
+    if (symbol) {
+      result.append(line.substr(copied, frame_start - copied));
+      result.append(*symbol);
+      copied = addr_end;
+    }
+    pos = addr_end;
+  }
+  result.append(line.substr(copied));
+  return result;
+}
+
+void OfflineSymbolizer::symbolize(std::istream &in, std::ostream &out)
+{
+  std::string line;
+  while (std::getline(in, line))
+    out << symbolize_line(line) << "\n";
+  out.flush();
+}
+
+std::optional<std::string> OfflineSymbolizer::resolve_user(
+    const std::string &build_id,
+    uint64_t offset)
+{
+  auto binary = find_binary(build_id);
+  if (!binary)
+    return std::nullopt;
+  auto addr = binary->address(offset);
+  if (!addr)
+    return std::nullopt;
+  auto sym = binary->lookup(*addr);
+  if (!sym)
+    return std::nullopt;
+  return std::string(sym->name) + "+" + std::to_string(*addr - sym->start);
+}
+
+std::optional<std::string> OfflineSymbolizer::resolve_kernel(
+    uint64_t addr) const
+{
+  auto sym = kallsyms_.lookup(addr);
+  if (!sym)
+    return std::nullopt;
+  return std::string(sym->name) + "+" + std::to_string(addr - sym->start);
+}
+
+std::shared_ptr<const util::ElfIndex> OfflineSymbolizer::find_binary(
+    const std::string &build_id)
+{
+  auto cached = binaries_.find(build_id);
+  if (cached != binaries_.end())
+    return cached->second;
+  auto &binary = binaries_[build_id];
+
+  // Load segments, which are needed to translate offsets, are taken from the
+  // binary, as those of debug files are not always accurate. Symbols are
+  // taken from the debug file if there is one, as binaries next to their
+  // debug files are usually stripped. Short build-ids are zero-padded in
+  // stacks, they are found by the scan.
+  BinaryFiles files;
+  auto dir = build_id.substr(0, 2);
+  auto file = build_id.substr(2);
+  for (const auto &root : { debug_dir_ / ".build-id", debug_dir_ }) {
+    std::error_code ec;
+    if (files.binary.empty() && std::filesystem::exists(root / dir / file, ec))
+      files.binary = root / dir / file;
+    if (files.debug.empty() &&
+        std::filesystem::exists(root / dir / (file + ".debug"), ec))
+      files.debug = root / dir / (file + ".debug");
+  }
+  if (files.binary.empty() && files.debug.empty()) {
+    if (!scanned_)
+      scan_debug_dir();
+    auto found = scanned_->find(build_id);
+    if (found != scanned_->end())
+      files = found->second;
+  }
+
+  if (!files.binary.empty() && !files.debug.empty())
+    binary = util::ElfIndex::get(files.binary, files.debug);
+  if (!binary && !files.binary.empty())
+    binary = util::ElfIndex::get(files.binary);
+  if (!binary && !files.debug.empty())
+    binary = util::ElfIndex::get(files.debug);
+  return binary;
+}
+
+void OfflineSymbolizer::scan_debug_dir()
+{
+  scanned_.emplace();
+  std::error_code ec;
+  auto it = std::filesystem::recursive_directory_iterator(
+      debug_dir_,
+      std::filesystem::directory_options::skip_permission_denied,
+      ec);
+  for (; !ec && it != std::filesystem::recursive_directory_iterator();
+       it.increment(ec)) {
+    if (!it->is_regular_file(ec))
+      continue;
+    auto build_id = util::get_elf_build_id(it->path());
+    if (build_id.empty())
+      continue;
+    auto &files = (*scanned_)[pad_build_id(build_id)];
+    auto &path = it->path().extension() == ".debug" ? files.debug
+                                                     : files.binary;
+    if (path.empty())
+      path = it->path();
+  }
+}
+
+} // namespace bpftrace
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "util/kallsyms.h"
+#include "util/symbols.h"
+
+namespace bpftrace {
+
+// A user stack frame in StackMode::build_id, same layout as
+// struct bpf_stack_build_id.
+struct BuildIdFrame {
+  enum Status : int32_t {
+    EMPTY = 0,
+    VALID = 1,
+    // No build-id could be read, ip is an address.
+    IP = 2,
+  };
+
+  int32_t status;
+  uint8_t build_id[20];
+  union {
+    uint64_t offset;
+    uint64_t ip;
+  };
+};
+static_assert(sizeof(BuildIdFrame) == 32);
+
+// Stacks in build_id mode are printed unsymbolized, one frame per line:
+//
+//   <build-id>+0x<offset>  user frame, offset into the ELF file
+//   0x<ip>                 user frame without a build-id, e.g. JIT code
+//   kernel+0x<address>     kernel frame
+//
+// OfflineSymbolizer replaces these by symbols later.
+std::string format_build_id_frame(const BuildIdFrame &frame);
+std::string format_kernel_frame(uint64_t addr);
+
+// Where the kallsyms snapshot of the running kernel is kept, keyed by boot id
+// since kernel addresses change on every boot.
+std::optional<std::filesystem::path> kallsyms_snapshot_path();
+// Copies /proc/kallsyms to kallsyms_snapshot_path(), so that kernel frames
+// can be symbolized after modules were unloaded or the machine rebooted.
+bool save_kallsyms_snapshot();
+
+class OfflineSymbolizer {
+public:
+  // Binaries and debug files are looked up by build-id in debug_dir, either
+  // in the .build-id/xx/yyyy[.debug] layout of /usr/lib/debug or anywhere
+  // below it. Kernel frames are resolved with the kallsyms file, if any.
+  OfflineSymbolizer(std::filesystem::path debug_dir,
+                    const std::optional<std::filesystem::path> &kallsyms);
+
+  // Replaces all unsymbolized frames in line and leaves everything else as
+  // is, so this works for text as well as JSON output. Frames which cannot
+  // be resolved are left unchanged.
+  std::string symbolize_line(std::string_view line);
+  void symbolize(std::istream &in, std::ostream &out);
+
+  bool has_kallsyms() const
+  {
+    return kallsyms_.size() > 0;
+  }
+
+private:
+  std::optional<std::string> resolve_user(const std::string &build_id,
+                                          uint64_t offset);
+  std::optional<std::string> resolve_kernel(uint64_t addr) const;
+  std::shared_ptr<const util::ElfIndex> find_binary(
+      const std::string &build_id);
+  void scan_debug_dir();
+
+  std::filesystem::path debug_dir_;
+  util::KallsymsIndex kallsyms_;
+  std::unordered_map<std::string, std::shared_ptr<const util::ElfIndex>>
+      binaries_;
+  // A binary and its separate debug file, either may be missing.
+  struct BinaryFiles {
+    std::filesystem::path binary;
+    std::filesystem::path debug;
+  };
+  // Build-ids (padded to 20 bytes, like in stacks) of all ELF files below
+  // debug_dir_, filled on the first build-id that is not in the standard
+  // layout.
+  std::optional<std::unordered_map<std::string, BinaryFiles>> scanned_;
+};
+
+} // namespace bpftrace
@@ -13,6 +13,7 @@
 #include "output.h"
 #include "required_resources.h"
 #include "types.h"
+#include "util/sketch.h"
 #include "util/stats.h"
 #include "util/strings.h"
 #include "util/tseries.h"
@@ -45,6 +46,9 @@ bool is_quoted_type(const SizedType &ty)
     case Type::integer:
     case Type::lhist_t:
     case Type::tseries_t:
+    case Type::topk_t:
+    case Type::quantiles_t:
+    case Type::distinct_t:
     case Type::mac_address:
     case Type::max_t:
     case Type::min_t:
@@ -81,6 +85,12 @@ std::ostream &operator<<(std::ostream &out, MessageType type)
     case MessageType::stats:
       out << "stats";
       break;
+    case MessageType::topk:
+      out << "topk";
+      break;
+    case MessageType::quantiles:
+      out << "quantiles";
+      break;
     case MessageType::printf:
       out << "printf";
       break;
@@ -102,6 +112,9 @@ std::ostream &operator<<(std::ostream &out, MessageType type)
     case MessageType::lost_events:
       out << "lost_events";
       break;
+    case MessageType::prog_stats:
+      out << "prog_stats";
+      break;
     default:
       out << "?";
   }
@@ -340,6 +353,9 @@ std::string Output::value_to_str(BPFtrace &bpftrace,
     case Type::count_t: {
       return std::to_string(util::reduce_value<uint64_t>(value, nvalues) / div);
     }
+    case Type::distinct_t: {
+      return std::to_string(util::distinct_value(value, nvalues) / div);
+    }
     case Type::avg_t: {
       // on this code path, avg is calculated in the kernel while
       // printing the entire map is handled in a different function
@@ -434,6 +450,8 @@ std::string Output::value_to_str(BPFtrace &bpftrace,
     case Type::hist_t:
     case Type::lhist_t:
     case Type::tseries_t:
+    case Type::topk_t:
+    case Type::quantiles_t:
     case Type::stack_mode:
     case Type::pointer:
     case Type::stats_t:
@@ -487,6 +505,9 @@ std::string Output::map_key_str(BPFtrace &bpftrace,
     case Type::hist_t:
     case Type::lhist_t:
     case Type::tseries_t:
+    case Type::topk_t:
+    case Type::quantiles_t:
+    case Type::distinct_t:
     case Type::none:
     case Type::stack_mode:
     case Type::stats_t:
@@ -574,6 +595,13 @@ void Output::map_hist_contents(
       val_str = hist_to_str(value,
                             div,
                             std::get<HistogramArgs>(map_info.detail).bits);
+    } else if (map_type.IsQuantilesTy()) {
+      std::vector<std::pair<std::string, std::string>> quantiles;
+      for (const auto &[name, q] : util::QUANTILES) {
+        quantiles.emplace_back(
+            name, std::to_string(util::quantiles_value(value, q) / div));
+      }
+      val_str = key_value_pairs_to_str(quantiles);
     } else {
       if (!std::holds_alternative<LinearHistogramArgs>(map_info.detail))
         LOG(BUG) << "call to lhist with missing arguments";
@@ -675,6 +703,38 @@ void Output::map_stats_contents(
   }
 }
 
+void Output::map_topk_contents(
+    BPFtrace &bpftrace,
+    const BpfMap &map,
+    uint32_t top,
+    const std::vector<std::pair<KeyType, uint64_t>> &estimates_by_key,
+    uint64_t error) const
+{
+  const auto &map_type = bpftrace.resources.maps_info.at(map.name()).value_type;
+  uint32_t i = 0;
+  size_t total = estimates_by_key.size();
+  bool first = true;
+
+  for (const auto &[key, estimate] : estimates_by_key) {
+    if (top) {
+      if (total > top && i++ < (total - top))
+        continue;
+    }
+
+    if (first)
+      first = false;
+    else
+      map_elem_delim(map_type);
+
+    auto key_str = map_key_to_str(bpftrace, map, key);
+    std::vector<std::pair<std::string, std::string>> topk = {
+      { "count", std::to_string(estimate) },
+      { "error", std::to_string(std::min(error, estimate)) }
+    };
+    map_key_val(map_type, key_str, key_value_pairs_to_str(topk));
+  }
+}
+
 void TextOutput::map(
     BPFtrace &bpftrace,
     const BpfMap &map,
@@ -787,6 +847,9 @@ void TextOutput::map_hist(
   map_hist_contents(
       bpftrace, map, top, div, values_by_key, total_counts_by_key);
   out_ << std::endl;
+  // Unlike histograms, quantiles are printed on the same line as their key.
+  if (bpftrace.resources.maps_info.at(map.name()).value_type.IsQuantilesTy())
+    out_ << std::endl;
 }
 
 void TextOutput::map_tseries(
@@ -944,6 +1007,17 @@ void TextOutput::map_stats(
   out_ << std::endl << std::endl;
 }
 
+void TextOutput::map_topk(
+    BPFtrace &bpftrace,
+    const BpfMap &map,
+    uint32_t top,
+    const std::vector<std::pair<KeyType, uint64_t>> &estimates_by_key,
+    uint64_t error) const
+{
+  map_topk_contents(bpftrace, map, top, estimates_by_key, error);
+  out_ << std::endl << std::endl;
+}
+
 void TextOutput::value(BPFtrace &bpftrace,
                        const SizedType &ty,
                        std::vector<uint8_t> &value) const
@@ -1030,6 +1104,41 @@ void TextOutput::attached_probes(uint64_t num_probes) const
     out_ << "Attached " << num_probes << " probes" << std::endl;
 }
 
+void TextOutput::prog_stats(const std::vector<ProgStats> &stats,
+                            bool has_run_stats) const
+{
+  size_t probe_width = 5;
+  for (const auto &prog : stats)
+    probe_width = std::max(probe_width, prog.probe.size());
+
+  auto ms = [](uint64_t ns) {
+    std::ostringstream res;
+    res << std::fixed << std::setprecision(3) << ns / 1e6;
+    return res.str();
+  };
+
+  out_ << std::left << std::setw(probe_width) << "probe" << std::right
+       << std::setw(10) << "verified" << std::setw(8) << "xlated"
+       << std::setw(8) << "jited" << std::setw(10) << "load ms"
+       << std::setw(12) << "runs" << std::setw(12) << "run ms"
+       << std::setw(10) << "ns/run" << std::endl;
+  for (const auto &prog : stats) {
+    out_ << std::left << std::setw(probe_width) << prog.probe << std::right
+         << std::setw(10) << prog.verified_insns << std::setw(8)
+         << prog.xlated_len << std::setw(8) << prog.jited_len
+         << std::setw(10) << ms(prog.load_time_ns);
+    if (has_run_stats) {
+      auto per_run = prog.run_cnt ? prog.run_time_ns / prog.run_cnt : 0;
+      out_ << std::setw(12) << prog.run_cnt << std::setw(12)
+           << ms(prog.run_time_ns) << std::setw(10) << per_run;
+    } else {
+      out_ << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(10)
+           << "-";
+    }
+    out_ << std::endl;
+  }
+}
+
 void TextOutput::helper_error(int retcode, const HelperErrorInfo &info) const
 {
   LOG(WARNING,
@@ -1096,44 +1205,6 @@ std::string TextOutput::key_value_pairs_to_str(
   return util::str_join(elems, ", ");
 }
 
-std::string JsonOutput::json_escape(const std::string &str) const
-{
-  std::ostringstream escaped;
-  for (const char &c : str) {
-    switch (c) {
-      case '"':
-        escaped << "\\\"";
-        break;
-
-      case '\\':
-        escaped << "\\\\";
-        break;
-
-      case '\n':
-        escaped << "\\n";
-        break;
-
-      case '\r':
-        escaped << "\\r";
-        break;
-
-      case '\t':
-        escaped << "\\t";
-        break;
-
-      default:
-        // c always >= '\x00'
-        if (c <= '\x1f') {
-          escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0')
-                  << static_cast<int>(c);
-        } else {
-          escaped << c;
-        }
-    }
-  }
-  return escaped.str();
-}
-
 void JsonOutput::map(
     BPFtrace &bpftrace,
     const BpfMap &map,
@@ -1148,7 +1219,7 @@ void JsonOutput::map(
   const auto &map_info = bpftrace.resources.maps_info.at(map.name());
 
   out_ << R"({"type": ")" << MessageType::map << R"(", "data": {)";
-  out_ << "\"" << json_escape(map.name()) << "\": ";
+  out_ << "\"" << util::json_escape(map.name()) << "\": ";
   if (!map_info.is_scalar)
     out_ << "{";
 
@@ -1258,8 +1329,10 @@ void JsonOutput::map_hist(
 
   const auto &map_info = bpftrace.resources.maps_info.at(map.name());
 
-  out_ << R"({"type": ")" << MessageType::hist << R"(", "data": {)";
-  out_ << "\"" << json_escape(map.name()) << "\": ";
+  const auto type = map_info.value_type.IsQuantilesTy() ? MessageType::quantiles
+                                                        : MessageType::hist;
+  out_ << R"({"type": ")" << type << R"(", "data": {)";
+  out_ << "\"" << util::json_escape(map.name()) << "\": ";
   if (!map_info.is_scalar)
     out_ << "{";
 
@@ -1280,7 +1353,7 @@ void JsonOutput::map_tseries(
   const auto &map_info = bpftrace.resources.maps_info.at(map.name());
 
   out_ << R"({"type": ")" << MessageType::tseries << R"(", "data": {)";
-  out_ << "\"" << json_escape(map.name()) << "\": ";
+  out_ << "\"" << util::json_escape(map.name()) << "\": ";
   if (!map_info.is_scalar) // check if this map has keys
     out_ << "{";
 
@@ -1369,7 +1442,7 @@ void JsonOutput::map_stats(
   const auto &map_info = bpftrace.resources.maps_info.at(map.name());
 
   out_ << R"({"type": ")" << MessageType::stats << R"(", "data": {)";
-  out_ << "\"" << json_escape(map.name()) << "\": ";
+  out_ << "\"" << util::json_escape(map.name()) << "\": ";
   if (!map_info.is_scalar)
     out_ << "{";
 
@@ -1380,6 +1453,25 @@ void JsonOutput::map_stats(
   out_ << "}}" << std::endl;
 }
 
+void JsonOutput::map_topk(
+    BPFtrace &bpftrace,
+    const BpfMap &map,
+    uint32_t top,
+    const std::vector<std::pair<KeyType, uint64_t>> &estimates_by_key,
+    uint64_t error) const
+{
+  if (estimates_by_key.empty())
+    return;
+
+  // topk() maps always have keys.
+  out_ << R"({"type": ")" << MessageType::topk << R"(", "data": {)";
+  out_ << "\"" << util::json_escape(map.name()) << "\": {";
+
+  map_topk_contents(bpftrace, map, top, estimates_by_key, error);
+
+  out_ << "}}}" << std::endl;
+}
+
 void JsonOutput::value(BPFtrace &bpftrace,
                        const SizedType &ty,
                        std::vector<uint8_t> &value) const
@@ -1393,8 +1485,8 @@ void JsonOutput::message(MessageType type,
                          const std::string &msg,
                          bool nl __attribute__((unused))) const
 {
-  out_ << R"({"type": ")" << type << R"(", "data": ")" << json_escape(msg)
-       << "\"}" << std::endl;
+  out_ << R"({"type": ")" << type << R"(", "data": ")"
+       << util::json_escape(msg) << "\"}" << std::endl;
 }
 
 void JsonOutput::message(MessageType type,
@@ -1415,6 +1507,29 @@ void JsonOutput::attached_probes(uint64_t num_probes) const
   message(MessageType::attached_probes, "probes", num_probes);
 }
 
+void JsonOutput::prog_stats(const std::vector<ProgStats> &stats,
+                            bool has_run_stats) const
+{
+  std::vector<std::string> progs;
+  for (const auto &prog : stats) {
+    std::ostringstream res;
+    res << R"({"probe": ")" << util::json_escape(prog.probe)
+        << R"(", "verified_insns": )" << prog.verified_insns
+        << R"(, "xlated_bytes": )" << prog.xlated_len
+        << R"(, "jited_bytes": )" << prog.jited_len << R"(, "load_ns": )"
+        << prog.load_time_ns;
+    if (has_run_stats)
+      res << R"(, "run_cnt": )" << prog.run_cnt << R"(, "run_time_ns": )"
+          << prog.run_time_ns;
+    else
+      res << R"(, "run_cnt": null, "run_time_ns": null)";
+    res << "}";
+    progs.push_back(res.str());
+  }
+  out_ << R"({"type": ")" << MessageType::prog_stats << R"(", "data": [)"
+       << util::str_join(progs, ", ") << "]}" << std::endl;
+}
+
 void JsonOutput::helper_error(int retcode, const HelperErrorInfo &info) const
 {
   out_ << R"({"type": "helper_error", "msg": ")"
@@ -1459,9 +1574,9 @@ std::string JsonOutput::value_to_str(BPFtrace &bpftrace,
 
   if (is_quoted_type(type)) {
     if (is_map_key) {
-      return json_escape(str);
+      return util::json_escape(str);
     } else {
-      return "\"" + json_escape(str) + "\"";
+      return "\"" + util::json_escape(str) + "\"";
     }
   }
 
@@ -1476,7 +1591,8 @@ std::string JsonOutput::map_key_to_str(BPFtrace &bpftrace,
   if (map_info.is_scalar)
     return "";
 
-  return "\"" + json_escape(map_key_str(bpftrace, map_info.key_type, key)) +
+  return "\"" +
+         util::json_escape(map_key_str(bpftrace, map_info.key_type, key)) +
          "\"";
 }
 
@@ -6,6 +6,7 @@
 
 #include "ast/passes/clang_parser.h"
 #include "bpfmap.h"
+#include "prog_stats.h"
 #include "required_resources.h"
 #include "types.h"
 #include "util/bpf_funcs.h"
@@ -22,6 +23,8 @@ enum class MessageType {
   hist,
   tseries,
   stats,
+  topk,
+  quantiles,
   printf,
   time,
   cat,
@@ -30,6 +33,7 @@ enum class MessageType {
   attached_probes,
   lost_events,
   helper_error,
+  prog_stats,
 };
 
 std::ostream &operator<<(std::ostream &out, MessageType type);
@@ -84,6 +88,13 @@ public:
                            const TSeriesMap &values_by_key,
                            const std::vector<std::pair<KeyType, EpochType>>
                                &latest_epoch_by_key) const = 0;
+  // Write map top-k (heavy hitters) estimates to output
+  virtual void map_topk(BPFtrace &bpftrace,
+                        const BpfMap &map,
+                        uint32_t top,
+                        const std::vector<std::pair<KeyType, uint64_t>>
+                            &estimates_by_key,
+                        uint64_t error) const = 0;
   // Write map statistics to output
   virtual void map_stats(
       BPFtrace &bpftrace,
@@ -104,6 +115,9 @@ public:
                        bool nl = true) const = 0;
   virtual void lost_events(uint64_t lost) const = 0;
   virtual void attached_probes(uint64_t num_probes) const = 0;
+  // Run counts and times are only printed if has_run_stats is set.
+  virtual void prog_stats(const std::vector<ProgStats> &stats,
+                          bool has_run_stats) const = 0;
   virtual void helper_error(int retcode, const HelperErrorInfo &info) const = 0;
 
 protected:
@@ -183,6 +197,15 @@ protected:
       uint32_t div,
       const std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>
           &values_by_key) const;
+  // Convert map top-k estimates into string
+  // Default behaviour: format each (key, estimate) pair using output-specific
+  // methods and join them into a single string
+  virtual void map_topk_contents(
+      BPFtrace &bpftrace,
+      const BpfMap &map,
+      uint32_t top,
+      const std::vector<std::pair<KeyType, uint64_t>> &estimates_by_key,
+      uint64_t error) const;
   // Convert map key to string
   virtual std::string map_key_to_str(BPFtrace &bpftrace,
                                      const BpfMap &map,
@@ -262,6 +285,12 @@ public:
       uint32_t div,
       const std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>
           &values_by_key) const override;
+  void map_topk(BPFtrace &bpftrace,
+                const BpfMap &map,
+                uint32_t top,
+                const std::vector<std::pair<KeyType, uint64_t>>
+                    &estimates_by_key,
+                uint64_t error) const override;
   void value(BPFtrace &bpftrace,
              const SizedType &ty,
              std::vector<uint8_t> &value) const override;
@@ -271,6 +300,8 @@ public:
                bool nl = true) const override;
   void lost_events(uint64_t lost) const override;
   void attached_probes(uint64_t num_probes) const override;
+  void prog_stats(const std::vector<ProgStats> &stats,
+                  bool has_run_stats) const override;
   void helper_error(int retcode, const HelperErrorInfo &info) const override;
 
 protected:
@@ -347,6 +378,12 @@ public:
       uint32_t div,
       const std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>>
           &values_by_key) const override;
+  void map_topk(BPFtrace &bpftrace,
+                const BpfMap &map,
+                uint32_t top,
+                const std::vector<std::pair<KeyType, uint64_t>>
+                    &estimates_by_key,
+                uint64_t error) const override;
   void value(BPFtrace &bpftrace,
              const SizedType &ty,
              std::vector<uint8_t> &value) const override;
@@ -359,11 +396,10 @@ public:
                uint64_t value) const;
   void lost_events(uint64_t lost) const override;
   void attached_probes(uint64_t num_probes) const override;
+  void prog_stats(const std::vector<ProgStats> &stats,
+                  bool has_run_stats) const override;
   void helper_error(int retcode, const HelperErrorInfo &info) const override;
 
-private:
-  std::string json_escape(const std::string &str) const;
-
 protected:
   std::string value_to_str(BPFtrace &bpftrace,
                            const SizedType &type,
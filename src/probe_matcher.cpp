@@ -17,6 +17,7 @@
 #include "util/strings.h"
 #include "util/symbols.h"
 #include "util/system.h"
+#include "util/timing.h"
 #include "util/wildcard.h"
 
 #include <bcc/bcc_elf.h>
@@ -25,16 +26,6 @@
 
 namespace bpftrace {
 
-static int add_symbol(const char* symname,
-                      uint64_t /*start*/,
-                      uint64_t /*size*/,
-                      void* payload)
-{
-  auto* syms = static_cast<std::set<std::string>*>(payload);
-  syms->insert(std::string(symname));
-  return 0;
-}
-
 // Finds all matches of search_input in the provided input stream.
 std::set<std::string> ProbeMatcher::get_matches_in_stream(
     const std::string& search_input,
@@ -281,26 +272,25 @@ std::unique_ptr<std::istream> ProbeMatcher::get_func_symbols_from_file(
     real_paths = util::resolve_binary_path(path, pid);
   else
     real_paths.push_back(path);
-  struct bcc_symbol_option symbol_option;
-  memset(&symbol_option, 0, sizeof(symbol_option));
-  symbol_option.use_debug_file = 1;
-  symbol_option.check_debug_file_crc = 1;
-  symbol_option.use_symbol_type = (1 << STT_FUNC) | (1 << STT_GNU_IFUNC);
 
   std::string result;
   for (auto& real_path : real_paths) {
-    std::set<std::string> syms;
-    // Workaround: bcc_elf_foreach_sym() can return the same symbol twice if
-    // it's also found in debug info (#1138), so a std::set is used here (and in
-    // the add_symbol callback) to ensure that each symbol will be unique in the
-    // returned string.
-    int err = bcc_elf_foreach_sym(
-        real_path.c_str(), add_symbol, &symbol_option, &syms);
-    if (err) {
+    auto symbol_table = util::ElfSymbolTable::get(real_path);
+    if (!symbol_table) {
       LOG(WARNING) << "Could not list function symbols: " + real_path;
+      continue;
+    }
+    // The symbol table can contain the same symbol twice if it's also found
+    // in debug info (#1138), so a std::set is used here to ensure that each
+    // symbol will be unique in the returned string.
+    std::set<std::string_view> syms;
+    for (size_t i = 0; i < symbol_table->size(); i++) {
+      auto sym = (*symbol_table)[i];
+      if (sym.is_function)
+        syms.insert(sym.name);
     }
     for (const auto& sym : syms)
-      result += real_path + ":" + sym + "\n";
+      result += real_path + ":" + std::string(sym) + "\n";
   }
   return std::make_unique<std::istringstream>(result);
 }
@@ -520,6 +510,7 @@ void ProbeMatcher::list_probes(ast::Program* prog)
 std::set<std::string> ProbeMatcher::get_matches_for_ap(
     const ast::AttachPoint& attach_point)
 {
+  util::TimingSpan span("probe_matcher", attach_point.name());
   std::string search_input;
   switch (probetype(attach_point.provider)) {
     case ProbeType::kprobe:
@@ -75,4 +75,32 @@ std::string probetypeName(ProbeType t)
   return {}; // unreached
 }
 
+bool probe_needs_cgroup_filter(ProbeType type, bool has_pid)
+{
+  switch (type) {
+    case ProbeType::kprobe:
+    case ProbeType::kretprobe:
+    case ProbeType::uprobe:
+    case ProbeType::uretprobe:
+    case ProbeType::usdt:
+    case ProbeType::tracepoint:
+    case ProbeType::rawtracepoint:
+    case ProbeType::fentry:
+    case ProbeType::fexit:
+      return true;
+    case ProbeType::profile:
+    case ProbeType::software:
+    case ProbeType::hardware:
+      return has_pid;
+    case ProbeType::interval:
+    case ProbeType::iter:
+    case ProbeType::watchpoint:
+    case ProbeType::asyncwatchpoint:
+    case ProbeType::special:
+    case ProbeType::invalid:
+      return false;
+  }
+  return false;
+}
+
 } // namespace bpftrace
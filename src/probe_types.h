@@ -100,6 +100,11 @@ const std::vector<ProbeItem> PROBE_LIST = {
 ProbeType probetype(const std::string &probeName);
 std::string expand_probe_name(const std::string &orig_name);
 std::string probetypeName(ProbeType t);
+// Whether a probe of this type has to check --cgroup itself. Probes on
+// per-CPU perf events are limited to the cgroup when they are attached,
+// unless they are limited to a process instead. Probes which do not run in
+// the context of a task are not filtered at all.
+bool probe_needs_cgroup_filter(ProbeType type, bool has_pid);
 
 struct Probe {
   ProbeType type;
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <bpf/bpf.h>
+#include <fstream>
+#include <unordered_set>
+
+#include "bpfbytecode.h"
+#include "prog_stats.h"
+#include "required_resources.h"
+
+namespace bpftrace {
+
+std::vector<ProgStats> collect_prog_stats(const RequiredResources &resources,
+                                          const BpfBytecode &bytecode)
+{
+  std::vector<const Probe *> probes;
+  for (const auto &[_, probe] : resources.special_probes)
+    probes.push_back(&probe);
+  for (const auto *list : { &resources.signal_probes,
+                            &resources.probes,
+                            &resources.watchpoint_probes }) {
+    for (const auto &probe : *list)
+      probes.push_back(&probe);
+  }
+
+  std::vector<ProgStats> stats;
+  // The boot time at which each program finished loading.
+  std::vector<uint64_t> loaded_at;
+  // Probes expanded from a wildcard share a program.
+  std::unordered_set<int> seen;
+  for (const auto *probe : probes) {
+    int fd = bytecode.getProgramForProbe(*probe).fd();
+    if (fd < 0 || !seen.insert(fd).second)
+      continue;
+
+    struct bpf_prog_info info = {};
+    uint32_t info_len = sizeof(info);
+    if (bpf_obj_get_info_by_fd(fd, &info, &info_len) != 0)
+      continue;
+    stats.push_back(ProgStats{ .probe = probe->orig_name,
+                               .verified_insns = info.verified_insns,
+                               .xlated_len = info.xlated_prog_len,
+                               .jited_len = info.jited_prog_len,
+                               .run_cnt = info.run_cnt,
+                               .run_time_ns = info.run_time_ns });
+    loaded_at.push_back(info.load_time);
+  }
+
+  std::vector<size_t> order(stats.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::ranges::sort(order, [&](size_t a, size_t b) {
+    return loaded_at[a] < loaded_at[b];
+  });
+  uint64_t prev = bytecode.load_start_ns();
+  for (size_t i : order) {
+    if (prev != 0 && loaded_at[i] > prev)
+      stats[i].load_time_ns = loaded_at[i] - prev;
+    prev = loaded_at[i];
+  }
+  return stats;
+}
+
+int enable_run_stats()
+{
+  return bpf_enable_stats(BPF_STATS_RUN_TIME);
+}
+
+bool run_stats_enabled(int stats_fd)
+{
+  if (stats_fd >= 0)
+    return true;
+  std::ifstream file("/proc/sys/kernel/bpf_stats_enabled");
+  int enabled = 0;
+  return file >> enabled && enabled != 0;
+}
+
+} // namespace bpftrace
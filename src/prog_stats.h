@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bpftrace {
+
+class BpfBytecode;
+class RequiredResources;
+
+// Statistics of a single loaded BPF program, as reported by the kernel.
+struct ProgStats {
+  std::string probe;
+  // Number of instructions the verifier processed, 0 before Linux 5.16.
+  uint32_t verified_insns = 0;
+  uint32_t xlated_len = 0;
+  uint32_t jited_len = 0;
+  // Approximation, see collect_prog_stats().
+  uint64_t load_time_ns = 0;
+  // Only counted while BPF run time statistics are enabled.
+  uint64_t run_cnt = 0;
+  uint64_t run_time_ns = 0;
+};
+
+// Returns the statistics of all loaded programs, one entry per program.
+//
+// The kernel only records when a program finished loading, so the load time
+// of a program is the time since the previous one finished, or since loading
+// started for the first one. This includes a bit of libbpf work in between.
+std::vector<ProgStats> collect_prog_stats(const RequiredResources &resources,
+                                          const BpfBytecode &bytecode);
+
+// Enables counting of run_cnt and run_time_ns for all BPF programs for as long
+// as the returned fd is open. Returns a negative value if this is not
+// possible, in which case counting may still be enabled system-wide, see
+// run_stats_enabled().
+int enable_run_stats();
+bool run_stats_enabled(int stats_fd);
+
+} // namespace bpftrace
@@ -85,6 +85,9 @@ int run_bpftrace(BPFtrace &bpftrace,
   if (bpftrace.config_->print_maps_on_exit)
     err = bpftrace.print_maps(output);
 
+  if (bpftrace.prog_stats_)
+    bpftrace.print_prog_stats(output);
+
   if (bpftrace.child_) {
     auto val = 0;
     if ((val = bpftrace.child_->term_signal()) > -1)
@@ -56,10 +56,19 @@ struct Field {
   // where the data begins.
   bool is_data_loc = false;
 
+  // Used for the arguments of format string calls
+  //
+  // If true, this string or buffer is not stored at a fixed position but
+  // packed at the end of the event, right after the previous packed argument.
+  // `offset` is where the first packed argument starts. Strings take up their
+  // length plus the terminating NUL, buffers their length prefix plus content.
+  bool is_packed = false;
+
   bool operator==(const Field &rhs) const
   {
     return name == rhs.name && type == rhs.type && offset == rhs.offset &&
-           bitfield == rhs.bitfield && is_data_loc == rhs.is_data_loc;
+           bitfield == rhs.bitfield && is_data_loc == rhs.is_data_loc &&
+           is_packed == rhs.is_packed;
   }
 
 private:
@@ -67,7 +76,7 @@ private:
   template <typename Archive>
   void serialize(Archive &archive)
   {
-    archive(name, type, offset, bitfield, is_data_loc);
+    archive(name, type, offset, bitfield, is_data_loc, is_packed);
   }
 };
 
@@ -0,0 +1,92 @@
+#include "symbolizer_pool.h"
+
+namespace bpftrace {
+
+SymbolizerPool::SymbolizerPool(const Config &config, size_t threads)
+    : config_(config)
+{
+  for (size_t i = 0; i < threads; i++)
+    workers_.emplace_back(&SymbolizerPool::worker, this);
+}
+
+SymbolizerPool::~SymbolizerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_.notify_all();
+  for (auto &worker : workers_)
+    worker.join();
+}
+
+void SymbolizerPool::submit(Job job, Emit emit)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (pending_.size() >= MAX_PENDING) {
+    done_.wait(lock, [this] { return pending_.front().done; });
+    emit_done(lock);
+  }
+
+  bool done = !job;
+  pending_.push_back(
+      Entry{ .job = std::move(job), .emit = std::move(emit), .done = done });
+  if (done) {
+    emit_done(lock);
+    return;
+  }
+  queue_.push_back(&pending_.back());
+  lock.unlock();
+  queued_.notify_one();
+}
+
+void SymbolizerPool::emit_ready()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  emit_done(lock);
+}
+
+void SymbolizerPool::drain()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!pending_.empty()) {
+    done_.wait(lock, [this] { return pending_.front().done; });
+    emit_done(lock);
+  }
+}
+
+void SymbolizerPool::emit_done(std::unique_lock<std::mutex> &lock)
+{
+  while (!pending_.empty() && pending_.front().done) {
+    // Only this thread removes entries, so the front stays put while the
+    // lock is released.
+    auto emit = std::move(pending_.front().emit);
+    pending_.pop_front();
+    lock.unlock();
+    emit();
+    lock.lock();
+  }
+}
+
+void SymbolizerPool::worker()
+{
+  Ksyms ksyms(config_);
+  Usyms usyms(config_);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty())
+      return;
+
+    Entry *entry = queue_.front();
+    queue_.pop_front();
+    lock.unlock();
+    entry->job(ksyms, usyms);
+    lock.lock();
+    entry->done = true;
+    done_.notify_all();
+  }
+}
+
+} // namespace bpftrace
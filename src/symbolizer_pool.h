@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ksyms.h"
+#include "usyms.h"
+
+namespace bpftrace {
+
+class Config;
+
+// Symbolizes per-event output on worker threads, so that reading events does
+// not wait for symbol lookups, and hands the results back in the order in
+// which the events were read (a reorder buffer).
+//
+// Every worker has its own Ksyms and Usyms, neither is thread-safe. Results
+// are only ever emitted on the thread that calls submit(), emit_ready() and
+// drain(), which is the one reading events.
+class SymbolizerPool {
+public:
+  using Job = std::function<void(Ksyms &, Usyms &)>;
+  using Emit = std::function<void()>;
+
+  SymbolizerPool(const Config &config, size_t threads);
+  ~SymbolizerPool();
+
+  SymbolizerPool(const SymbolizerPool &) = delete;
+  SymbolizerPool &operator=(const SymbolizerPool &) = delete;
+
+  // Runs job on a worker and then emit, once all earlier submissions were
+  // emitted. Without a job, emit only waits for its turn. Blocks if too many
+  // submissions are pending, so memory stays bounded when symbolization
+  // cannot keep up.
+  void submit(Job job, Emit emit);
+
+  // Emits the results that are ready, without waiting for any workers.
+  void emit_ready();
+  // Waits for all pending submissions and emits them.
+  void drain();
+
+  // True if nothing is waiting to be emitted, in which case output can be
+  // written directly without going through the pool.
+  bool empty() const
+  {
+    return pending_.empty();
+  }
+
+  static constexpr size_t MAX_PENDING = 16384;
+
+private:
+  struct Entry {
+    Job job;
+    Emit emit;
+    bool done;
+  };
+
+  void worker();
+  // Emits the entries at the front that are done. Must be called with lock
+  // held, which is released while emitting.
+  void emit_done(std::unique_lock<std::mutex> &lock);
+
+  const Config &config_;
+  // Submissions in order, only added and removed by the emitting thread.
+  // Pointers to entries stay valid while they are in the deque.
+  std::deque<Entry> pending_;
+  // Jobs not yet picked up by a worker.
+  std::deque<Entry *> queue_;
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable done_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace bpftrace
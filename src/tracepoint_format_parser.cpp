@@ -2,6 +2,10 @@
 #include <fstream>
 #include <glob.h>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
 
 #include "ast/ast.h"
 #include "bpftrace.h"
@@ -15,6 +19,166 @@ namespace bpftrace {
 
 std::set<std::string> TracepointFormatParser::struct_list;
 
+namespace {
+
+struct FormatField {
+  std::string type; // Empty if the field could not be split into type and name
+  std::string name;
+  int offset;
+  int size;
+};
+
+// Parses a field line of a tracepoint format file, e.g.:
+//   field:unsigned short common_type; offset:0; size:2; signed:0;
+std::optional<FormatField> parse_format_field(const std::string &line)
+{
+  auto field_pos = line.find("field:");
+  if (field_pos == std::string::npos)
+    return std::nullopt;
+
+  auto field_semi_pos = line.find(';', field_pos);
+  if (field_semi_pos == std::string::npos)
+    return std::nullopt;
+
+  auto offset_pos = line.find("offset:", field_semi_pos);
+  if (offset_pos == std::string::npos)
+    return std::nullopt;
+
+  auto offset_semi_pos = line.find(';', offset_pos);
+  if (offset_semi_pos == std::string::npos)
+    return std::nullopt;
+
+  auto size_pos = line.find("size:", offset_semi_pos);
+  if (size_pos == std::string::npos)
+    return std::nullopt;
+
+  auto size_semi_pos = line.find(';', size_pos);
+  if (size_semi_pos == std::string::npos)
+    return std::nullopt;
+
+  FormatField format_field;
+  format_field.size = std::stoi(
+      line.substr(size_pos + 5, size_semi_pos - size_pos - 5));
+  format_field.offset = std::stoi(
+      line.substr(offset_pos + 7, offset_semi_pos - offset_pos - 7));
+
+  std::string field = line.substr(field_pos + 6,
+                                  field_semi_pos - field_pos - 6);
+  auto field_type_end_pos = field.find_last_of("\t ");
+  if (field_type_end_pos != std::string::npos) {
+    format_field.type = field.substr(0, field_type_end_pos);
+    format_field.name = field.substr(field_type_end_pos + 1);
+  }
+  return format_field;
+}
+
+struct IntegerType {
+  int size;
+  bool is_signed;
+};
+
+// Integer types (and kernel typedefs of them) that tracepoint records can be
+// built from without clang. Sizes and signedness are the ones clang would use
+// for the host, which is what the C definitions are parsed for.
+const std::unordered_map<std::string_view, IntegerType> INTEGER_TYPES = {
+  { "char", { 1, std::is_signed_v<char> } },
+  { "signed char", { 1, true } },
+  { "unsigned char", { 1, false } },
+  { "bool", { 1, false } },
+  { "_Bool", { 1, false } },
+  { "short", { 2, true } },
+  { "short int", { 2, true } },
+  { "unsigned short", { 2, false } },
+  { "unsigned short int", { 2, false } },
+  { "int", { 4, true } },
+  { "signed", { 4, true } },
+  { "signed int", { 4, true } },
+  { "unsigned", { 4, false } },
+  { "unsigned int", { 4, false } },
+  { "long", { sizeof(long), true } },
+  { "long int", { sizeof(long), true } },
+  { "unsigned long", { sizeof(long), false } },
+  { "unsigned long int", { sizeof(long), false } },
+  { "long long", { 8, true } },
+  { "unsigned long long", { 8, false } },
+  { "s8", { 1, true } },
+  { "u8", { 1, false } },
+  { "s16", { 2, true } },
+  { "u16", { 2, false } },
+  { "s32", { 4, true } },
+  { "u32", { 4, false } },
+  { "s64", { 8, true } },
+  { "u64", { 8, false } },
+  { "__s8", { 1, true } },
+  { "__u8", { 1, false } },
+  { "__s16", { 2, true } },
+  { "__u16", { 2, false } },
+  { "__s32", { 4, true } },
+  { "__u32", { 4, false } },
+  { "__s64", { 8, true } },
+  { "__u64", { 8, false } },
+  { "pid_t", { 4, true } },
+  { "uid_t", { 4, false } },
+  { "gid_t", { 4, false } },
+  { "size_t", { sizeof(size_t), false } },
+  { "ssize_t", { sizeof(size_t), true } },
+  { "loff_t", { 8, true } },
+  { "umode_t", { 2, false } },
+  { "dev_t", { 4, false } },
+  { "gfp_t", { 4, false } },
+  { "ino_t", { sizeof(long), false } },
+  { "sector_t", { 8, false } },
+  { "blkcnt_t", { 8, false } },
+  { "clockid_t", { 4, true } },
+  { "key_serial_t", { 4, true } },
+  { "qid_t", { 4, false } },
+  { "aio_context_t", { sizeof(long), false } },
+  { "rwf_t", { 4, true } },
+};
+
+SizedType create_integer(const IntegerType &integer)
+{
+  return integer.is_signed ? CreateInt(integer.size * 8)
+                           : CreateUInt(integer.size * 8);
+}
+
+// Splits a type like "const char *const *" into its base type ("char") and
+// the number of pointer levels (2). Qualifiers are dropped.
+std::optional<std::pair<std::string, int>> split_pointer_type(
+    std::string_view type)
+{
+  std::string base;
+  int pointer_levels = 0;
+  size_t pos = 0;
+  while (pos < type.size()) {
+    if (type[pos] == ' ' || type[pos] == '\t') {
+      pos++;
+      continue;
+    }
+    if (type[pos] == '*') {
+      pointer_levels++;
+      pos++;
+      continue;
+    }
+    auto end = std::min(type.find_first_of(" \t*", pos), type.size());
+    auto word = type.substr(pos, end - pos);
+    pos = end;
+    if (word == "const" || word == "volatile")
+      continue;
+    // Something like "char * __user"
+    if (pointer_levels > 0)
+      return std::nullopt;
+    if (!base.empty())
+      base += " ";
+    base += word;
+  }
+  if (base.empty())
+    return std::nullopt;
+  return std::make_pair(std::move(base), pointer_levels);
+}
+
+} // namespace
+
 bool TracepointFormatParser::parse(ast::ASTContext &ctx, BPFtrace &bpftrace)
 {
   ast::Program *program = ctx.root;
@@ -28,8 +192,18 @@ bool TracepointFormatParser::parse(ast::ASTContext &ctx, BPFtrace &bpftrace)
   if (probes_with_tracepoint.empty())
     return true;
 
-  if (!bpftrace.has_btf_data())
-    program->c_definitions += "#include <linux/types.h>\n";
+  // C definitions for the tracepoints whose records cannot be built directly
+  // and have to be parsed by clang.
+  std::string definitions;
+  SCOPE_EXIT
+  {
+    if (!definitions.empty()) {
+      if (!bpftrace.has_btf_data())
+        program->c_definitions += "#include <linux/types.h>\n";
+      program->c_definitions += definitions;
+    }
+  };
+
   for (ast::Probe *probe : probes_with_tracepoint) {
     for (ast::AttachPoint *ap : probe->attach_points) {
       if (ap->provider == "tracepoint") {
@@ -79,8 +253,11 @@ bool TracepointFormatParser::parse(ast::ASTContext &ctx, BPFtrace &bpftrace)
             std::string struct_name = get_struct_name(real_category,
                                                       real_event);
             if (!TracepointFormatParser::struct_list.contains(struct_name)) {
-              program->c_definitions += get_tracepoint_struct(
-                  format_file, real_category, real_event, bpftrace);
+              add_tracepoint_struct(format_file,
+                                    real_category,
+                                    real_event,
+                                    bpftrace,
+                                    definitions);
               TracepointFormatParser::struct_list.insert(struct_name);
             }
           }
@@ -109,8 +286,8 @@ bool TracepointFormatParser::parse(ast::ASTContext &ctx, BPFtrace &bpftrace)
           // Check to avoid adding the same struct more than once to definitions
           std::string struct_name = get_struct_name(category, event_name);
           if (TracepointFormatParser::struct_list.insert(struct_name).second)
-            program->c_definitions += get_tracepoint_struct(
-                format_file, category, event_name, bpftrace);
+            add_tracepoint_struct(
+                format_file, category, event_name, bpftrace, definitions);
         }
       }
     }
@@ -139,33 +316,12 @@ std::string TracepointFormatParser::parse_field(const std::string &line,
 {
   std::string extra;
 
-  auto field_pos = line.find("field:");
-  if (field_pos == std::string::npos)
-    return "";
-
-  auto field_semi_pos = line.find(';', field_pos);
-  if (field_semi_pos == std::string::npos)
-    return "";
-
-  auto offset_pos = line.find("offset:", field_semi_pos);
-  if (offset_pos == std::string::npos)
-    return "";
-
-  auto offset_semi_pos = line.find(';', offset_pos);
-  if (offset_semi_pos == std::string::npos)
-    return "";
-
-  auto size_pos = line.find("size:", offset_semi_pos);
-  if (size_pos == std::string::npos)
+  auto format_field = parse_format_field(line);
+  if (!format_field)
     return "";
 
-  auto size_semi_pos = line.find(';', size_pos);
-  if (size_semi_pos == std::string::npos)
-    return "";
-
-  int size = std::stoi(line.substr(size_pos + 5, size_semi_pos - size_pos - 5));
-  int offset = std::stoi(
-      line.substr(offset_pos + 7, offset_semi_pos - offset_pos - 7));
+  int size = format_field->size;
+  int offset = format_field->offset;
 
   // If there'a gap between last field and this one,
   // generate padding fields
@@ -179,13 +335,10 @@ std::string TracepointFormatParser::parse_field(const std::string &line,
 
   *last_offset = offset + size;
 
-  std::string field = line.substr(field_pos + 6,
-                                  field_semi_pos - field_pos - 6);
-  auto field_type_end_pos = field.find_last_of("\t ");
-  if (field_type_end_pos == std::string::npos)
+  if (format_field->type.empty())
     return "";
-  std::string field_type = field.substr(0, field_type_end_pos);
-  std::string field_name = field.substr(field_type_end_pos + 1);
+  std::string field_type = std::move(format_field->type);
+  std::string field_name = std::move(format_field->name);
 
   if (field_type.find("__data_loc") != std::string::npos) {
     // Note that the type here (ie `int`) does not matter. Later during parse
@@ -232,6 +385,121 @@ std::string TracepointFormatParser::adjust_integer_types(
   return new_type;
 }
 
+std::shared_ptr<Struct> TracepointFormatParser::get_tracepoint_record(
+    std::istream &format_file)
+{
+  auto record = std::make_shared<Struct>(0, false);
+  int last_offset = 0;
+  int end = 0;
+  int align = 1;
+
+  for (std::string line; getline(format_file, line);) {
+    auto field = parse_format_field(line);
+    if (!field)
+      continue;
+
+    // Same padding fields as get_tracepoint_struct() generates, so that the
+    // record is the same as the one clang would produce.
+    int pad_begin = field->offset && last_offset ? last_offset : field->offset;
+    last_offset = field->offset + field->size;
+    if (field->type.empty())
+      continue;
+    for (int offset = pad_begin; offset < field->offset; offset++)
+      record->AddField("__pad_" + std::to_string(offset),
+                       create_integer(INTEGER_TYPES.at("char")),
+                       offset);
+
+    SizedType type;
+    int field_align = 1;
+    bool is_data_loc = false;
+    std::string name = field->name;
+    if (field->type.find("__data_loc") != std::string::npos) {
+      // See parse_field(), the C definition has an int here which is then
+      // read as a u64.
+      type = CreateInt64();
+      is_data_loc = true;
+      field_align = 4;
+    } else if (auto arr_size_pos = name.find('[');
+               arr_size_pos != std::string::npos) {
+      auto arr_size = name.substr(arr_size_pos + 1,
+                                  name.find(']') - arr_size_pos - 1);
+      if (arr_size.empty() ||
+          arr_size.find_first_not_of("0123456789") != std::string::npos ||
+          name.find('[', arr_size_pos + 1) != std::string::npos)
+        return nullptr;
+      auto num_elements = std::stoul(arr_size);
+      name = name.substr(0, arr_size_pos);
+
+      auto elem = split_pointer_type(field->type);
+      if (!elem || elem->second != 0)
+        return nullptr;
+      auto integer = INTEGER_TYPES.find(elem->first);
+      if (integer == INTEGER_TYPES.end())
+        return nullptr;
+      // Plain char arrays are strings, signed and unsigned char ones are not.
+      if (elem->first == "char")
+        type = CreateString(num_elements);
+      else
+        type = CreateArray(num_elements, create_integer(integer->second));
+      field_align = integer->second.size;
+    } else {
+      auto split = split_pointer_type(
+          adjust_integer_types(field->type, field->size));
+      if (!split)
+        return nullptr;
+      auto &[base, pointer_levels] = *split;
+      auto integer = INTEGER_TYPES.find(base);
+      if (pointer_levels > 0) {
+        if (base == "void")
+          type = CreateNone();
+        else if (integer != INTEGER_TYPES.end())
+          type = create_integer(integer->second);
+        else
+          return nullptr;
+        for (int i = 0; i < pointer_levels; i++)
+          type = CreatePointer(type);
+        field_align = 8;
+      } else {
+        if (integer == INTEGER_TYPES.end() ||
+            integer->second.size != field->size)
+          return nullptr;
+        type = create_integer(integer->second);
+        field_align = field->size;
+      }
+    }
+
+    record->AddField(name, type, field->offset, std::nullopt, is_data_loc);
+    end = std::max(end, field->offset + field->size);
+    align = std::max(align, field_align);
+  }
+
+  if (!record->HasFields())
+    return nullptr;
+  record->size = (end + align - 1) / align * align;
+  return record;
+}
+
+void TracepointFormatParser::add_tracepoint_struct(
+    std::istream &format_file,
+    const std::string &category,
+    const std::string &event_name,
+    BPFtrace &bpftrace,
+    std::string &c_definitions)
+{
+  std::stringstream format;
+  format << format_file.rdbuf();
+  if (auto record = get_tracepoint_record(format)) {
+    bpftrace.structs.Add(get_struct_name(category, event_name),
+                         std::move(record));
+    return;
+  }
+
+  format.clear();
+  format.seekg(0);
+  c_definitions += get_tracepoint_struct(
+      format, category, event_name, bpftrace);
+}
+
 std::string TracepointFormatParser::get_tracepoint_struct(
     std::istream &format_file,
     const std::string &category,
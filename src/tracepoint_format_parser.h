@@ -1,6 +1,7 @@
 #pragma once
 
 #include <istream>
+#include <memory>
 #include <set>
 
 #include "ast/pass_manager.h"
@@ -33,6 +34,18 @@ protected:
                                            const std::string &category,
                                            const std::string &event_name,
                                            BPFtrace &bpftrace);
+  // Builds the record for a tracepoint directly from its format file, so
+  // that it does not have to go through clang. Returns nullptr if any field
+  // has a type that only clang can resolve (structs, enums, unknown typedefs).
+  static std::shared_ptr<Struct> get_tracepoint_record(
+      std::istream &format_file);
+
+private:
+  static void add_tracepoint_struct(std::istream &format_file,
+                                    const std::string &category,
+                                    const std::string &event_name,
+                                    BPFtrace &bpftrace,
+                                    std::string &c_definitions);
 };
 
 ast::Pass CreateParseTracepointFormatPass();
@@ -6,6 +6,7 @@
 #include "struct.h"
 #include "types.h"
 #include "util/exceptions.h"
+#include "util/sketch.h"
 
 namespace bpftrace {
 
@@ -87,6 +88,9 @@ std::string typestr(const SizedType &type, bool debug)
     case Type::hist_t:
     case Type::lhist_t:
     case Type::tseries_t:
+    case Type::topk_t:
+    case Type::quantiles_t:
+    case Type::distinct_t:
     case Type::none:
     case Type::voidtype:
     case Type::boolean:
@@ -207,6 +211,9 @@ std::string typestr(Type t)
     case Type::hist_t:     return "hist_t";     break;
     case Type::lhist_t:    return "lhist_t";    break;
     case Type::tseries_t:    return "tseries_t";    break;
+    case Type::topk_t:     return "topk_t";     break;
+    case Type::distinct_t: return "distinct_t"; break;
+    case Type::quantiles_t: return "quantiles_t"; break;
     case Type::count_t:    return "count_t";    break;
     case Type::sum_t:      return "sum_t";      break;
     case Type::min_t:      return "min_t";      break;
@@ -378,6 +385,7 @@ SizedType CreateStack(bool kernel, StackType stack)
   auto st = SizedType(kernel ? Type::kstack_t : Type::ustack_t,
                       kernel ? 16 : 24);
   st.stack_type = stack;
+  st.stack_type.kernel = kernel;
   return st;
 }
 
@@ -411,6 +419,16 @@ SizedType CreateStats(bool is_signed)
   return { Type::stats_t, 8, is_signed };
 }
 
+SizedType CreateDistinct()
+{
+  return { Type::distinct_t, DISTINCT_REGISTERS };
+}
+
+SizedType CreateQuantiles()
+{
+  return { Type::quantiles_t, 8 };
+}
+
 SizedType CreateUsername()
 {
   return { Type::username, 8 };
@@ -438,6 +456,11 @@ SizedType CreateTSeries()
   return { Type::tseries_t, 8 };
 }
 
+SizedType CreateTopk()
+{
+  return { Type::topk_t, 8 };
+}
+
 SizedType CreateUSym()
 {
   return { Type::usym_t, 16 };
@@ -630,7 +653,8 @@ bool SizedType::FitsInto(const SizedType &t) const
 bool SizedType::NeedsPercpuMap() const
 {
   return IsHistTy() || IsLhistTy() || IsCountTy() || IsSumTy() || IsMinTy() ||
-         IsMaxTy() || IsAvgTy() || IsStatsTy() || IsTSeriesTy();
+         IsMaxTy() || IsAvgTy() || IsStatsTy() || IsTSeriesTy() ||
+         IsDistinctTy() || IsQuantilesTy();
 }
 
 std::ostream &operator<<(std::ostream &os, TSeriesAggFunc agg)
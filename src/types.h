@@ -30,12 +30,15 @@ enum class Type : uint8_t {
   hist_t,
   lhist_t,
   tseries_t,
+  topk_t,
   count_t,
   sum_t,
   min_t,
   max_t,
   avg_t,
   stats_t,
+  distinct_t,
+  quantiles_t,
   kstack_t,
   ustack_t,
   string,
@@ -75,12 +78,16 @@ enum class StackMode : uint8_t {
   bpftrace,
   perf,
   raw,
+  // User frames are captured as build-id + file offset and kernel frames as
+  // addresses, to be symbolized offline.
+  build_id,
 };
 
 const std::map<StackMode, std::string> STACK_MODE_NAME_MAP = {
   { StackMode::bpftrace, "bpftrace" },
   { StackMode::perf, "perf" },
   { StackMode::raw, "raw" },
+  { StackMode::build_id, "build_id" },
 };
 
 template <>
@@ -98,7 +105,8 @@ struct ConfigParser<StackMode> {
     }
     return make_error<ParseError>(key,
                                   "Invalid value for stack_mode: valid "
-                                  "values are bpftrace, raw and perf.");
+                                  "values are bpftrace, raw, perf and "
+                                  "build_id.");
   }
   Result<OK> parse(const std::string &key,
                    [[maybe_unused]] StackMode *target,
@@ -106,7 +114,8 @@ struct ConfigParser<StackMode> {
   {
     return make_error<ParseError>(key,
                                   "Invalid value for stack_mode: valid "
-                                  "values are bpftrace, raw and perf.");
+                                  "values are bpftrace, raw, perf and "
+                                  "build_id.");
   }
 };
 
@@ -114,18 +123,35 @@ struct StackType {
   // N.B. the limit of 127 defines the default stack size.
   uint16_t limit = 127;
   StackMode mode = StackMode::bpftrace;
+  // Kernel and user stacks only differ in build_id mode, where they need
+  // separate maps.
+  bool kernel = false;
+
+  bool has_build_id_frames() const
+  {
+    return mode == StackMode::build_id && !kernel;
+  }
 
   bool operator==(const StackType &obj) const
   {
-    return limit == obj.limit && mode == obj.mode;
+    return limit == obj.limit && mode == obj.mode &&
+           (mode != StackMode::build_id || kernel == obj.kernel);
   }
 
   std::string name() const
   {
-    return "stack_" + STACK_MODE_NAME_MAP.at(mode) + "_" +
+    std::string kind = mode == StackMode::build_id && kernel ? "_kernel" : "";
+    return "stack_" + STACK_MODE_NAME_MAP.at(mode) + kind + "_" +
            std::to_string(limit);
   }
 
+  // Size of a stack map value in 64-bit words. In build_id mode, user stack
+  // frames are a struct bpf_stack_build_id (4 words) instead of an address.
+  uint32_t value_words() const
+  {
+    return has_build_id_frames() ? limit * 4 : limit;
+  }
+
   static const std::string &scratch_name()
   {
     static const std::string scratch_name = "stack_scratch";
@@ -137,7 +163,7 @@ private:
   template <typename Archive>
   void serialize(Archive &archive)
   {
-    archive(limit, mode);
+    archive(limit, mode, kernel);
   }
 };
 
@@ -389,6 +415,10 @@ public:
   {
     return type_ == Type::tseries_t;
   };
+  bool IsTopkTy() const
+  {
+    return type_ == Type::topk_t;
+  };
   bool IsCountTy() const
   {
     return type_ == Type::count_t;
@@ -413,6 +443,14 @@ public:
   {
     return type_ == Type::stats_t;
   };
+  bool IsDistinctTy() const
+  {
+    return type_ == Type::distinct_t;
+  };
+  bool IsQuantilesTy() const
+  {
+    return type_ == Type::quantiles_t;
+  };
   bool IsKstackTy() const
   {
     return type_ == Type::kstack_t;
@@ -498,11 +536,13 @@ public:
   }
 
   // These are special map value types that use multiple keys to store a single
-  // logical value (from the user perspective).
+  // logical value (from the user perspective). topk() is included as the value
+  // of each key is only meaningful together with the map's sketch.
   bool IsMultiKeyMapTy() const
   {
     return type_ == Type::hist_t || type_ == Type::lhist_t ||
-           type_ == Type::tseries_t;
+           type_ == Type::tseries_t || type_ == Type::topk_t ||
+           type_ == Type::quantiles_t;
   }
 
   bool NeedsPercpuMap() const;
@@ -561,10 +601,13 @@ SizedType CreateSum(bool is_signed);
 SizedType CreateCount();
 SizedType CreateAvg(bool is_signed);
 SizedType CreateStats(bool is_signed);
+SizedType CreateDistinct();
+SizedType CreateQuantiles();
 SizedType CreateUsername();
 SizedType CreateInet(size_t size);
 SizedType CreateLhist();
 SizedType CreateTSeries();
+SizedType CreateTopk();
 SizedType CreateHist();
 SizedType CreateUSym();
 SizedType CreateKSym();
@@ -598,6 +641,10 @@ struct hash<bpftrace::StackType> {
         return std::hash<std::string>()("perf#" + to_string(obj.limit));
       case bpftrace::StackMode::raw:
         return std::hash<std::string>()("raw#" + to_string(obj.limit));
+      case bpftrace::StackMode::build_id:
+        return std::hash<std::string>()((obj.kernel ? "build_id_kernel#"
+                                                    : "build_id#") +
+                                        to_string(obj.limit));
     }
 
     return {}; // unreached
@@ -8,6 +8,7 @@
 #include "log.h"
 #include "usdt.h"
 #include "util/system.h"
+#include "util/timing.h"
 
 namespace bpftrace {
 
@@ -122,6 +123,7 @@ void USDTHelper::read_probes_for_pid(int pid, bool print_error)
 {
   if (pid_cache.contains(pid))
     return;
+  util::TimingSpan span("usdt", "pid " + std::to_string(pid));
 
   void *ctx = bcc_usdt_new_frompid(pid, nullptr);
   if (ctx == nullptr) {
@@ -145,6 +147,7 @@ void USDTHelper::read_probes_for_path(const std::string &path)
 {
   if (path_cache.contains(path))
     return;
+  util::TimingSpan span("usdt", path);
 
   void *ctx = bcc_usdt_new_frompath(path.c_str());
   if (ctx == nullptr) {
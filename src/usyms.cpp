@@ -1,6 +1,8 @@
 #include "types.h"
 #include <bcc/bcc_elf.h>
+#include <algorithm>
 #include <bcc/bcc_syms.h>
+#include <iterator>
 #include <sstream>
 
 #ifdef HAVE_BLAZESYM
@@ -8,10 +10,12 @@
 #endif
 
 #include "config.h"
+#include "cxxdemangler/cxxdemangler.h"
 #include "scopeguard.h"
 #include "usyms.h"
 #include "util/symbols.h"
 #include "util/system.h"
+#include "util/timing.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
@@ -142,7 +146,7 @@ void Usyms::cache_bcc(const std::string &elf_file, std::optional<int> opt_pid)
   // might be different
   if (cache_type == UserSymbolCacheType::per_program &&
       !symbol_table_cache_.contains(elf_file))
-    symbol_table_cache_[elf_file] = util::get_symbol_table_for_elf(elf_file);
+    symbol_table_cache_[elf_file] = util::ElfSymbolTable::get(elf_file);
 
   if (cache_type == UserSymbolCacheType::per_pid) {
     // preload symbol tables from running processes
@@ -213,6 +217,7 @@ void Usyms::cache_blazesym(const std::string &elf_file,
 
 void Usyms::cache(const std::string &elf_file, std::optional<int> pid)
 {
+  util::TimingSpan span("symbols", elf_file);
 #ifdef HAVE_BLAZESYM
   if (config_.use_blazesym) {
     cache_blazesym(elf_file, pid);
@@ -222,12 +227,68 @@ void Usyms::cache(const std::string &elf_file, std::optional<int> pid)
   cache_bcc(elf_file, pid);
 }
 
+std::optional<std::string> Usyms::resolve_snapshot(
+    uint64_t addr,
+    const ProcessSnapshot &process,
+    bool show_offset,
+    bool perf_mode)
+{
+  auto mapping = std::ranges::upper_bound(process.mappings,
+                                          addr,
+                                          {},
+                                          &util::ProcMapping::start);
+  if (mapping == process.mappings.begin() || addr >= std::prev(mapping)->end)
+    return std::nullopt;
+  --mapping;
+
+  // The file may have been replaced since the process mapped it, e.g. by a
+  // package upgrade, it is only used if it still has the same build-id.
+  const auto &build_id =
+      process.build_ids.at(mapping - process.mappings.begin());
+  if (build_id.empty())
+    return std::nullopt;
+  auto binary = snapshot_binaries_.find(build_id);
+  if (binary == snapshot_binaries_.end()) {
+    std::shared_ptr<const util::ElfIndex> index;
+    if (util::get_elf_build_id(mapping->path) == build_id)
+      index = util::ElfIndex::get(mapping->path);
+    binary = snapshot_binaries_.emplace(build_id, std::move(index)).first;
+  }
+  if (!binary->second)
+    return std::nullopt;
+
+  auto vaddr = binary->second->address(addr - mapping->start +
+                                       mapping->file_offset);
+  if (!vaddr)
+    return std::nullopt;
+  auto sym = binary->second->lookup(*vaddr);
+  if (!sym)
+    return std::nullopt;
+
+  std::ostringstream symbol;
+  char *demangled = config_.cpp_demangle
+                        ? cxxdemangle(std::string(sym->name).c_str())
+                        : nullptr;
+  if (demangled) {
+    symbol << demangled;
+    ::free(demangled);
+  } else {
+    symbol << sym->name;
+  }
+  if (show_offset)
+    symbol << "+" << *vaddr - sym->start;
+  if (perf_mode)
+    symbol << " (" << mapping->path << ")";
+  return symbol.str();
+}
+
 std::string Usyms::resolve_bcc(uint64_t addr,
                                int32_t pid,
-                               const std::string &pid_exe,
+                               const ProcessSnapshot &process,
                                bool show_offset,
                                bool perf_mode)
 {
+  const std::string &pid_exe = process.exe;
   const auto cache_type = config_.user_symbol_cache_type;
   struct bcc_symbol usym;
   std::ostringstream symbol;
@@ -238,20 +299,18 @@ std::string Usyms::resolve_bcc(uint64_t addr,
       // try to resolve symbol directly from program file
       // this might work when the process does not exist anymore, but cannot
       // resolve all symbols, e.g. those in a dynamically linked library
-      std::map<uintptr_t, elf_symbol, std::greater<>> &symbol_table =
-          symbol_table_cache_.contains(pid_exe)
-              ? symbol_table_cache_[pid_exe]
-              : (symbol_table_cache_[pid_exe] = util::get_symbol_table_for_elf(
-                     pid_exe));
-      auto sym = symbol_table.lower_bound(addr);
-      // address has to be either the start of the symbol (for symbols of
-      // length 0) or in [start, end)
-      if (sym != symbol_table.end() &&
-          (addr == sym->second.start ||
-           (addr >= sym->second.start && addr < sym->second.end))) {
-        symbol << sym->second.name;
+      auto it = symbol_table_cache_.find(pid_exe);
+      if (it == symbol_table_cache_.end())
+        it = symbol_table_cache_
+                 .emplace(pid_exe, util::ElfSymbolTable::get(pid_exe))
+                 .first;
+      std::optional<util::elf_symbol> sym;
+      if (it->second)
+        sym = it->second->lookup(addr);
+      if (sym) {
+        symbol << sym->name;
         if (show_offset)
-          symbol << "+" << addr - sym->second.start;
+          symbol << "+" << addr - sym->start;
         if (perf_mode)
           symbol << " (" << pid_exe << ")";
         return symbol.str();
@@ -300,6 +359,10 @@ std::string Usyms::resolve_bcc(uint64_t addr,
       symbol << "+" << usym.offset;
     if (perf_mode)
       symbol << " (" << usym.module << ")";
+  } else if (auto sym = resolve_snapshot(
+                 addr, process, show_offset, perf_mode)) {
+    // The process is gone, or the address is in a library it unmapped.
+    symbol << *sym;
   } else {
     symbol << reinterpret_cast<void *>(addr);
     if (perf_mode)
@@ -386,17 +449,19 @@ std::vector<std::string> Usyms::resolve_blazesym_impl(
   return str_syms;
 }
 
-std::vector<std::string> Usyms::resolve_blazesym(uint64_t addr,
-                                                 int32_t pid,
-                                                 const std::string &pid_exe,
-                                                 bool show_offset,
-                                                 bool perf_mode,
-                                                 bool show_debug_info)
+std::vector<std::string> Usyms::resolve_blazesym(
+    uint64_t addr,
+    int32_t pid,
+    const ProcessSnapshot &process,
+    bool show_offset,
+    bool perf_mode,
+    bool show_debug_info)
 {
   auto syms = resolve_blazesym_impl(
-      addr, pid, pid_exe, show_offset, perf_mode, show_debug_info);
+      addr, pid, process.exe, show_offset, perf_mode, show_debug_info);
   if (syms.empty()) {
-    syms.push_back(stringify_addr(addr, perf_mode));
+    auto sym = resolve_snapshot(addr, process, show_offset, perf_mode);
+    syms.push_back(sym ? *sym : stringify_addr(addr, perf_mode));
   }
   return syms;
 }
@@ -404,7 +469,7 @@ std::vector<std::string> Usyms::resolve_blazesym(uint64_t addr,
 
 std::vector<std::string> Usyms::resolve(uint64_t addr,
                                         int32_t pid,
-                                        const std::string &pid_exe,
+                                        const ProcessSnapshot &process,
                                         bool show_offset,
                                         bool perf_mode,
                                         [[maybe_unused]] bool show_debug_info)
@@ -412,10 +477,10 @@ std::vector<std::string> Usyms::resolve(uint64_t addr,
 #ifdef HAVE_BLAZESYM
   if (config_.use_blazesym)
     return resolve_blazesym(
-        addr, pid, pid_exe, show_offset, perf_mode, show_debug_info);
+        addr, pid, process, show_offset, perf_mode, show_debug_info);
 #endif
   return std::vector<std::string>{
-    resolve_bcc(addr, pid, pid_exe, show_offset, perf_mode)
+    resolve_bcc(addr, pid, process, show_offset, perf_mode)
   };
 }
 
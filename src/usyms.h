@@ -4,16 +4,30 @@
 #include <bcc/bcc_syms.h>
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "util/symbols.h"
+#include "util/system.h"
 
 namespace bpftrace {
 
-using util::elf_symbol;
-
 class Config;
 
+// What is known about a process when it is first seen. Its executable
+// mappings and their build-ids are kept, so that addresses can still be
+// resolved after the process exited.
+struct ProcessSnapshot {
+  std::string exe;
+  uint64_t start_time = 0;
+  std::vector<util::ProcMapping> mappings;
+  // Build-id of every mapping, by index.
+  std::vector<std::string> build_ids;
+};
+
 class Usyms {
 public:
   Usyms(const Config& config);
@@ -25,7 +39,7 @@ public:
   void cache(const std::string& elf_file, std::optional<int> pid);
   std::vector<std::string> resolve(uint64_t addr,
                                    int32_t pid,
-                                   const std::string& pid_exe,
+                                   const ProcessSnapshot& process,
                                    bool show_offset,
                                    bool perf_mode,
                                    bool show_debug_info);
@@ -35,13 +49,22 @@ private:
   // note: exe_sym_ is used when layout is same for all instances of program
   std::map<std::string, std::pair<int, void*>> exe_sym_; // exe -> (pid, cache)
   std::map<int, void*> pid_sym_;                         // pid -> cache
-  std::map<std::string, std::map<uintptr_t, elf_symbol, std::greater<>>>
+  std::map<std::string, std::shared_ptr<const util::ElfSymbolTable>>
       symbol_table_cache_;
+  // Binaries of process snapshots by build-id, nullptr if the file on disk
+  // is no longer the one that was mapped.
+  std::unordered_map<std::string, std::shared_ptr<const util::ElfIndex>>
+      snapshot_binaries_;
+
+  std::optional<std::string> resolve_snapshot(uint64_t addr,
+                                              const ProcessSnapshot& process,
+                                              bool show_offset,
+                                              bool perf_mode);
 
   void cache_bcc(const std::string& elf_file, std::optional<int> opt_pid);
   std::string resolve_bcc(uint64_t addr,
                           int32_t pid,
-                          const std::string& pid_exe,
+                          const ProcessSnapshot& process,
                           bool show_offset,
                           bool perf_mode);
   struct bcc_symbol_option& get_symbol_opts();
@@ -59,7 +82,7 @@ private:
                                                  bool show_debug_info);
   std::vector<std::string> resolve_blazesym(uint64_t addr,
                                             int32_t pid,
-                                            const std::string& pid_exe,
+                                            const ProcessSnapshot& process,
                                             bool show_offset,
                                             bool perf_mode,
                                             bool show_debug_info);
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bpftrace::util {
+
+// A bump allocator for many small objects that all live until the arena is
+// cleared or destroyed, e.g. AST nodes.
+//
+// Objects are placed one after another in large slabs, so allocating is
+// mostly a pointer increment and objects created together are close in
+// memory. Only objects with a non-trivial destructor are remembered, and
+// these are destroyed in reverse order of creation. Objects are never freed
+// individually.
+class Arena {
+public:
+  Arena() = default;
+  ~Arena()
+  {
+    clear();
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  template <typename T, typename... Args>
+  T *make(Args &&...args)
+  {
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+    void *mem = allocate(sizeof(T), alignof(T));
+    T *obj = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      destructors_.push_back(
+          { obj, [](void *ptr) { static_cast<T *>(ptr)->~T(); } });
+    }
+    count_++;
+    return obj;
+  }
+
+  // Destroys all objects. The slabs are kept and reused for new objects.
+  void clear()
+  {
+    for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it)
+      it->destroy(it->ptr);
+    destructors_.clear();
+    count_ = 0;
+    current_ = 0;
+    used_ = 0;
+  }
+
+  // Number of objects created since the last clear().
+  size_t size() const
+  {
+    return count_;
+  }
+
+  static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+private:
+  struct Slab {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+  struct Destructor {
+    void *ptr;
+    void (*destroy)(void *);
+  };
+
+  void *allocate(size_t size, size_t align)
+  {
+    while (current_ < slabs_.size()) {
+      auto &slab = slabs_[current_];
+      // Slabs are allocated with new[], which aligns them for all types that
+      // do not ask for extended alignment.
+      size_t offset = (used_ + align - 1) & ~(align - 1);
+      if (offset + size <= slab.size) {
+        used_ = offset + size;
+        return slab.data.get() + offset;
+      }
+      current_++;
+      used_ = 0;
+    }
+
+    // Objects larger than a slab get a slab of their own.
+    size_t slab_size = std::max(SLAB_SIZE, size);
+    // Not value-initialized, the memory is overwritten by the objects.
+    slabs_.push_back(
+        { std::unique_ptr<std::byte[]>(new std::byte[slab_size]), slab_size });
+    current_ = slabs_.size() - 1;
+    used_ = size;
+    return slabs_.back().data.get();
+  }
+
+  std::vector<Slab> slabs_;
+  // The slab that is currently filled, and how much of it is used.
+  size_t current_ = 0;
+  size_t used_ = 0;
+  std::vector<Destructor> destructors_;
+  size_t count_ = 0;
+};
+
+} // namespace bpftrace::util
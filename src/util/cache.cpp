@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "log.h"
+#include "util/cache.h"
+#include "util/paths.h"
+
+namespace bpftrace::util {
+
+static bool is_private_dir(const std::filesystem::path &dir)
+{
+  uid_t euid = geteuid();
+  std::filesystem::path current;
+  for (const auto &part : dir) {
+    current /= part;
+    struct stat st;
+    if (::lstat(current.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+      return false;
+    // Parents may be shared with root, e.g. /var, and may be sticky, e.g.
+    // /tmp, as others cannot replace our entries there. The directory itself
+    // must be ours alone.
+    bool last = current == dir;
+    if (st.st_uid != euid && (last || st.st_uid != 0))
+      return false;
+    if ((st.st_mode & (S_IWGRP | S_IWOTH)) &&
+        (last || !(st.st_mode & S_ISVTX)))
+      return false;
+  }
+  return true;
+}
+
+std::optional<std::filesystem::path> get_cache_subdir(std::string_view name)
+{
+  auto cache_dir = get_cache_dir();
+  if (!cache_dir)
+    return std::nullopt;
+
+  // Parents such as ~/.cache are created as usual, the cache directories
+  // themselves are private.
+  auto dir = *cache_dir / name;
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir->parent_path(), ec);
+  if ((::mkdir(cache_dir->c_str(), 0700) != 0 && errno != EEXIST) ||
+      (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST)) {
+    LOG(V1) << "Cannot create cache directory " << dir << ": "
+            << strerror(errno);
+    return std::nullopt;
+  }
+
+  auto real_dir = std::filesystem::canonical(dir, ec);
+  if (ec || !is_private_dir(real_dir)) {
+    LOG(V1) << "Not using cache directory " << dir
+            << " as it may be modified by other users";
+    return std::nullopt;
+  }
+  return real_dir;
+}
+
+int open_cache_file(const std::filesystem::path &path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_uid != geteuid()) {
+    LOG(V1) << "Ignoring cache file " << path << " not owned by us";
+    ::close(fd);
+    return -1;
+  }
+  ::futimens(fd, nullptr);
+  return fd;
+}
+
+void trim_cache_dir(const std::filesystem::path &dir, uint64_t max_bytes)
+{
+  struct CacheFile {
+    std::filesystem::file_time_type mtime;
+    uintmax_t size;
+    std::filesystem::path path;
+  };
+  std::vector<CacheFile> files;
+  uint64_t total = 0;
+
+  std::error_code ec;
+  std::filesystem::directory_iterator it(dir, ec), end;
+  for (; !ec && it != end; it.increment(ec)) {
+    std::error_code entry_ec;
+    if (it->symlink_status(entry_ec).type() !=
+        std::filesystem::file_type::regular)
+      continue;
+    auto size = it->file_size(entry_ec);
+    auto mtime = it->last_write_time(entry_ec);
+    if (entry_ec)
+      continue;
+    files.push_back({ mtime, size, it->path() });
+    total += size;
+  }
+  if (total <= max_bytes)
+    return;
+
+  std::ranges::sort(files, {}, &CacheFile::mtime);
+  for (const auto &file : files) {
+    if (total <= max_bytes)
+      break;
+    if (std::filesystem::remove(file.path, ec))
+      total -= file.size;
+  }
+}
+
+} // namespace bpftrace::util
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+namespace bpftrace::util {
+
+// Returns the directory `name` below get_cache_dir(), creating it if needed.
+//
+// Cached files are loaded by the current user, which is usually root. To keep
+// other users from planting or replacing them, the directory and all of its
+// parents must be owned by root or the current user and must not be writable
+// by anyone else (sticky parents such as /tmp are allowed). Otherwise, e.g.
+// when root runs with the $HOME of another user, caching is disabled and
+// nullopt is returned. The returned path has all symlinks resolved.
+std::optional<std::filesystem::path> get_cache_subdir(std::string_view name);
+
+// Opens a file in a cache directory for reading and returns its descriptor,
+// or -1. Symlinks are not followed and only regular files owned by the
+// current user are accepted. Opening a file marks it as recently used for
+// trim_cache_dir().
+int open_cache_file(const std::filesystem::path &path);
+
+// Removes the least recently used files from a cache directory until the
+// total size of its files is at most `max_bytes`.
+void trim_cache_dir(const std::filesystem::path &dir, uint64_t max_bytes);
+
+} // namespace bpftrace::util
@@ -12,15 +12,19 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstddef>
 #include <cstring>
 #include <fcntl.h>
 #include <filesystem>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <ranges>
 #include <regex>
+#include <sys/inotify.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "util/cgroup.h"
 #include "util/exceptions.h"
@@ -31,35 +35,12 @@ namespace bpftrace::util {
 std::string get_cgroup_path_in_hierarchy(uint64_t cgroupid,
                                          std::string base_path)
 {
-  static std::map<std::pair<uint64_t, std::string>, std::string> path_cache;
-  struct stat path_st;
-
-  auto cached_path = path_cache.find({ cgroupid, base_path });
-  if (cached_path != path_cache.end() &&
-      stat(cached_path->second.c_str(), &path_st) >= 0 &&
-      path_st.st_ino == cgroupid)
-    return cached_path->second;
-
-  // Check for root cgroup path separately, since recursive_directory_iterator
-  // does not iterate over base directory
-  if (stat(base_path.c_str(), &path_st) >= 0 && path_st.st_ino == cgroupid) {
-    path_cache[{ cgroupid, base_path }] = "/";
-    return "/";
-  }
-
-  for (const auto &path_iter :
-       std::filesystem::recursive_directory_iterator(base_path)) {
-    if (stat(path_iter.path().c_str(), &path_st) < 0)
-      return "";
-    if (path_st.st_ino == cgroupid) {
-      // Base directory is not a part of cgroup path
-      path_cache[{ cgroupid, base_path }] = path_iter.path().string().substr(
-          base_path.length());
-      return path_cache[{ cgroupid, base_path }];
-    }
-  }
+  static std::map<std::string, std::unique_ptr<CgroupPathResolver>> resolvers;
 
-  return "";
+  auto &resolver = resolvers[base_path];
+  if (!resolver)
+    resolver = std::make_unique<CgroupPathResolver>(base_path);
+  return resolver->resolve(cgroupid);
 }
 
 std::array<std::vector<std::string>, 2> get_cgroup_hierarchy_roots()
@@ -86,12 +67,42 @@ std::array<std::vector<std::string>, 2> get_cgroup_hierarchy_roots()
   return result;
 }
 
+std::optional<int> get_cgroup_level(const std::string &path)
+{
+  std::error_code ec;
+  auto canonical = std::filesystem::canonical(path, ec);
+  if (ec || !std::filesystem::is_directory(canonical, ec))
+    return std::nullopt;
+
+  auto roots = get_cgroup_hierarchy_roots();
+  for (const auto &root : roots[1]) {
+    auto root_path = std::filesystem::canonical(root, ec);
+    if (ec)
+      continue;
+    auto relative = canonical.lexically_relative(root_path);
+    if (relative.empty() || *relative.begin() == "..")
+      continue;
+    if (relative == ".")
+      return 0;
+    return static_cast<int>(std::distance(relative.begin(), relative.end()));
+  }
+  return std::nullopt;
+}
+
 std::vector<std::pair<std::string, std::string>> get_cgroup_paths(
     uint64_t cgroupid,
     std::string filter)
 {
-  auto roots = get_cgroup_hierarchy_roots();
+  return get_cgroup_paths(cgroupid,
+                          std::move(filter),
+                          get_cgroup_hierarchy_roots());
+}
 
+std::vector<std::pair<std::string, std::string>> get_cgroup_paths(
+    uint64_t cgroupid,
+    std::string filter,
+    const std::array<std::vector<std::string>, 2> &roots)
+{
   // Replace cgroup version with cgroup mount point directory name for cgroupv1
   // roots and "unified" for cgroupv2 roots
   auto types_v1 = roots[0] |
@@ -195,6 +206,12 @@ int name_to_handle_at(int dirfd,
       syscall(SYS_name_to_handle_at, dirfd, pathname, handle, mount_id, flags));
 }
 
+int open_by_handle_at(int mount_fd, struct file_handle *handle, int flags)
+{
+  return static_cast<int>(
+      syscall(SYS_open_by_handle_at, mount_fd, handle, flags));
+}
+
 #endif
 
 // Not embedding file_handle directly in cgid_file_handle, because C++
@@ -246,4 +263,233 @@ uint64_t resolve_cgroupid(const std::string &path)
   return cfh.cgid;
 }
 
+namespace {
+
+// The handle type of kernfs file handles (FILEID_KERNFS in the kernel), whose
+// handle is the 64-bit node id.
+constexpr int KERNFS_HANDLE_TYPE = 0xfe;
+
+constexpr uint32_t WATCH_MASK = IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR;
+
+std::string join_path(const std::string &dir, const std::string &name)
+{
+  return dir == "/" ? "/" + name : dir + "/" + name;
+}
+
+// Erases all keys that are path or below it. Keys starting with path are
+// contiguous in the map, but not all of them are below it, e.g. "/a-b" is
+// between "/a" and "/a/b".
+template <typename V, typename F>
+void erase_subtree(std::map<std::string, V> &map,
+                   const std::string &path,
+                   F on_erase)
+{
+  auto it = map.lower_bound(path);
+  while (it != map.end() && it->first.starts_with(path)) {
+    if (it->first.size() == path.size() || it->first[path.size()] == '/' ||
+        path == "/") {
+      on_erase(it->second);
+      it = map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+} // namespace
+
+CgroupPathResolver::CgroupPathResolver(std::string base_path)
+    : base_path_(std::move(base_path))
+{
+  while (base_path_.size() > 1 && base_path_.back() == '/')
+    base_path_.pop_back();
+
+  mount_fd_ = open(base_path_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (mount_fd_ >= 0) {
+    // Handles only work on kernfs (i.e. cgroup) mounts and opening them needs
+    // CAP_DAC_READ_SEARCH, try it once with the root cgroup.
+    cgid_file_handle cfh;
+    int mount_id;
+    if (name_to_handle_at(mount_fd_,
+                          "",
+                          cfh.as_file_handle_ptr(),
+                          &mount_id,
+                          AT_EMPTY_PATH) == 0 &&
+        cfh.handle_type == KERNFS_HANDLE_TYPE &&
+        cfh.handle_bytes == sizeof(cfh.cgid)) {
+      use_handles_ = resolve_by_handle(cfh.cgid) == "/";
+    }
+  }
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+}
+
+CgroupPathResolver::~CgroupPathResolver()
+{
+  if (mount_fd_ >= 0)
+    close(mount_fd_);
+  if (inotify_fd_ >= 0)
+    close(inotify_fd_);
+}
+
+std::string CgroupPathResolver::resolve(uint64_t cgroupid)
+{
+  process_events();
+
+  auto cached = paths_.find(cgroupid);
+  if (cached != paths_.end()) {
+    // Without inotify, paths are checked every time, as they can be removed
+    // or renamed.
+    if (inotify_fd_ >= 0 || is_valid(cgroupid, cached->second))
+      return cached->second;
+    ids_.erase(cached->second);
+    paths_.erase(cached);
+  }
+
+  std::optional<std::string> path;
+  if (use_handles_)
+    path = resolve_by_handle(cgroupid);
+  if (!path)
+    path = resolve_by_walk(cgroupid);
+  if (!path->empty())
+    add(cgroupid, *path);
+  return *path;
+}
+
+std::optional<std::string> CgroupPathResolver::resolve_by_handle(
+    uint64_t cgroupid)
+{
+  cgid_file_handle cfh;
+  cfh.handle_type = KERNFS_HANDLE_TYPE;
+  cfh.cgid = cgroupid;
+  int fd = open_by_handle_at(mount_fd_,
+                             cfh.as_file_handle_ptr(),
+                             O_PATH | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ESTALE)
+      return "";
+    return std::nullopt;
+  }
+
+  char buf[PATH_MAX];
+  auto link = "/proc/self/fd/" + std::to_string(fd);
+  ssize_t len = readlink(link.c_str(), buf, sizeof(buf));
+  close(fd);
+  if (len < 0 || len == sizeof(buf))
+    return std::nullopt;
+
+  std::string path(buf, len);
+  // Removed cgroups can still be opened while they are being destroyed.
+  if (path.ends_with(" (deleted)"))
+    return "";
+  if (path == base_path_)
+    return "/";
+  // The path is as seen in our mount namespace, which can differ from the
+  // base path e.g. if the hierarchy is mounted more than once.
+  if (!path.starts_with(base_path_ + "/"))
+    return std::nullopt;
+  return path.substr(base_path_.size());
+}
+
+std::string CgroupPathResolver::resolve_by_walk(uint64_t cgroupid)
+{
+  struct stat path_st;
+
+  // Check for root cgroup path separately, since recursive_directory_iterator
+  // does not iterate over base directory
+  if (stat(base_path_.c_str(), &path_st) >= 0 && path_st.st_ino == cgroupid)
+    return "/";
+
+  std::error_code ec;
+  for (auto it = std::filesystem::recursive_directory_iterator(base_path_, ec);
+       !ec && it != std::filesystem::recursive_directory_iterator();
+       it.increment(ec)) {
+    if (stat(it->path().c_str(), &path_st) < 0)
+      return "";
+    if (path_st.st_ino == cgroupid) {
+      // Base directory is not a part of cgroup path
+      return it->path().string().substr(base_path_.length());
+    }
+  }
+
+  return "";
+}
+
+bool CgroupPathResolver::is_valid(uint64_t cgroupid, const std::string &path)
+{
+  struct stat path_st;
+  auto full_path = path == "/" ? base_path_ : base_path_ + path;
+  return stat(full_path.c_str(), &path_st) >= 0 && path_st.st_ino == cgroupid;
+}
+
+bool CgroupPathResolver::watch(const std::string &dir)
+{
+  if (watched_dirs_.contains(dir))
+    return true;
+  auto full_path = dir == "/" ? base_path_ : base_path_ + dir;
+  int wd = inotify_add_watch(inotify_fd_, full_path.c_str(), WATCH_MASK);
+  if (wd < 0)
+    return false;
+  watches_[wd] = dir;
+  watched_dirs_[dir] = wd;
+  return true;
+}
+
+void CgroupPathResolver::add(uint64_t cgroupid, const std::string &path)
+{
+  if (inotify_fd_ >= 0) {
+    // Watch all ancestors, so that removing or renaming any of them is seen.
+    // If we run out of watches, the path is just not remembered.
+    for (size_t pos = 0; pos != std::string::npos && pos < path.size();
+         pos = path.find('/', pos + 1)) {
+      if (!watch(pos == 0 ? "/" : path.substr(0, pos)))
+        return;
+    }
+  }
+  paths_[cgroupid] = path;
+  ids_[path] = cgroupid;
+}
+
+void CgroupPathResolver::remove_subtree(const std::string &path)
+{
+  erase_subtree(ids_, path, [this](uint64_t id) { paths_.erase(id); });
+  // Watches follow directories when they are renamed, so these would report
+  // events with the old path.
+  erase_subtree(watched_dirs_, path, [this](int wd) {
+    inotify_rm_watch(inotify_fd_, wd);
+    watches_.erase(wd);
+  });
+}
+
+void CgroupPathResolver::process_events()
+{
+  if (inotify_fd_ < 0)
+    return;
+
+  alignas(struct inotify_event) char buf[4096];
+  while (true) {
+    ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+    if (len <= 0)
+      return;
+    for (ssize_t pos = 0; pos < len;) {
+      auto *event = reinterpret_cast<struct inotify_event *>(buf + pos);
+      pos += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were lost, start over.
+        remove_subtree("/");
+        continue;
+      }
+      auto dir = watches_.find(event->wd);
+      if (dir == watches_.end())
+        continue;
+      if (event->mask & IN_IGNORED) {
+        watched_dirs_.erase(dir->second);
+        watches_.erase(dir);
+      } else if (event->len > 0) {
+        remove_subtree(join_path(dir->second, event->name));
+      }
+    }
+  }
+}
+
 } // namespace bpftrace::util
@@ -2,11 +2,61 @@
 
 #include <array>
 #include <cstdint>
+#include <map>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace bpftrace::util {
 
+// Resolves cgroup ids to their path in one cgroup hierarchy.
+//
+// A cgroup id is the kernfs node id of the cgroup directory, which is also
+// its file handle. Unknown ids are therefore opened by handle and the path is
+// read back from /proc/self/fd, instead of walking the whole hierarchy. When
+// that is not possible (e.g. no CAP_DAC_READ_SEARCH, or not a kernfs mount)
+// the hierarchy is walked as a fallback.
+//
+// Resolved paths are kept in an index which is kept up to date with inotify
+// watches on the parent directories, so lookups of known ids do not touch
+// the file system at all.
+class CgroupPathResolver {
+public:
+  CgroupPathResolver(std::string base_path);
+  ~CgroupPathResolver();
+
+  CgroupPathResolver(const CgroupPathResolver &) = delete;
+  CgroupPathResolver &operator=(const CgroupPathResolver &) = delete;
+
+  // Returns the path relative to the base path ("/" for the root cgroup), or
+  // an empty string if there is no cgroup with this id.
+  std::string resolve(uint64_t cgroupid);
+
+private:
+  // Returns nullopt if the handle cannot be resolved to a path below the base
+  // path, and an empty string if there is no such cgroup (any more).
+  std::optional<std::string> resolve_by_handle(uint64_t cgroupid);
+  std::string resolve_by_walk(uint64_t cgroupid);
+  bool is_valid(uint64_t cgroupid, const std::string &path);
+  bool watch(const std::string &dir);
+  void add(uint64_t cgroupid, const std::string &path);
+  void remove_subtree(const std::string &path);
+  void process_events();
+
+  std::string base_path_;
+  int mount_fd_ = -1;
+  bool use_handles_ = false;
+  int inotify_fd_ = -1;
+  std::unordered_map<uint64_t, std::string> paths_;
+  // The same index by path, ordered so that all cgroups below a removed or
+  // renamed directory can be found.
+  std::map<std::string, uint64_t> ids_;
+  // Watched directories (relative to the base path) and their watches.
+  std::unordered_map<int, std::string> watches_;
+  std::map<std::string, int> watched_dirs_;
+};
+
 std::string get_cgroup_path_in_hierarchy(uint64_t cgroupid,
                                          std::string base_path);
 
@@ -15,7 +65,18 @@ std::array<std::vector<std::string>, 2> get_cgroup_hierarchy_roots();
 std::vector<std::pair<std::string, std::string>> get_cgroup_paths(
     uint64_t cgroupid,
     std::string filter);
+// Same, with the hierarchy roots from get_cgroup_hierarchy_roots(), so that
+// they are not read from /proc/mounts again for every lookup.
+std::vector<std::pair<std::string, std::string>> get_cgroup_paths(
+    uint64_t cgroupid,
+    std::string filter,
+    const std::array<std::vector<std::string>, 2> &roots);
 
 uint64_t resolve_cgroupid(const std::string &path);
 
+// Returns the depth of a cgroup2 directory below the root of its hierarchy,
+// which is 0 for the root itself, or nullopt if path is not in a cgroup2
+// hierarchy.
+std::optional<int> get_cgroup_level(const std::string &path);
+
 } // namespace bpftrace::util
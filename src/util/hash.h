@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <string_view>
 
 namespace bpftrace::util {
 
@@ -13,4 +15,17 @@ inline void hash_combine(std::size_t &seed, const T &value)
   seed ^= hasher(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 }
 
+// 64-bit FNV-1a. Unlike std::hash, the result is stable across runs and
+// builds, so it can be used to name files that outlive the process. Pass the
+// previous result as `hash` to hash multiple pieces of data.
+inline uint64_t fnv1a_64(std::string_view data,
+                         uint64_t hash = 0xcbf29ce484222325ULL)
+{
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
 } // namespace bpftrace::util
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+#include "util/kallsyms.h"
+
+namespace bpftrace::util {
+
+namespace {
+
+struct KallsymsLine {
+  uint64_t addr;
+  std::string_view name;
+  std::string_view module;
+};
+
+// Parses a line of the form "<addr> <type> <name>[\t[<module>]]".
+std::optional<KallsymsLine> parse_kallsyms_line(std::string_view line)
+{
+  auto type_pos = line.find(' ');
+  if (type_pos == std::string_view::npos || type_pos + 3 > line.size())
+    return std::nullopt;
+
+  KallsymsLine result = {};
+  result.addr = std::strtoull(line.data(), nullptr, 16);
+
+  auto name = line.substr(type_pos + 3);
+  auto tab = name.find('\t');
+  if (tab != std::string_view::npos) {
+    auto module = name.substr(tab + 1);
+    if (module.size() >= 2 && module.front() == '[' && module.back() == ']')
+      result.module = module.substr(1, module.size() - 2);
+    name = name.substr(0, tab);
+  }
+  result.name = name;
+  return result;
+}
+
+} // namespace
+
+bool KallsymsIndex::load()
+{
+  std::ifstream kallsyms("/proc/kallsyms");
+  std::ifstream modules("/proc/modules");
+  if (kallsyms.fail())
+    return false;
+
+  load(kallsyms, modules);
+  last_modules_check_ = std::chrono::steady_clock::now();
+  return size() > 0;
+}
+
+void KallsymsIndex::load(std::istream &kallsyms, std::istream &modules)
+{
+  shards_.clear();
+  update(kallsyms, parse_modules(modules), false);
+}
+
+bool KallsymsIndex::reload(std::istream &kallsyms, std::istream &modules)
+{
+  auto new_modules = parse_modules(modules);
+  if (new_modules == modules_)
+    return false;
+
+  update(kallsyms, std::move(new_modules), true);
+  return true;
+}
+
+bool KallsymsIndex::reload_if_modules_changed(
+    std::chrono::milliseconds interval)
+{
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_modules_check_ < interval)
+    return false;
+  last_modules_check_ = now;
+
+  std::ifstream modules("/proc/modules");
+  auto new_modules = parse_modules(modules);
+  if (new_modules == modules_)
+    return false;
+
+  std::ifstream kallsyms("/proc/kallsyms");
+  if (kallsyms.fail())
+    return false;
+  update(kallsyms, std::move(new_modules), true);
+  return true;
+}
+
+KallsymsIndex::ModuleList KallsymsIndex::parse_modules(std::istream &modules)
+{
+  // Format: "<name> <size> <refcount> <deps> <state> <addr>"
+  ModuleList result;
+  std::string name, size, refcount, deps, state, addr;
+  std::string line;
+  while (std::getline(modules, line)) {
+    std::istringstream fields(line);
+    if (fields >> name >> size >> refcount >> deps >> state >> addr)
+      result[name] = Module{ .addr = std::strtoull(addr.c_str(), nullptr, 16),
+                             .size = std::strtoull(size.c_str(), nullptr, 10) };
+  }
+  return result;
+}
+
+void KallsymsIndex::update(std::istream &kallsyms,
+                           ModuleList &&modules,
+                           bool reload)
+{
+  // On reload, only the modules that are new or were loaded at a different
+  // address need to be read again. The core kernel never changes.
+  std::set<std::string, std::less<>> changed;
+  for (const auto &[name, module] : modules) {
+    auto old = modules_.find(name);
+    if (!reload || old == modules_.end() || old->second != module)
+      changed.insert(name);
+  }
+
+  std::vector<Shard> shards;
+  for (auto &shard : shards_) {
+    if (shard.module.empty() ||
+        (modules.contains(shard.module) && !changed.contains(shard.module)))
+      shards.push_back(std::move(shard));
+  }
+
+  // Everything is read on the first load. On reload, only the modules that
+  // changed and pseudo-modules that are not listed in /proc/modules (e.g.
+  // [bpf]), whose shards were dropped above.
+  auto wanted = [&](std::string_view module) {
+    if (!reload)
+      return true;
+    if (module.empty())
+      return false;
+    return changed.contains(module) || !modules.contains(module);
+  };
+
+  std::unordered_map<std::string, size_t> new_shards;
+  auto get_shard = [&](std::string_view module) -> Shard & {
+    auto it = new_shards.find(std::string(module));
+    if (it == new_shards.end()) {
+      uint64_t end = 0;
+      if (auto listed = modules.find(module);
+          listed != modules.end() && listed->second.addr != 0)
+        end = listed->second.addr + listed->second.size;
+      shards.push_back(Shard{ .module = std::string(module),
+                             .end = end,
+                             .entries = {},
+                             .names = {} });
+      it = new_shards.emplace(module, shards.size() - 1).first;
+    }
+    return shards[it->second];
+  };
+
+  std::string line;
+  while (std::getline(kallsyms, line)) {
+    auto sym = parse_kallsyms_line(line);
+    if (!sym || sym->addr == 0 || !wanted(sym->module))
+      continue;
+    auto &shard = get_shard(sym->module);
+    shard.entries.push_back(Entry{
+        .start = sym->addr,
+        .name_offset = static_cast<uint32_t>(shard.names.size()),
+        .name_size = static_cast<uint32_t>(sym->name.size()),
+    });
+    shard.names.append(sym->name);
+  }
+
+  std::erase_if(shards, [](const Shard &shard) {
+    return shard.entries.empty();
+  });
+  shards_ = std::move(shards);
+
+  index_.clear();
+  for (size_t shard = 0; shard < shards_.size(); shard++) {
+    const auto &entries = shards_[shard].entries;
+    for (size_t entry = 0; entry < entries.size(); entry++)
+      index_.push_back(IndexEntry{ .start = entries[entry].start,
+                                   .shard = static_cast<uint32_t>(shard),
+                                   .entry = static_cast<uint32_t>(entry) });
+  }
+  // Among symbols at the same address, the first one listed wins.
+  std::ranges::stable_sort(index_, {}, &IndexEntry::start);
+  auto duplicates = std::ranges::unique(index_, {}, &IndexEntry::start);
+  index_.erase(duplicates.begin(), duplicates.end());
+  modules_ = std::move(modules);
+}
+
+std::optional<kernel_symbol> KallsymsIndex::lookup(uint64_t addr) const
+{
+  if (index_.empty() || index_[0].start > addr)
+    return std::nullopt;
+
+  // Branchless binary search for the last entry starting at or before addr.
+  const IndexEntry *base = index_.data();
+  size_t len = index_.size();
+  while (len > 1) {
+    size_t half = len / 2;
+    base = base[half].start <= addr ? base + half : base;
+    len -= half;
+  }
+
+  const auto &shard = shards_[base->shard];
+  if (shard.end != 0 && addr >= shard.end)
+    return std::nullopt;
+  return (*this)[base - index_.data()];
+}
+
+kernel_symbol KallsymsIndex::operator[](size_t idx) const
+{
+  const auto &shard = shards_[index_[idx].shard];
+  const auto &entry = shard.entries[index_[idx].entry];
+  return kernel_symbol{
+    .name = std::string_view(shard.names).substr(entry.name_offset,
+                                                 entry.name_size),
+    .module = shard.module,
+    .start = entry.start,
+  };
+}
+
+} // namespace bpftrace::util
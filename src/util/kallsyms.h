@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bpftrace::util {
+
+struct kernel_symbol {
+  std::string_view name;
+  // Empty for symbols of the core kernel.
+  std::string_view module;
+  uint64_t start;
+};
+
+// Kernel symbols read from /proc/kallsyms, sorted by address with the names
+// of each module in a single string pool.
+//
+// The symbols of the core kernel and of every module are kept in separate
+// shards. When modules are loaded or unloaded only their shards are read
+// again, see reload(). Lookups go through a single sorted array of all
+// symbols, since module ranges can interleave with pseudo-modules like [bpf].
+//
+// Symbols returned by lookup() point into the index and are only valid until
+// the next reload.
+class KallsymsIndex {
+public:
+  // Reads /proc/kallsyms and /proc/modules. Returns false if there are no
+  // symbols with an address, which is what non-root users see with
+  // kptr_restrict enabled.
+  bool load();
+  void load(std::istream &kallsyms, std::istream &modules);
+
+  // Resolves addr to the last symbol starting at or before it, like bcc does.
+  // Addresses past the end of a module (according to /proc/modules) are not
+  // resolved, they likely belong to a module loaded after the index was
+  // built.
+  std::optional<kernel_symbol> lookup(uint64_t addr) const;
+
+  // Rebuilds the shards of all modules that were loaded, unloaded or
+  // reloaded since the index was built. Returns true if there were any.
+  bool reload(std::istream &kallsyms, std::istream &modules);
+
+  // Checks /proc/modules for changes, at most once every interval, and
+  // reloads the changed modules. This is cheap enough to be done whenever a
+  // lookup fails.
+  bool reload_if_modules_changed(
+      std::chrono::milliseconds interval = std::chrono::seconds(1));
+
+  size_t size() const
+  {
+    return index_.size();
+  }
+  kernel_symbol operator[](size_t idx) const;
+  size_t shard_count() const
+  {
+    return shards_.size();
+  }
+
+private:
+  struct Entry {
+    uint64_t start;
+    uint32_t name_offset;
+    uint32_t name_size;
+  };
+
+  struct Shard {
+    std::string module;
+    // End of the module's memory, 0 if unknown.
+    uint64_t end;
+    std::vector<Entry> entries;
+    std::string names;
+  };
+
+  struct IndexEntry {
+    uint64_t start;
+    uint32_t shard;
+    uint32_t entry;
+  };
+
+  struct Module {
+    uint64_t addr;
+    uint64_t size;
+    bool operator==(const Module &other) const = default;
+  };
+  // As listed in /proc/modules, by module name.
+  using ModuleList = std::map<std::string, Module, std::less<>>;
+
+  std::vector<Shard> shards_;
+  // All symbols of all shards, sorted by address.
+  std::vector<IndexEntry> index_;
+  ModuleList modules_;
+  std::chrono::steady_clock::time_point last_modules_check_;
+
+  static ModuleList parse_modules(std::istream &modules);
+  void update(std::istream &kallsyms, ModuleList &&modules, bool reload);
+};
+
+} // namespace bpftrace::util
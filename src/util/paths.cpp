@@ -245,6 +245,21 @@ std::optional<std::filesystem::path> find_near_self(std::string_view filename)
   return exe;
 }
 
+std::optional<std::filesystem::path> get_cache_dir()
+{
+  if (const char *dir = std::getenv("BPFTRACE_CACHE_DIR")) {
+    if (*dir == '\0')
+      return std::nullopt;
+    return dir;
+  }
+  if (const char *xdg_cache = std::getenv("XDG_CACHE_HOME");
+      xdg_cache && *xdg_cache)
+    return std::filesystem::path(xdg_cache) / "bpftrace";
+  if (const char *home = std::getenv("HOME"); home && *home)
+    return std::filesystem::path(home) / ".cache" / "bpftrace";
+  return std::nullopt;
+}
+
 bool is_dir(const std::string &path)
 {
   std::error_code ec;
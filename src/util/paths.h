@@ -15,6 +15,10 @@ std::vector<std::string> resolve_binary_path(
 std::optional<std::filesystem::path> find_in_path(std::string_view name);
 // Finds a file in the same directory as running binary
 std::optional<std::filesystem::path> find_near_self(std::string_view name);
+// Directory for persistent caches: $BPFTRACE_CACHE_DIR, $XDG_CACHE_HOME/bpftrace
+// or ~/.cache/bpftrace, in that order. Setting BPFTRACE_CACHE_DIR to an empty
+// value disables caching, in which case nullopt is returned.
+std::optional<std::filesystem::path> get_cache_dir();
 
 bool is_dir(const std::string &path);
 bool is_exe(const std::string &path);
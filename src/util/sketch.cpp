@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include "util/sketch.h"
+
+namespace bpftrace::util {
+
+std::vector<uint64_t> topk_merge_sketch(const std::vector<uint8_t> &values,
+                                        int nvalues)
+{
+  constexpr size_t ncounters = TOPK_SKETCH_ROWS * TOPK_SKETCH_COLS;
+  std::vector<uint64_t> sketch(ncounters, 0);
+  if (nvalues <= 0)
+    return sketch;
+
+  // Per-CPU values are laid out one after the other and are 8-byte aligned.
+  size_t stride = values.size() / nvalues;
+  for (int cpu = 0; cpu < nvalues; cpu++) {
+    const uint8_t *base = values.data() + (cpu * stride);
+    for (size_t i = 0; i < ncounters; i++) {
+      uint32_t counter;
+      std::memcpy(&counter, base + (i * sizeof(uint32_t)), sizeof(counter));
+      sketch[i] += counter;
+    }
+  }
+  return sketch;
+}
+
+uint64_t topk_estimate(const std::vector<uint64_t> &sketch, uint64_t hash)
+{
+  uint64_t estimate = UINT64_MAX;
+  for (uint32_t row = 0; row < TOPK_SKETCH_ROWS; row++) {
+    uint32_t col = topk_sketch_column(hash, row);
+    estimate = std::min(estimate, sketch[(row * TOPK_SKETCH_COLS) + col]);
+  }
+  return estimate;
+}
+
+uint64_t topk_error_bound(const std::vector<uint64_t> &sketch)
+{
+  // Every update increments exactly one counter per row, so any row sums up
+  // to the total number of updates.
+  uint64_t total = 0;
+  for (uint32_t col = 0; col < TOPK_SKETCH_COLS; col++)
+    total += sketch[col];
+  return static_cast<uint64_t>(
+      std::ceil(std::numbers::e * static_cast<double>(total) /
+                TOPK_SKETCH_COLS));
+}
+
+uint64_t distinct_estimate(const std::vector<uint8_t> &registers)
+{
+  const auto m = static_cast<double>(registers.size());
+  if (registers.empty())
+    return 0;
+
+  double sum = 0;
+  size_t zeros = 0;
+  for (uint8_t reg : registers) {
+    sum += std::ldexp(1.0, -static_cast<int>(reg));
+    if (reg == 0)
+      zeros++;
+  }
+
+  const double alpha = 0.7213 / (1 + (1.079 / m));
+  double estimate = alpha * m * m / sum;
+
+  // Small range correction: fall back to linear counting while there are
+  // still empty registers, it is much more accurate there.
+  if (estimate <= 2.5 * m && zeros > 0)
+    estimate = m * std::log(m / static_cast<double>(zeros));
+
+  return static_cast<uint64_t>(std::llround(estimate));
+}
+
+uint64_t quantiles_bucket_value(uint32_t index)
+{
+  // Index 0 holds negative values, which quantiles() counts as 0. The next
+  // 2^(QUANTILES_BITS + 1) indexes hold a single value each.
+  constexpr uint32_t n = 1 << QUANTILES_BITS;
+  if (index <= 2 * n)
+    return index == 0 ? 0 : index - 1;
+
+  const uint32_t bucket = index - 1;
+  const uint32_t power = (bucket >> QUANTILES_BITS) - 1;
+  const uint64_t lower = static_cast<uint64_t>(n + (bucket & (n - 1)))
+                         << power;
+  const uint64_t width = 1ULL << power;
+  return lower + ((width - 1) / 2);
+}
+
+uint64_t quantiles_value(const std::vector<uint64_t> &buckets, double q)
+{
+  uint64_t total = 0;
+  for (uint64_t count : buckets)
+    total += count;
+  if (total == 0)
+    return 0;
+
+  // Rank of the requested quantile, counting from 1.
+  auto rank = static_cast<uint64_t>(
+      std::ceil(q * static_cast<double>(total)));
+  rank = std::clamp<uint64_t>(rank, 1, total);
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+    if (seen >= rank)
+      return quantiles_bucket_value(i);
+  }
+  return quantiles_bucket_value(buckets.size() - 1);
+}
+
+} // namespace bpftrace::util
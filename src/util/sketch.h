@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bpftrace::util {
+
+// topk() keeps a count-min sketch of every key it sees in a per-CPU array of
+// TOPK_SKETCH_ROWS x TOPK_SKETCH_COLS 32-bit counters. Each row picks its
+// column for a key from the same 64-bit key hash by double hashing, so the
+// kernel only needs to hash the key once.
+//
+// With w columns and d rows, an estimate never undercounts and overcounts by
+// more than e/w * N (N being the total number of updates) with probability
+// 1 - e^-d. 4 x 1024 counters take 16KiB per CPU and bound the error to
+// ~0.27% of N with ~98% probability.
+constexpr uint32_t TOPK_SKETCH_ROWS = 4;
+constexpr uint32_t TOPK_SKETCH_COLS = 1024;
+constexpr uint64_t TOPK_DEFAULT_K = 10;
+constexpr uint64_t TOPK_MAX_K = 1000;
+
+static_assert((TOPK_SKETCH_COLS & (TOPK_SKETCH_COLS - 1)) == 0,
+              "TOPK_SKETCH_COLS must be a power of 2");
+
+inline uint32_t topk_sketch_column(uint64_t hash, uint32_t row)
+{
+  return ((hash & 0xffffffff) + (row * (hash >> 32))) &
+         (TOPK_SKETCH_COLS - 1);
+}
+
+// Sum the per-CPU copies of a sketch (as read from the BPF map) into a single
+// flat array of TOPK_SKETCH_ROWS * TOPK_SKETCH_COLS counters.
+std::vector<uint64_t> topk_merge_sketch(const std::vector<uint8_t> &values,
+                                        int nvalues);
+
+// Count-min estimate for the key with the given hash: the smallest of the
+// counters the key maps to.
+uint64_t topk_estimate(const std::vector<uint64_t> &sketch, uint64_t hash);
+
+// Upper bound on how much any estimate from the sketch overcounts.
+uint64_t topk_error_bound(const std::vector<uint64_t> &sketch);
+
+// distinct() keeps a HyperLogLog sketch of 2^DISTINCT_PRECISION one-byte
+// registers per map key. The top DISTINCT_PRECISION bits of a value's 64-bit
+// hash select a register, which records the highest position of the first set
+// bit seen in the remaining bits. 1024 registers give a standard error of
+// ~3.25% (1.04 / sqrt(m)) at any cardinality.
+constexpr uint32_t DISTINCT_PRECISION = 10;
+constexpr uint32_t DISTINCT_REGISTERS = 1U << DISTINCT_PRECISION;
+
+// Estimate the number of distinct values from a single set of merged
+// registers.
+uint64_t distinct_estimate(const std::vector<uint8_t> &registers);
+
+// quantiles() buckets values log-linearly, the same way as
+// hist(n, QUANTILES_BITS): each power of 2 is split into 2^QUANTILES_BITS
+// buckets, so a bucket is never wider than 1/32 of its lower bound. Reporting
+// the middle of a bucket keeps the relative error of any quantile under ~1.6%
+// while a key needs at most a couple of thousand buckets.
+constexpr uint32_t QUANTILES_BITS = 5;
+
+// The quantiles printed for each key.
+constexpr std::array<std::pair<std::string_view, double>, 4> QUANTILES = { {
+    { "p50", 0.5 },
+    { "p90", 0.9 },
+    { "p99", 0.99 },
+    { "p999", 0.999 },
+} };
+
+// Value reported for a hist(n, QUANTILES_BITS) bucket index.
+uint64_t quantiles_bucket_value(uint32_t index);
+
+// Estimate the q-quantile (0 < q <= 1) from bucket counts merged across CPUs.
+uint64_t quantiles_value(const std::vector<uint64_t> &buckets, double q);
+
+} // namespace bpftrace::util
@@ -4,6 +4,8 @@
 #include <cstring>
 #include <vector>
 
+#include "util/sketch.h"
+
 namespace bpftrace::util {
 
 namespace {
@@ -80,4 +82,22 @@ T avg_value(const std::vector<uint8_t> &value, int nvalues)
   return stats_value<T>(value, nvalues).avg;
 }
 
+// distinct() values hold one set of HyperLogLog registers per CPU. Merging
+// takes the maximum of each register across CPUs.
+inline uint64_t distinct_value(const std::vector<uint8_t> &value, int nvalues)
+{
+  std::vector<uint8_t> registers(DISTINCT_REGISTERS, 0);
+  if (nvalues <= 0)
+    return 0;
+  size_t stride = value.size() / nvalues;
+  for (int i = 0; i < nvalues; i++) {
+    const uint8_t *cpu_registers = value.data() + (i * stride);
+    for (uint32_t j = 0; j < DISTINCT_REGISTERS; j++) {
+      if (cpu_registers[j] > registers[j])
+        registers[j] = cpu_registers[j];
+    }
+  }
+  return distinct_estimate(registers);
+}
+
 } // namespace bpftrace::util
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <cstdint>
+#include <iomanip>
 #include <sstream>
 
 #include "util/strings.h"
@@ -98,6 +99,43 @@ std::string hex_format_buffer(const char *buf,
   return str;
 }
 
+std::string json_escape(std::string_view str)
+{
+  std::ostringstream escaped;
+  for (unsigned char c : str) {
+    switch (c) {
+      case '"':
+        escaped << "\\\"";
+        break;
+
+      case '\\':
+        escaped << "\\\\";
+        break;
+
+      case '\n':
+        escaped << "\\n";
+        break;
+
+      case '\r':
+        escaped << "\\r";
+        break;
+
+      case '\t':
+        escaped << "\\t";
+        break;
+
+      default:
+        if (c <= 0x1f) {
+          escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                  << static_cast<int>(c);
+        } else {
+          escaped << c;
+        }
+    }
+  }
+  return escaped.str();
+}
+
 std::string to_lower(const std::string &original)
 {
   std::string lower(original);
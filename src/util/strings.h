@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace bpftrace::util {
@@ -40,6 +41,10 @@ std::string hex_format_buffer(const char *buf,
                               bool keep_ascii = true,
                               bool escape_hex = true);
 
+// Escapes a string for use inside a JSON string literal. Control characters
+// are escaped as well, so the result is always valid JSON.
+std::string json_escape(std::string_view str);
+
 std::string to_lower(const std::string &original);
 bool is_str_bool_truthy(const std::string &value);
 bool is_str_bool_falsy(const std::string &value);
@@ -1,49 +1,546 @@
 #include <bcc/bcc_elf.h>
 #include <bcc/bcc_syms.h>
 #include <bcc/bcc_usdt.h>
+#include <algorithm>
 #include <cstring>
 #include <elf.h>
 #include <fcntl.h>
+#include <filesystem>
+#include <fstream>
 #include <gelf.h>
 #include <glob.h>
 #include <libelf.h>
 #include <link.h>
 #include <linux/limits.h>
 #include <linux/version.h>
+#include <mutex>
 #include <sys/auxv.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/utsname.h>
 #include <unistd.h>
+#include <unordered_map>
 #include <zlib.h>
 
+#include "log.h"
+#include "scopeguard.h"
+#include "util/cache.h"
+#include "util/paths.h"
 #include "util/symbols.h"
 
 namespace bpftrace::util {
 
-std::map<uintptr_t, elf_symbol, std::greater<>> get_symbol_table_for_elf(
+namespace {
+
+struct SymbolTableHeader {
+  char magic[8];
+  uint64_t count;
+  uint64_t names_size;
+};
+
+constexpr char SYMBOL_TABLE_MAGIC[8] = "BTSYMS1";
+
+// Tables of large binaries take a few megabytes.
+constexpr uint64_t MAX_CACHE_SIZE = 256 << 20;
+
+// Returns the build-id of elf_file, or an empty string if it has none. If
+// has_symtab is given, it is set to whether the file has a .symtab section,
+// i.e. whether it is not stripped.
+std::string read_elf_build_id(const std::string &elf_file, bool *has_symtab)
+{
+  if (has_symtab)
+    *has_symtab = false;
+  if (elf_version(EV_CURRENT) == EV_NONE)
+    return "";
+
+  int fd = open(elf_file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return "";
+  SCOPE_EXIT
+  {
+    ::close(fd);
+  };
+
+  Elf *elf = elf_begin(fd, ELF_C_READ, nullptr);
+  if (!elf)
+    return "";
+  SCOPE_EXIT
+  {
+    ::elf_end(elf);
+  };
+
+  std::string build_id;
+  Elf_Scn *section = nullptr;
+  while ((section = elf_nextscn(elf, section)) != nullptr) {
+    GElf_Shdr header;
+    if (!gelf_getshdr(section, &header))
+      continue;
+    if (header.sh_type == SHT_SYMTAB && has_symtab)
+      *has_symtab = true;
+    if (header.sh_type != SHT_NOTE || !build_id.empty())
+      continue;
+    Elf_Data *data = elf_getdata(section, nullptr);
+    if (!data)
+      continue;
+
+    GElf_Nhdr note;
+    size_t offset = 0, name_offset, desc_offset;
+    while ((offset = gelf_getnote(
+                data, offset, &note, &name_offset, &desc_offset)) > 0) {
+      const auto *name = static_cast<const char *>(data->d_buf) + name_offset;
+      if (note.n_type != NT_GNU_BUILD_ID || note.n_namesz != 4 ||
+          memcmp(name, "GNU", 4) != 0)
+        continue;
+
+      const auto *desc = static_cast<const uint8_t *>(data->d_buf) +
+                         desc_offset;
+      for (size_t i = 0; i < note.n_descsz; i++) {
+        static const char digits[] = "0123456789abcdef";
+        build_id += digits[desc[i] >> 4];
+        build_id += digits[desc[i] & 0xf];
+      }
+      break;
+    }
+    if (!build_id.empty() && (!has_symtab || *has_symtab))
+      break;
+  }
+  return build_id;
+}
+
+// Separate debug files are looked up by bcc (among other places) in the
+// build-id directory. Tables are cached separately with and without one, so
+// that installing the debug info invalidates the cached table.
+bool has_build_id_debug_file(const std::string &build_id)
+{
+  std::error_code ec;
+  return std::filesystem::exists("/usr/lib/debug/.build-id/" +
+                                     build_id.substr(0, 2) + "/" +
+                                     build_id.substr(2) + ".debug",
+                                 ec);
+}
+
+// Identifies the contents of elf_file: its build-id or, for binaries without
+// one, the file itself and its modification time. A stripped binary has the
+// same build-id as the unstripped one but fewer symbols, so whether it has a
+// .symtab section is part of the key.
+std::optional<std::string> get_file_key(const std::string &elf_file,
+                                        const std::string &build_id,
+                                        bool has_symtab)
+{
+  std::string suffix = has_symtab ? ":symtab" : ":dynsym";
+  if (!build_id.empty())
+    return build_id + suffix;
+
+  struct stat st;
+  if (stat(elf_file.c_str(), &st) != 0)
+    return std::nullopt;
+  return elf_file + ":" + std::to_string(st.st_dev) + ":" +
+         std::to_string(st.st_ino) + ":" + std::to_string(st.st_mtime) +
+         suffix;
+}
+
+// Identifies a file on disk, to notice when it has been replaced or
+// modified.
+struct FileId {
+  dev_t dev = 0;
+  ino_t ino = 0;
+  struct timespec mtime = {};
+
+  bool operator==(const FileId &other) const
+  {
+    return dev == other.dev && ino == other.ino &&
+           mtime.tv_sec == other.mtime.tv_sec &&
+           mtime.tv_nsec == other.mtime.tv_nsec;
+  }
+};
+
+std::optional<FileId> get_file_id(const std::string &path)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return std::nullopt;
+  return FileId{ .dev = st.st_dev, .ino = st.st_ino, .mtime = st.st_mtim };
+}
+
+} // namespace
+
+ElfSymbolTable::~ElfSymbolTable()
+{
+  if (mapping_)
+    munmap(mapping_, mapping_size_);
+}
+
+std::shared_ptr<const ElfSymbolTable> ElfSymbolTable::get(
     const std::string &elf_file)
 {
-  std::map<uintptr_t, elf_symbol, std::greater<>> symbol_table;
-
-  bcc_elf_symcb sym_resolve_callback = [](const char *name,
-                                          uint64_t start,
-                                          uint64_t length,
-                                          void *payload) {
-    auto *symbol_table =
-        static_cast<std::map<uintptr_t, elf_symbol, std::greater<>> *>(payload);
-    symbol_table->insert({ start,
-                           { .name = std::string(name),
-                             .start = start,
-                             .end = start + length } });
-    return 0;
+  static std::mutex mutex;
+  // Tables are only shared while someone is using them, listing the symbols
+  // of all running processes should not keep them all in memory.
+  static std::unordered_map<std::string, std::weak_ptr<const ElfSymbolTable>>
+      tables;
+
+  bool has_symtab = false;
+  auto build_id = read_elf_build_id(elf_file, &has_symtab);
+  auto key = get_file_key(elf_file, build_id, has_symtab);
+  if (!key)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &shared = tables[*key];
+  if (auto table = shared.lock())
+    return table;
+
+  // Only binaries with a build-id are cached on disk, the id identifies the
+  // contents of the file independently of its path.
+  std::optional<std::filesystem::path> cache_path;
+  if (!build_id.empty()) {
+    if (auto cache_dir = get_cache_subdir("symbols")) {
+      auto name = build_id;
+      if (!has_symtab)
+        name += ".stripped";
+      if (has_build_id_debug_file(build_id))
+        name += ".debug";
+      cache_path = *cache_dir / name;
+    }
+  }
+
+  std::shared_ptr<const ElfSymbolTable> table;
+  if (cache_path)
+    table = load(*cache_path);
+  if (!table) {
+    auto built = build(elf_file);
+    if (!built)
+      return nullptr;
+    if (cache_path) {
+      if (built->save(*cache_path))
+        trim_cache_dir(cache_path->parent_path(), MAX_CACHE_SIZE);
+      else
+        LOG(V1) << "Cannot cache symbols of " << elf_file << " in "
+                << *cache_path;
+    }
+    table = std::move(built);
+  }
+  shared = table;
+  return table;
+}
+
+std::unique_ptr<ElfSymbolTable> ElfSymbolTable::build(
+    const std::string &elf_file)
+{
+  struct Payload {
+    ElfSymbolTable &table;
+    bool is_function;
   };
+
+  auto table = std::make_unique<ElfSymbolTable>();
+  bcc_elf_symcb callback =
+      [](const char *name, uint64_t start, uint64_t size, void *payload) {
+        auto *data = static_cast<Payload *>(payload);
+        data->table.add(name, start, size, data->is_function);
+        return 0;
+      };
+
+  // bcc does not pass the symbol type to the callback, so functions and
+  // other symbols are collected in two passes.
   struct bcc_symbol_option option;
   memset(&option, 0, sizeof(option));
-  option.use_symbol_type = BCC_SYM_ALL_TYPES ^ (1 << STT_NOTYPE);
-  bcc_elf_foreach_sym(
-      elf_file.c_str(), sym_resolve_callback, &option, &symbol_table);
+  option.use_debug_file = 1;
+  option.check_debug_file_crc = 1;
+  const int function_types = (1 << STT_FUNC) | (1 << STT_GNU_IFUNC);
+  const int other_types = BCC_SYM_ALL_TYPES ^ (1 << STT_NOTYPE) ^
+                          function_types;
+
+  Payload payload = { .table = *table, .is_function = true };
+  option.use_symbol_type = function_types;
+  if (bcc_elf_foreach_sym(elf_file.c_str(), callback, &option, &payload))
+    return nullptr;
+  payload.is_function = false;
+  option.use_symbol_type = other_types;
+  if (bcc_elf_foreach_sym(elf_file.c_str(), callback, &option, &payload))
+    return nullptr;
+
+  table->finish();
+  return table;
+}
+
+std::unique_ptr<ElfSymbolTable> ElfSymbolTable::load(const std::string &path)
+{
+  int fd = open_cache_file(path);
+  if (fd < 0)
+    return nullptr;
+  SCOPE_EXIT
+  {
+    ::close(fd);
+  };
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(SymbolTableHeader))
+    return nullptr;
+  void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping == MAP_FAILED)
+    return nullptr;
+
+  // From here on, the mapping is released together with the table.
+  auto table = std::make_unique<ElfSymbolTable>();
+  table->mapping_ = mapping;
+  table->mapping_size_ = st.st_size;
+
+  const auto *header = static_cast<const SymbolTableHeader *>(mapping);
+  const size_t data_size = table->mapping_size_ - sizeof(*header);
+  if (memcmp(header->magic, SYMBOL_TABLE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->count > data_size / sizeof(Entry) ||
+      header->names_size != data_size - (header->count * sizeof(Entry)))
+    return nullptr;
+
+  table->entries_ = reinterpret_cast<const Entry *>(header + 1);
+  table->count_ = header->count;
+  table->names_ = reinterpret_cast<const char *>(table->entries_ +
+                                                 table->count_);
+  table->names_size_ = header->names_size;
+  for (size_t i = 0; i < table->count_; i++) {
+    const auto &entry = table->entries_[i];
+    if (static_cast<uint64_t>(entry.name_offset) + entry.name_size >
+        table->names_size_)
+      return nullptr;
+  }
+  return table;
+}
 
-  return symbol_table;
+bool ElfSymbolTable::save(const std::string &path) const
+{
+  std::error_code ec;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(),
+                                      ec);
+  if (ec)
+    return false;
+
+  // Write to a temporary file and rename it so that concurrent runs never see
+  // a partial table.
+  auto tmp_path = path + ".tmp" + std::to_string(getpid());
+  {
+    SymbolTableHeader header = {};
+    memcpy(header.magic, SYMBOL_TABLE_MAGIC, sizeof(header.magic));
+    header.count = count_;
+    header.names_size = names_size_;
+
+    std::ofstream out(tmp_path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(entries_),
+              count_ * sizeof(Entry));
+    out.write(names_, names_size_);
+    if (!out) {
+      std::filesystem::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+void ElfSymbolTable::add(std::string_view name,
+                         uint64_t start,
+                         uint64_t size,
+                         bool is_function)
+{
+  owned_entries_.push_back(Entry{
+      .start = start,
+      .end = start + size,
+      .name_offset = static_cast<uint32_t>(owned_names_.size()),
+      .name_size = static_cast<uint32_t>(name.size()),
+      .is_function = is_function,
+      .order = static_cast<uint32_t>(owned_entries_.size()),
+  });
+  owned_names_.append(name);
+}
+
+void ElfSymbolTable::finish()
+{
+  // Among symbols starting at the same address, lookup() returns the last
+  // one. Make that the largest one and, if there are several of the same
+  // size, the one that was added first.
+  std::ranges::sort(owned_entries_, [](const Entry &a, const Entry &b) {
+    if (a.start != b.start)
+      return a.start < b.start;
+    if (a.end != b.end)
+      return a.end < b.end;
+    return a.order > b.order;
+  });
+
+  entries_ = owned_entries_.data();
+  count_ = owned_entries_.size();
+  names_ = owned_names_.data();
+  names_size_ = owned_names_.size();
+}
+
+std::optional<elf_symbol> ElfSymbolTable::lookup(uintptr_t addr) const
+{
+  if (count_ == 0 || entries_[0].start > addr)
+    return std::nullopt;
+
+  // Find the last entry starting at or before addr. The loop always runs
+  // log2(count_) times and the comparison compiles to a conditional move, so
+  // there are no mispredicted branches on the hot path.
+  const Entry *base = entries_;
+  size_t len = count_;
+  while (len > 1) {
+    size_t half = len / 2;
+    base = base[half].start <= addr ? base + half : base;
+    len -= half;
+  }
+
+  if (addr != base->start && addr >= base->end)
+    return std::nullopt;
+  return (*this)[base - entries_];
+}
+
+elf_symbol ElfSymbolTable::operator[](size_t idx) const
+{
+  const auto &entry = entries_[idx];
+  return elf_symbol{
+    .name = std::string_view(names_ + entry.name_offset, entry.name_size),
+    .start = entry.start,
+    .end = entry.end,
+    .is_function = entry.is_function != 0,
+  };
+}
+
+ElfIndex::ElfIndex(std::shared_ptr<const ElfSymbolTable> symbols,
+                   std::vector<LoadSegment> segments,
+                   bool translate_offsets)
+    : symbols_(std::move(symbols)),
+      segments_(std::move(segments)),
+      translate_offsets_(translate_offsets)
+{
+  names_.reserve(symbols_->size());
+  for (size_t i = 0; i < symbols_->size(); i++)
+    names_.emplace((*symbols_)[i].name, i);
+}
+
+std::shared_ptr<const ElfIndex> ElfIndex::get(const std::string &elf_file)
+{
+  return get(elf_file, elf_file);
+}
+
+std::shared_ptr<const ElfIndex> ElfIndex::get(const std::string &elf_file,
+                                              const std::string &symbols_file)
+{
+  // Indexes are cached by path and, as symbol tables, only shared while
+  // someone is using them. The most recent one is kept alive as well, so
+  // that attaching many probes to the same binary one at a time builds its
+  // index once. Whether the files changed since is checked with stat(),
+  // which is much cheaper than reading their build-ids.
+  struct CachedIndex {
+    FileId elf;
+    FileId symbols;
+    std::weak_ptr<const ElfIndex> index;
+  };
+  static std::mutex mutex;
+  static std::unordered_map<std::string, CachedIndex> indexes;
+  static std::shared_ptr<const ElfIndex> last_used;
+
+  auto elf_id = get_file_id(elf_file);
+  auto symbols_id = get_file_id(symbols_file);
+  if (!elf_id || !symbols_id)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &cached = indexes[elf_file + "\n" + symbols_file];
+  if (cached.elf == *elf_id && cached.symbols == *symbols_id) {
+    if (auto index = cached.index.lock()) {
+      last_used = index;
+      return index;
+    }
+  }
+
+  auto symbols = ElfSymbolTable::get(symbols_file);
+  if (!symbols)
+    return nullptr;
+
+  // Same as bcc_resolve_symname(): only addresses in executables and shared
+  // objects need to be translated into file offsets.
+  int type = bcc_elf_get_type(elf_file.c_str());
+  bool translate_offsets = type == ET_EXEC || type == ET_DYN;
+  std::vector<LoadSegment> segments;
+  if (translate_offsets) {
+    bcc_elf_load_sectioncb callback =
+        [](uint64_t vaddr, uint64_t size, uint64_t file_offset, void *payload) {
+          static_cast<std::vector<LoadSegment> *>(payload)->push_back(
+              LoadSegment{ .vaddr = vaddr,
+                           .size = size,
+                           .file_offset = file_offset });
+          return 0;
+        };
+    if (bcc_elf_foreach_load_section(elf_file.c_str(), callback, &segments) <
+        0)
+      return nullptr;
+  }
+
+  auto index = std::make_shared<const ElfIndex>(std::move(symbols),
+                                                std::move(segments),
+                                                translate_offsets);
+  cached = CachedIndex{ .elf = *elf_id,
+                        .symbols = *symbols_id,
+                        .index = index };
+  last_used = index;
+  return index;
+}
+
+std::optional<elf_symbol> ElfIndex::find(std::string_view name) const
+{
+  // Symbols are sorted by address, so the lowest index is the lowest address.
+  auto [begin, end] = names_.equal_range(name);
+  std::optional<size_t> found;
+  for (auto it = begin; it != end; ++it) {
+    if (!found || it->second < *found)
+      found = it->second;
+  }
+  if (!found)
+    return std::nullopt;
+  return (*symbols_)[*found];
+}
+
+std::vector<elf_symbol> ElfIndex::find_all(std::string_view name) const
+{
+  std::vector<elf_symbol> symbols;
+  auto [begin, end] = names_.equal_range(name);
+  for (auto it = begin; it != end; ++it)
+    symbols.push_back((*symbols_)[it->second]);
+  return symbols;
+}
+
+std::optional<uint64_t> ElfIndex::file_offset(uint64_t addr) const
+{
+  if (!translate_offsets_)
+    return addr;
+
+  for (const auto &segment : segments_) {
+    if (addr >= segment.vaddr && addr < segment.vaddr + segment.size)
+      return addr - segment.vaddr + segment.file_offset;
+  }
+  return std::nullopt;
+}
+
+std::optional<uint64_t> ElfIndex::address(uint64_t file_offset) const
+{
+  if (!translate_offsets_)
+    return file_offset;
+
+  for (const auto &segment : segments_) {
+    if (file_offset >= segment.file_offset &&
+        file_offset < segment.file_offset + segment.size)
+      return file_offset - segment.file_offset + segment.vaddr;
+  }
+  return std::nullopt;
+}
+
+std::string get_elf_build_id(const std::string &elf_file)
+{
+  return read_elf_build_id(elf_file, nullptr);
 }
 
 bool symbol_has_module(const std::string &symbol)
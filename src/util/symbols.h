@@ -1,8 +1,14 @@
 #pragma once
 
 #include <cstdint>
-#include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace bpftrace::util {
 
@@ -50,17 +56,132 @@ inline int sym_address_cb(const char *symname,
 }
 
 struct elf_symbol {
-  std::string name;
+  std::string_view name;
   uintptr_t start;
   uintptr_t end;
+  // STT_FUNC or STT_GNU_IFUNC
+  bool is_function;
+};
+
+// All symbols of an ELF module (including its separate debug file, if there
+// is one) stored in a flat array sorted by start address. Names live in a
+// single string pool, so a table of millions of symbols takes a handful of
+// allocations rather than one or two per symbol.
+//
+// Tables are immutable once built and shared by everyone who needs the
+// symbols of the same binary: see ElfSymbolTable::get.
+class ElfSymbolTable {
+public:
+  ElfSymbolTable() = default;
+  ~ElfSymbolTable();
+
+  ElfSymbolTable(const ElfSymbolTable &) = delete;
+  ElfSymbolTable &operator=(const ElfSymbolTable &) = delete;
+
+  // Returns the symbol table for elf_file. Tables are built at most once per
+  // build-id (or per file, for binaries without one) during a run and, if a
+  // cache directory is available, persisted there so that later runs can
+  // mmap them instead of re-reading the binary.
+  static std::shared_ptr<const ElfSymbolTable> get(const std::string &elf_file);
+
+  // Reads all symbols from elf_file, without any caching.
+  static std::unique_ptr<ElfSymbolTable> build(const std::string &elf_file);
+
+  // Maps a table previously written by save(). Returns nullptr if the file
+  // does not exist or is not a valid table.
+  static std::unique_ptr<ElfSymbolTable> load(const std::string &path);
+  bool save(const std::string &path) const;
+
+  // Building a table manually: add all symbols and call finish() before the
+  // first lookup.
+  void add(std::string_view name,
+           uint64_t start,
+           uint64_t size,
+           bool is_function);
+  void finish();
+
+  // Finds the symbol containing addr. The address has to be either the start
+  // of the symbol (for symbols of length 0) or in [start, end).
+  std::optional<elf_symbol> lookup(uintptr_t addr) const;
+
+  size_t size() const
+  {
+    return count_;
+  }
+  elf_symbol operator[](size_t idx) const;
+
+private:
+  struct Entry {
+    uint64_t start;
+    uint64_t end;
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t is_function;
+    // insertion order, only used while sorting
+    uint32_t order;
+  };
+
+  // Storage of a table that was built in memory...
+  std::vector<Entry> owned_entries_;
+  std::string owned_names_;
+  // ...or of a table that was mapped from the cache.
+  void *mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+
+  const Entry *entries_ = nullptr;
+  size_t count_ = 0;
+  const char *names_ = nullptr;
+  size_t names_size_ = 0;
+};
+
+// Index of a binary for resolving uprobe attach points: its symbols, with a
+// by-name lookup, and its executable load segments, for translating addresses
+// into the file offsets that uprobes are attached to.
+class ElfIndex {
+public:
+  struct LoadSegment {
+    uint64_t vaddr;
+    uint64_t size;
+    uint64_t file_offset;
+  };
+
+  ElfIndex(std::shared_ptr<const ElfSymbolTable> symbols,
+           std::vector<LoadSegment> segments,
+           bool translate_offsets);
+
+  // Returns the index for elf_file. It is built again if the file has changed
+  // or if the previous index is no longer used.
+  static std::shared_ptr<const ElfIndex> get(const std::string &elf_file);
+  // As above, but with the symbols of symbols_file, e.g. the separate debug
+  // file of a stripped binary. Load segments are still taken from elf_file.
+  static std::shared_ptr<const ElfIndex> get(const std::string &elf_file,
+                                             const std::string &symbols_file);
+
+  std::optional<elf_symbol> lookup(uintptr_t addr) const
+  {
+    return symbols_->lookup(addr);
+  }
+  // Finds a symbol by name. If there are several symbols with the same name,
+  // the one with the lowest address is returned.
+  std::optional<elf_symbol> find(std::string_view name) const;
+  std::vector<elf_symbol> find_all(std::string_view name) const;
+
+  // Translates a virtual address into an offset in the file. Addresses in
+  // relocatable objects are already offsets and are returned unchanged.
+  std::optional<uint64_t> file_offset(uint64_t addr) const;
+  // The inverse of file_offset().
+  std::optional<uint64_t> address(uint64_t file_offset) const;
+
+private:
+  std::shared_ptr<const ElfSymbolTable> symbols_;
+  std::vector<LoadSegment> segments_;
+  bool translate_offsets_;
+  std::unordered_multimap<std::string_view, size_t> names_;
 };
 
-// Get all symbols from an ELF module together with their address ranges in
-// the form of a map sorted by start address.
-// Note: the map uses std::greater as comparator to allow resolving of an
-// address inside a range using std::map::lower_bound.
-std::map<uintptr_t, elf_symbol, std::greater<>> get_symbol_table_for_elf(
-    const std::string &elf_file);
+// Returns the GNU build-id of elf_file as a hex string, or an empty string if
+// it does not have one.
+std::string get_elf_build_id(const std::string &elf_file);
 
 bool symbol_has_cpp_mangled_signature(const std::string &sym_name);
 
@@ -1,10 +1,12 @@
 #include <algorithm>
 #include <array>
+#include <cinttypes>
 #include <climits>
 #include <filesystem>
 #include <fstream>
 #include <linux/limits.h>
 #include <map>
+#include <sstream>
 #include <unordered_set>
 
 #include "log.h"
@@ -41,6 +43,32 @@ Result<std::string> get_pid_exe(pid_t pid)
   return get_pid_exe(std::to_string(pid));
 }
 
+std::optional<uint64_t> get_pid_start_time(pid_t pid)
+{
+  std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+  std::string line;
+  if (!std::getline(stat, line))
+    return std::nullopt;
+
+  // The command name may contain spaces and parentheses, the fields are
+  // counted from its end. The start time is the 22nd field, the state after
+  // the name the 3rd.
+  auto comm_end = line.rfind(')');
+  if (comm_end == std::string::npos)
+    return std::nullopt;
+  std::istringstream fields(line.substr(comm_end + 1));
+  std::string field;
+  for (int i = 3; i <= 22; i++) {
+    if (!(fields >> field))
+      return std::nullopt;
+  }
+  try {
+    return std::stoull(field);
+  } catch (const std::exception &) {
+    return std::nullopt;
+  }
+}
+
 std::string get_proc_maps(const std::string &pid)
 {
   std::error_code ec;
@@ -59,6 +87,36 @@ std::string get_proc_maps(pid_t pid)
   return get_proc_maps(std::to_string(pid));
 }
 
+std::vector<ProcMapping> get_exec_mappings(pid_t pid)
+{
+  std::ifstream fs("/proc/" + std::to_string(pid) + "/maps");
+  std::vector<ProcMapping> mappings;
+  std::string line;
+  // Example mapping:
+  // 7fc8ee522000-7fc8ee6a7000 r-xp 00028000 00:1f 27168296 /usr/libc.so.6
+  while (std::getline(fs, line)) {
+    uint64_t start, end, offset;
+    char perms[5];
+    char buf[PATH_MAX + 1];
+    buf[0] = '\0';
+    auto res = std::sscanf(line.c_str(),
+                           "%" SCNx64 "-%" SCNx64 " %4s %" SCNx64
+                           " %*s %*u %[^\n]",
+                           &start,
+                           &end,
+                           perms,
+                           &offset,
+                           buf);
+    // skip data mappings, [vdso], anonymous memory etc...
+    if (res != 5 || perms[2] != 'x' || buf[0] != '/')
+      continue;
+    mappings.push_back(ProcMapping{
+        .start = start, .end = end, .file_offset = offset, .path = buf });
+  }
+  std::ranges::sort(mappings, {}, &ProcMapping::start);
+  return mappings;
+}
+
 std::vector<int> get_pids_for_program(const std::string &program)
 {
   std::error_code ec;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -19,9 +21,23 @@ private:
 
 Result<std::string> get_pid_exe(pid_t pid);
 Result<std::string> get_pid_exe(const std::string &pid);
+// Start time of a process in clock ticks after boot, from /proc/<pid>/stat.
+// Together with the pid, this identifies a process even if pids are reused.
+std::optional<uint64_t> get_pid_start_time(pid_t pid);
 std::string get_proc_maps(const std::string &pid);
 std::string get_proc_maps(pid_t pid);
 
+// A file-backed executable mapping of a process.
+struct ProcMapping {
+  uint64_t start;
+  uint64_t end;
+  uint64_t file_offset;
+  std::string path;
+};
+// Executable mappings from /proc/<pid>/maps, sorted by start address. Empty
+// if the process does not exist.
+std::vector<ProcMapping> get_exec_mappings(pid_t pid);
+
 std::string exec_system(const char *cmd);
 
 std::vector<std::string> get_mapped_paths_for_pid(pid_t pid);
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "util/strings.h"
+#include "util/timing.h"
+
+namespace bpftrace::util {
+
+namespace {
+
+std::atomic<bool> enabled = false;
+
+int64_t to_us(Timeline::clock::duration duration)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+} // namespace
+
+void Timeline::add(std::string_view stage,
+                   std::string name,
+                   clock::time_point start,
+                   clock::time_point end)
+{
+  int tid = static_cast<int>(syscall(SYS_gettid));
+  std::lock_guard<std::mutex> lock(mutex_);
+  spans_.push_back(Span{ .stage = std::string(stage),
+                         .name = std::move(name),
+                         .start = start,
+                         .duration = end - start,
+                         .tid = tid });
+}
+
+void Timeline::write_trace(std::ostream &out) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  clock::time_point origin;
+  if (!spans_.empty())
+    origin = std::ranges::min_element(spans_, {}, &Span::start)->start;
+  int pid = getpid();
+  out << R"({"displayTimeUnit": "ms", "traceEvents": [)";
+  for (size_t i = 0; i < spans_.size(); i++) {
+    const auto &span = spans_[i];
+    out << (i ? ",\n" : "\n") << R"({"name": ")" << json_escape(span.name)
+        << R"(", "cat": ")" << json_escape(span.stage)
+        << R"(", "ph": "X", "ts": )" << to_us(span.start - origin)
+        << R"(, "dur": )" << to_us(span.duration) << R"(, "pid": )" << pid
+        << R"(, "tid": )" << span.tid << "}";
+  }
+  out << "\n]}" << std::endl;
+}
+
+void Timeline::print_totals(std::ostream &out) const
+{
+  struct Total {
+    clock::time_point first;
+    clock::duration duration{};
+    size_t count = 0;
+  };
+  std::map<std::string, Total> totals;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &span : spans_) {
+      auto [it, inserted] = totals.try_emplace(span.stage);
+      if (inserted || span.start < it->second.first)
+        it->second.first = span.start;
+      it->second.duration += span.duration;
+      it->second.count++;
+    }
+  }
+
+  std::vector<std::pair<std::string, Total>> ordered(totals.begin(),
+                                                     totals.end());
+  std::ranges::sort(ordered, {}, [](const auto &entry) {
+    return entry.second.first;
+  });
+  // Spans of different stages are often nested, e.g. clang parsing within
+  // its pass, so their totals overlap.
+  for (const auto &[stage, total] : ordered) {
+    auto ms = std::chrono::duration<double, std::milli>(total.duration);
+    out << std::left << std::setw(20) << stage << std::right << std::fixed
+        << std::setprecision(3) << std::setw(12) << ms.count() << " ms"
+        << std::setw(8) << total.count << std::endl;
+  }
+}
+
+Timeline &timeline()
+{
+  static Timeline timeline;
+  return timeline;
+}
+
+void enable_timing()
+{
+  enabled = true;
+}
+
+bool timing_enabled()
+{
+  return enabled;
+}
+
+TimingSpan::TimingSpan(std::string_view stage, std::string name)
+    : enabled_(timing_enabled())
+{
+  if (!enabled_)
+    return;
+  stage_ = stage;
+  name_ = std::move(name);
+  start_ = Timeline::clock::now();
+}
+
+TimingSpan::~TimingSpan()
+{
+  if (enabled_)
+    timeline().add(stage_, std::move(name_), start_, Timeline::clock::now());
+}
+
+} // namespace bpftrace::util
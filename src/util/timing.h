@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bpftrace::util {
+
+// Records how long the stages of bpftrace's startup take (-d timing), as
+// spans that can be exported as a Chrome trace and summed up per stage.
+class Timeline {
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct Span {
+    std::string stage;
+    std::string name;
+    clock::time_point start;
+    clock::duration duration;
+    int tid;
+  };
+
+  void add(std::string_view stage,
+           std::string name,
+           clock::time_point start,
+           clock::time_point end);
+
+  // Writes all spans in the Chrome trace event format, which trace viewers
+  // like Perfetto and chrome://tracing load.
+  void write_trace(std::ostream &out) const;
+  // Writes the total time and the number of spans of every stage, in the
+  // order in which the stages started.
+  void print_totals(std::ostream &out) const;
+
+  bool empty() const
+  {
+    return spans_.empty();
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::vector<Span> spans_;
+};
+
+// The timeline of this process, which records spans only once enabled.
+Timeline &timeline();
+void enable_timing();
+bool timing_enabled();
+
+// Adds a span to the timeline from construction to destruction, if timing is
+// enabled.
+class TimingSpan {
+public:
+  TimingSpan(std::string_view stage, std::string name);
+  ~TimingSpan();
+
+  TimingSpan(const TimingSpan &) = delete;
+  TimingSpan &operator=(const TimingSpan &) = delete;
+
+private:
+  bool enabled_;
+  std::string_view stage_;
+  std::string name_;
+  Timeline::clock::time_point start_;
+};
+
+} // namespace bpftrace::util
@@ -125,13 +125,13 @@ std::string handler_proxy(AsyncActionTest &test,
                 "Only support syscall, cat, and printf");
   if (id == AsyncAction::syscall) {
     test.bpftrace->resources.system_args.emplace_back(fmt, fields);
-    test.handlers.syscall(id, arg_data.data());
+    test.handlers.syscall(id, arg_data.data(), arg_data.size());
   } else if (id == AsyncAction::cat) {
     test.bpftrace->resources.cat_args.emplace_back(fmt, fields);
-    test.handlers.cat(id, arg_data.data());
+    test.handlers.cat(id, arg_data.data(), arg_data.size());
   } else if (id == AsyncAction::printf) {
     test.bpftrace->resources.printf_args.emplace_back(fmt, fields);
-    test.handlers.printf(id, arg_data.data());
+    test.handlers.printf(id, arg_data.data(), arg_data.size());
   }
 
   auto s = test.out.str();
@@ -152,16 +152,21 @@ TEST_F(AsyncActionTest, join)
   join->action_id = static_cast<uint64_t>(AsyncAction::join);
   join->join_id = 0;
 
-  const char *arg1 = "/bin/ls";
-  const char *arg2 = "-la";
-  const char *arg3 = "/tmp";
-
-  memcpy(join->content, arg1, strlen(arg1) + 1);
-  memcpy(join->content + bpftrace->join_argsize_, arg2, strlen(arg2) + 1);
-  memcpy(join->content + (2 * bpftrace->join_argsize_), arg3, strlen(arg3) + 1);
+  // Arguments are packed back to back, the zeroed buffer terminates them
+  size_t offset = 0;
+  for (const char *arg : { "/bin/ls", "-la", "/tmp" }) {
+    memcpy(join->content + offset, arg, strlen(arg) + 1);
+    offset += strlen(arg) + 1;
+  }
 
-  handlers.join(join);
+  handlers.join(join, sizeof(AsyncEvent::Join) + offset + 1);
   EXPECT_EQ("/bin/ls,-la,/tmp\n", out.str());
+
+  // The terminating NUL is cut off
+  out.str("");
+  EXPECT_THROW(handlers.join(join, sizeof(AsyncEvent::Join) + offset),
+               util::FatalUserException);
+  EXPECT_EQ("", out.str());
 }
 
 TEST_F(AsyncActionTest, time)
@@ -387,6 +392,60 @@ TEST_F(AsyncActionTest, printf)
       << "printf_handler should format multiple arguments correctly";
 }
 
+TEST_F(AsyncActionTest, printf_packed)
+{
+  // Large strings and buffers follow each other after the fixed arguments
+  std::string format = "%s %d %r %s";
+  std::vector<Field> fields = {
+    Field{ .name = "",
+           .type = CreateString(1024),
+           .offset = 16,
+           .bitfield = std::nullopt,
+           .is_packed = true },
+    Field{ .name = "",
+           .type = CreateInt64(),
+           .offset = 8,
+           .bitfield = std::nullopt },
+    Field{ .name = "",
+           .type = CreateBuffer(64),
+           .offset = 16,
+           .bitfield = std::nullopt,
+           .is_packed = true },
+    Field{ .name = "",
+           .type = CreateString(64),
+           .offset = 16,
+           .bitfield = std::nullopt,
+           .is_packed = true },
+  };
+
+  std::vector<uint8_t> data(16);
+  auto printf_id = static_cast<uint64_t>(AsyncAction::printf);
+  memcpy(data.data(), &printf_id, sizeof(printf_id));
+  int64_t value = 42;
+  memcpy(data.data() + 8, &value, sizeof(value));
+  for (char c : std::string("/etc/passwd"))
+    data.push_back(c);
+  data.push_back(0);
+  uint32_t length = 2;
+  data.insert(data.end(),
+              reinterpret_cast<uint8_t *>(&length),
+              reinterpret_cast<uint8_t *>(&length) + sizeof(length));
+  data.push_back('h');
+  data.push_back('i');
+  data.push_back(0);
+
+  bpftrace->resources.printf_args.emplace_back(FormatString(format), fields);
+  handlers.printf(AsyncAction::printf, data.data(), data.size());
+  EXPECT_EQ("/etc/passwd 42 hi ", out.str());
+
+  // Every packed argument must end within the event
+  out.str("");
+  for (size_t size : { data.size() - 1, data.size() - 3, size_t{ 20 } })
+    EXPECT_THROW(handlers.printf(AsyncAction::printf, data.data(), size),
+                 util::FatalUserException);
+  EXPECT_EQ("", out.str());
+}
+
 TEST_F(AsyncActionTest, print_non_map)
 {
   struct TestCase {
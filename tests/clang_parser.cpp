@@ -8,6 +8,7 @@
 #include "driver.h"
 #include "mocks.h"
 #include "struct.h"
+#include "util/temp.h"
 #include "gtest/gtest.h"
 
 namespace bpftrace::test::clang_parser {
@@ -605,6 +606,36 @@ TEST(clang_parser, builtin_headers)
   EXPECT_EQ(foo->GetField("z").offset, 16);
 }
 
+TEST(clang_parser, cache)
+{
+  auto dir = util::TempDir::create();
+  ASSERT_TRUE(bool(dir));
+  ::setenv("BPFTRACE_CACHE_DIR", dir->path().c_str(), 1);
+
+  const std::string input = "#define FOO 42\nstruct Foo { int x; long y; }";
+  {
+    BPFtrace bpftrace;
+    parse(input, bpftrace);
+  }
+  auto cache_dir = dir->path() / "clang";
+  ASSERT_TRUE(std::filesystem::is_directory(cache_dir));
+  EXPECT_FALSE(std::filesystem::is_empty(cache_dir));
+
+  // The second parse is served from the cache and must yield the same
+  // definitions.
+  BPFtrace bpftrace;
+  auto c_defs = parse(input, bpftrace);
+  ::setenv("BPFTRACE_CACHE_DIR", "", 1);
+
+  ASSERT_EQ(c_defs.macros.count("FOO"), 1U);
+  EXPECT_EQ(c_defs.macros["FOO"], "42");
+  ASSERT_TRUE(bpftrace.structs.Has("struct Foo"));
+  auto foo = bpftrace.structs.Lookup("struct Foo").lock();
+  EXPECT_EQ(foo->size, 16);
+  ASSERT_TRUE(foo->HasField("y"));
+  EXPECT_EQ(foo->GetField("y").offset, 8);
+}
+
 TEST(clang_parser, macro_preprocessor)
 {
   BPFtrace bpftrace;
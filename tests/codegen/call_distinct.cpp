@@ -0,0 +1,10 @@
+#include "common.h"
+
+namespace bpftrace::test::codegen {
+
+TEST(codegen, call_distinct)
+{
+  test("kprobe:f { @x = distinct(pid) }", NAME);
+}
+
+} // namespace bpftrace::test::codegen
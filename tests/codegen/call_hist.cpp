@@ -9,4 +9,13 @@ TEST(codegen, call_hist)
        NAME);
 }
 
+TEST(codegen, call_hist_global_func)
+{
+  auto bpftrace = get_mock_bpftrace();
+  auto feature = std::make_unique<MockBPFfeature>();
+  feature->set_has_btf_func_global(true);
+  bpftrace->feature_ = std::move(feature);
+  test(*bpftrace, "kprobe:f { @x = hist(pid) }", NAME);
+}
+
 } // namespace bpftrace::test::codegen
@@ -0,0 +1,10 @@
+#include "common.h"
+
+namespace bpftrace::test::codegen {
+
+TEST(codegen, call_quantiles)
+{
+  test("kprobe:f { @x = quantiles(pid) }", NAME);
+}
+
+} // namespace bpftrace::test::codegen
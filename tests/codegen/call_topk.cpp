@@ -0,0 +1,10 @@
+#include "common.h"
+
+namespace bpftrace::test::codegen {
+
+TEST(codegen, call_topk)
+{
+  test("kprobe:f { @x[1] = topk(10) }", NAME);
+}
+
+} // namespace bpftrace::test::codegen
@@ -0,0 +1,17 @@
+#include "common.h"
+
+namespace bpftrace::test::codegen {
+
+TEST(codegen, cgroup_filter)
+{
+  auto bpftrace = get_mock_bpftrace();
+  bpftrace->cgroup_filter_ = CgroupFilter{
+    .path = "/sys/fs/cgroup/test",
+    .id = 1234,
+    .level = 2,
+  };
+
+  test(*bpftrace, "kprobe:f { 1; }", NAME);
+}
+
+} // namespace bpftrace::test::codegen
@@ -0,0 +1,195 @@
+; ModuleID = 'bpftrace'
+source_filename = "bpftrace"
+target datalayout = "e-m:e-p:64:64-i64:64-i128:128-n32:64-S128"
+target triple = "bpf"
+
+%"struct map_t" = type { ptr, ptr, ptr, ptr }
+%"struct map_t.0" = type { ptr, ptr }
+
+@LICENSE = global [4 x i8] c"GPL\00", section "license", !dbg !0
+@AT_x = dso_local global %"struct map_t" zeroinitializer, section ".maps", !dbg !7
+@ringbuf = dso_local global %"struct map_t.0" zeroinitializer, section ".maps", !dbg !30
+@__bt__event_loss_counter = dso_local externally_initialized global [1 x [1 x i64]] zeroinitializer, section ".data.event_loss_counter", !dbg !44
+@__bt__max_cpu_id = dso_local externally_initialized constant i64 0, section ".rodata", !dbg !48
+@__bt__write_map_val_buf = dso_local externally_initialized global [1 x [1 x [1024 x i8]]] zeroinitializer, section ".data.write_map_val_buf", !dbg !50
+
+; Function Attrs: nounwind
+declare i64 @llvm.bpf.pseudo(i64 %0, i64 %1) #0
+
+; Function Attrs: nounwind
+define i64 @kprobe_f_1(ptr %0) #0 section "s_kprobe_f_1" !dbg !58 {
+entry:
+  %distinct_val = alloca i64, align 8
+  %"@x_key" = alloca i64, align 8
+  call void @llvm.lifetime.start.p0(i64 -1, ptr %"@x_key")
+  store i64 0, ptr %"@x_key", align 8
+  %get_pid_tgid = call i64 inttoptr (i64 14 to ptr)() #2
+  %1 = lshr i64 %get_pid_tgid, 32
+  %pid = trunc i64 %1 to i32
+  call void @llvm.lifetime.start.p0(i64 -1, ptr %distinct_val)
+  %2 = zext i32 %pid to i64
+  store i64 %2, ptr %distinct_val, align 8
+  %3 = getelementptr i8, ptr %distinct_val, i64 0
+  %4 = load i64, ptr %3, align 1
+  %5 = mul i64 %4, -4132994306676758123
+  %6 = lshr i64 %5, 47
+  %7 = xor i64 %5, %6
+  %8 = mul i64 %7, -4132994306676758123
+  %9 = xor i64 3829533694005038248, %8
+  %10 = mul i64 %9, -4132994306676758123
+  %11 = lshr i64 %10, 47
+  %12 = xor i64 %10, %11
+  %13 = mul i64 %12, -4132994306676758123
+  %14 = lshr i64 %13, 47
+  %key_hash = xor i64 %13, %14
+  call void @llvm.lifetime.end.p0(i64 -1, ptr %distinct_val)
+  %lookup_elem = call ptr inttoptr (i64 1 to ptr)(ptr @AT_x, ptr %"@x_key")
+  %lookup_cond = icmp ne ptr %lookup_elem, null
+  br i1 %lookup_cond, label %lookup_merge, label %lookup_failure
+
+lookup_failure:                                   ; preds = %entry
+  %get_cpu_id = call i64 inttoptr (i64 8 to ptr)() #2
+  %15 = load i64, ptr @__bt__max_cpu_id, align 8
+  %cpu.id.bounded = and i64 %get_cpu_id, %15
+  %16 = getelementptr [1 x [1 x [1024 x i8]]], ptr @__bt__write_map_val_buf, i64 0, i64 %cpu.id.bounded, i64 0, i64 0
+  %probe_read_kernel = call i64 inttoptr (i64 113 to ptr)(ptr %16, i32 1024, ptr null)
+  %update_elem = call i64 inttoptr (i64 2 to ptr)(ptr @AT_x, ptr %"@x_key", ptr %16, i64 0)
+  %lookup_elem1 = call ptr inttoptr (i64 1 to ptr)(ptr @AT_x, ptr %"@x_key")
+  br label %lookup_merge
+
+lookup_merge:                                     ; preds = %lookup_failure, %entry
+  %registers = phi ptr [ %lookup_elem, %entry ], [ %lookup_elem1, %lookup_failure ]
+  %registers_cond = icmp ne ptr %registers, null
+  br i1 %registers_cond, label %distinct_update, label %distinct_done
+
+distinct_update:                                  ; preds = %lookup_merge
+  %17 = lshr i64 %key_hash, 54
+  %18 = shl i64 %key_hash, 10
+  %19 = lshr i64 %18, 32
+  %20 = icmp eq i64 %19, 0
+  %21 = select i1 %20, i64 32, i64 0
+  %22 = shl i64 %18, 32
+  %23 = select i1 %20, i64 %22, i64 %18
+  %24 = lshr i64 %23, 48
+  %25 = icmp eq i64 %24, 0
+  %26 = add i64 %21, 16
+  %27 = select i1 %25, i64 %26, i64 %21
+  %28 = shl i64 %23, 16
+  %29 = select i1 %25, i64 %28, i64 %23
+  %30 = lshr i64 %29, 56
+  %31 = icmp eq i64 %30, 0
+  %32 = add i64 %27, 8
+  %33 = select i1 %31, i64 %32, i64 %27
+  %34 = shl i64 %29, 8
+  %35 = select i1 %31, i64 %34, i64 %29
+  %36 = lshr i64 %35, 60
+  %37 = icmp eq i64 %36, 0
+  %38 = add i64 %33, 4
+  %39 = select i1 %37, i64 %38, i64 %33
+  %40 = shl i64 %35, 4
+  %41 = select i1 %37, i64 %40, i64 %35
+  %42 = lshr i64 %41, 62
+  %43 = icmp eq i64 %42, 0
+  %44 = add i64 %39, 2
+  %45 = select i1 %43, i64 %44, i64 %39
+  %46 = shl i64 %41, 2
+  %47 = select i1 %43, i64 %46, i64 %41
+  %48 = lshr i64 %47, 63
+  %49 = icmp eq i64 %48, 0
+  %50 = add i64 %45, 1
+  %51 = select i1 %49, i64 %50, i64 %45
+  %52 = shl i64 %47, 1
+  %53 = select i1 %49, i64 %52, i64 %47
+  %54 = add i64 %51, 1
+  %55 = icmp ult i64 %54, 55
+  %56 = select i1 %55, i64 %54, i64 55
+  %57 = trunc i64 %56 to i8
+  %58 = getelementptr i8, ptr %registers, i64 %17
+  %59 = load i8, ptr %58, align 1
+  %60 = icmp ugt i8 %57, %59
+  %61 = select i1 %60, i8 %57, i8 %59
+  store i8 %61, ptr %58, align 1
+  br label %distinct_done
+
+distinct_done:                                    ; preds = %distinct_update, %lookup_merge
+  call void @llvm.lifetime.end.p0(i64 -1, ptr %"@x_key")
+  ret i64 0
+}
+
+; Function Attrs: nocallback nofree nosync nounwind willreturn memory(argmem: readwrite)
+declare void @llvm.lifetime.start.p0(i64 immarg %0, ptr nocapture %1) #1
+
+; Function Attrs: nocallback nofree nosync nounwind willreturn memory(argmem: readwrite)
+declare void @llvm.lifetime.end.p0(i64 immarg %0, ptr nocapture %1) #1
+
+attributes #0 = { nounwind }
+attributes #1 = { nocallback nofree nosync nounwind willreturn memory(argmem: readwrite) }
+attributes #2 = { memory(none) }
+
+!llvm.dbg.cu = !{!54}
+!llvm.module.flags = !{!56, !57}
+
+!0 = !DIGlobalVariableExpression(var: !1, expr: !DIExpression())
+!1 = distinct !DIGlobalVariable(name: "LICENSE", linkageName: "global", scope: !2, file: !2, type: !3, isLocal: false, isDefinition: true)
+!2 = !DIFile(filename: "bpftrace.bpf.o", directory: ".")
+!3 = !DICompositeType(tag: DW_TAG_array_type, baseType: !4, size: 32, elements: !5)
+!4 = !DIBasicType(name: "int8", size: 8, encoding: DW_ATE_signed)
+!5 = !{!6}
+!6 = !DISubrange(count: 4, lowerBound: 0)
+!7 = !DIGlobalVariableExpression(var: !8, expr: !DIExpression())
+!8 = distinct !DIGlobalVariable(name: "AT_x", linkageName: "global", scope: !2, file: !2, type: !9, isLocal: false, isDefinition: true)
+!9 = !DICompositeType(tag: DW_TAG_structure_type, scope: !2, file: !2, size: 256, elements: !10)
+!10 = !{!11, !17, !22, !25}
+!11 = !DIDerivedType(tag: DW_TAG_member, name: "type", scope: !2, file: !2, baseType: !12, size: 64)
+!12 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !13, size: 64)
+!13 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 160, elements: !15)
+!14 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!15 = !{!16}
+!16 = !DISubrange(count: 5, lowerBound: 0)
+!17 = !DIDerivedType(tag: DW_TAG_member, name: "max_entries", scope: !2, file: !2, baseType: !18, size: 64, offset: 64)
+!18 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !19, size: 64)
+!19 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 32, elements: !20)
+!20 = !{!21}
+!21 = !DISubrange(count: 1, lowerBound: 0)
+!22 = !DIDerivedType(tag: DW_TAG_member, name: "key", scope: !2, file: !2, baseType: !23, size: 64, offset: 128)
+!23 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !24, size: 64)
+!24 = !DIBasicType(name: "int64", size: 64, encoding: DW_ATE_signed)
+!25 = !DIDerivedType(tag: DW_TAG_member, name: "value", scope: !2, file: !2, baseType: !26, size: 64, offset: 192)
+!26 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !27, size: 64)
+!27 = !DICompositeType(tag: DW_TAG_array_type, baseType: !4, size: 8192, elements: !28)
+!28 = !{!29}
+!29 = !DISubrange(count: 1024, lowerBound: 0)
+!30 = !DIGlobalVariableExpression(var: !31, expr: !DIExpression())
+!31 = distinct !DIGlobalVariable(name: "ringbuf", linkageName: "global", scope: !2, file: !2, type: !32, isLocal: false, isDefinition: true)
+!32 = !DICompositeType(tag: DW_TAG_structure_type, scope: !2, file: !2, size: 128, elements: !33)
+!33 = !{!34, !39}
+!34 = !DIDerivedType(tag: DW_TAG_member, name: "type", scope: !2, file: !2, baseType: !35, size: 64)
+!35 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !36, size: 64)
+!36 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 864, elements: !37)
+!37 = !{!38}
+!38 = !DISubrange(count: 27, lowerBound: 0)
+!39 = !DIDerivedType(tag: DW_TAG_member, name: "max_entries", scope: !2, file: !2, baseType: !40, size: 64, offset: 64)
+!40 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !41, size: 64)
+!41 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 8388608, elements: !42)
+!42 = !{!43}
+!43 = !DISubrange(count: 262144, lowerBound: 0)
+!44 = !DIGlobalVariableExpression(var: !45, expr: !DIExpression())
+!45 = distinct !DIGlobalVariable(name: "__bt__event_loss_counter", linkageName: "global", scope: !2, file: !2, type: !46, isLocal: false, isDefinition: true)
+!46 = !DICompositeType(tag: DW_TAG_array_type, baseType: !47, size: 64, elements: !20)
+!47 = !DICompositeType(tag: DW_TAG_array_type, baseType: !24, size: 64, elements: !20)
+!48 = !DIGlobalVariableExpression(var: !49, expr: !DIExpression())
+!49 = distinct !DIGlobalVariable(name: "__bt__max_cpu_id", linkageName: "global", scope: !2, file: !2, type: !24, isLocal: false, isDefinition: true)
+!50 = !DIGlobalVariableExpression(var: !51, expr: !DIExpression())
+!51 = distinct !DIGlobalVariable(name: "__bt__write_map_val_buf", linkageName: "global", scope: !2, file: !2, type: !52, isLocal: false, isDefinition: true)
+!52 = !DICompositeType(tag: DW_TAG_array_type, baseType: !53, size: 8192, elements: !20)
+!53 = !DICompositeType(tag: DW_TAG_array_type, baseType: !27, size: 8192, elements: !20)
+!54 = distinct !DICompileUnit(language: DW_LANG_C, file: !2, producer: "bpftrace", isOptimized: false, runtimeVersion: 0, emissionKind: LineTablesOnly, globals: !55)
+!55 = !{!0, !7, !30, !44, !48, !50}
+!56 = !{i32 2, !"Debug Info Version", i32 3}
+!57 = !{i32 7, !"uwtable", i32 0}
+!58 = distinct !DISubprogram(name: "kprobe_f_1", linkageName: "kprobe_f_1", scope: !2, file: !2, type: !59, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !54, retainedNodes: !62)
+!59 = !DISubroutineType(types: !60)
+!60 = !{!24, !61}
+!61 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !4, size: 64)
+!62 = !{!63}
+!63 = !DILocalVariable(name: "ctx", arg: 1, scope: !58, file: !2, type: !61)
@@ -63,96 +63,196 @@ lookup_join_merge:                                ; preds = %entry
   %9 = getelementptr i8, ptr %8, i64 0
   %10 = load i64, ptr %join_r0, align 8
   %probe_read_kernel_str = call i64 inttoptr (i64 115 to ptr)(ptr %9, i32 1024, i64 %10)
+  %join.last = icmp slt i64 %probe_read_kernel_str, 2
+  br i1 %join.last, label %join_done, label %join_next
+
+join_next:                                        ; preds = %lookup_join_merge
+  %join.end = add i64 0, %probe_read_kernel_str
   %11 = add i64 %5, 8
   %probe_read_kernel2 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %11)
-  %12 = getelementptr i8, ptr %8, i64 1024
+  %12 = getelementptr i8, ptr %8, i64 %join.end
   %13 = load i64, ptr %join_r0, align 8
   %probe_read_kernel_str3 = call i64 inttoptr (i64 115 to ptr)(ptr %12, i32 1024, i64 %13)
-  %14 = add i64 %11, 8
-  %probe_read_kernel4 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %14)
-  %15 = getelementptr i8, ptr %8, i64 2048
-  %16 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str5 = call i64 inttoptr (i64 115 to ptr)(ptr %15, i32 1024, i64 %16)
-  %17 = add i64 %14, 8
-  %probe_read_kernel6 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %17)
-  %18 = getelementptr i8, ptr %8, i64 3072
-  %19 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str7 = call i64 inttoptr (i64 115 to ptr)(ptr %18, i32 1024, i64 %19)
-  %20 = add i64 %17, 8
-  %probe_read_kernel8 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %20)
-  %21 = getelementptr i8, ptr %8, i64 4096
-  %22 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str9 = call i64 inttoptr (i64 115 to ptr)(ptr %21, i32 1024, i64 %22)
-  %23 = add i64 %20, 8
-  %probe_read_kernel10 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %23)
-  %24 = getelementptr i8, ptr %8, i64 5120
+  %14 = add i64 %join.end, 1
+  %join.last5 = icmp slt i64 %probe_read_kernel_str3, 2
+  br i1 %join.last5, label %join_done, label %join_next4
+
+join_next4:                                       ; preds = %join_next
+  %join.end6 = add i64 %join.end, %probe_read_kernel_str3
+  %15 = add i64 %11, 8
+  %probe_read_kernel7 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %15)
+  %16 = getelementptr i8, ptr %8, i64 %join.end6
+  %17 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str8 = call i64 inttoptr (i64 115 to ptr)(ptr %16, i32 1024, i64 %17)
+  %18 = add i64 %join.end6, 1
+  %join.last10 = icmp slt i64 %probe_read_kernel_str8, 2
+  br i1 %join.last10, label %join_done, label %join_next9
+
+join_next9:                                       ; preds = %join_next4
+  %join.end11 = add i64 %join.end6, %probe_read_kernel_str8
+  %19 = add i64 %15, 8
+  %probe_read_kernel12 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %19)
+  %20 = getelementptr i8, ptr %8, i64 %join.end11
+  %21 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str13 = call i64 inttoptr (i64 115 to ptr)(ptr %20, i32 1024, i64 %21)
+  %22 = add i64 %join.end11, 1
+  %join.last15 = icmp slt i64 %probe_read_kernel_str13, 2
+  br i1 %join.last15, label %join_done, label %join_next14
+
+join_next14:                                      ; preds = %join_next9
+  %join.end16 = add i64 %join.end11, %probe_read_kernel_str13
+  %23 = add i64 %19, 8
+  %probe_read_kernel17 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %23)
+  %24 = getelementptr i8, ptr %8, i64 %join.end16
   %25 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str11 = call i64 inttoptr (i64 115 to ptr)(ptr %24, i32 1024, i64 %25)
-  %26 = add i64 %23, 8
-  %probe_read_kernel12 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %26)
-  %27 = getelementptr i8, ptr %8, i64 6144
-  %28 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str13 = call i64 inttoptr (i64 115 to ptr)(ptr %27, i32 1024, i64 %28)
-  %29 = add i64 %26, 8
-  %probe_read_kernel14 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %29)
-  %30 = getelementptr i8, ptr %8, i64 7168
-  %31 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str15 = call i64 inttoptr (i64 115 to ptr)(ptr %30, i32 1024, i64 %31)
-  %32 = add i64 %29, 8
-  %probe_read_kernel16 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %32)
-  %33 = getelementptr i8, ptr %8, i64 8192
-  %34 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str17 = call i64 inttoptr (i64 115 to ptr)(ptr %33, i32 1024, i64 %34)
-  %35 = add i64 %32, 8
-  %probe_read_kernel18 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %35)
-  %36 = getelementptr i8, ptr %8, i64 9216
+  %probe_read_kernel_str18 = call i64 inttoptr (i64 115 to ptr)(ptr %24, i32 1024, i64 %25)
+  %26 = add i64 %join.end16, 1
+  %join.last20 = icmp slt i64 %probe_read_kernel_str18, 2
+  br i1 %join.last20, label %join_done, label %join_next19
+
+join_next19:                                      ; preds = %join_next14
+  %join.end21 = add i64 %join.end16, %probe_read_kernel_str18
+  %27 = add i64 %23, 8
+  %probe_read_kernel22 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %27)
+  %28 = getelementptr i8, ptr %8, i64 %join.end21
+  %29 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str23 = call i64 inttoptr (i64 115 to ptr)(ptr %28, i32 1024, i64 %29)
+  %30 = add i64 %join.end21, 1
+  %join.last25 = icmp slt i64 %probe_read_kernel_str23, 2
+  br i1 %join.last25, label %join_done, label %join_next24
+
+join_next24:                                      ; preds = %join_next19
+  %join.end26 = add i64 %join.end21, %probe_read_kernel_str23
+  %31 = add i64 %27, 8
+  %probe_read_kernel27 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %31)
+  %32 = getelementptr i8, ptr %8, i64 %join.end26
+  %33 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str28 = call i64 inttoptr (i64 115 to ptr)(ptr %32, i32 1024, i64 %33)
+  %34 = add i64 %join.end26, 1
+  %join.last30 = icmp slt i64 %probe_read_kernel_str28, 2
+  br i1 %join.last30, label %join_done, label %join_next29
+
+join_next29:                                      ; preds = %join_next24
+  %join.end31 = add i64 %join.end26, %probe_read_kernel_str28
+  %35 = add i64 %31, 8
+  %probe_read_kernel32 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %35)
+  %36 = getelementptr i8, ptr %8, i64 %join.end31
   %37 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str19 = call i64 inttoptr (i64 115 to ptr)(ptr %36, i32 1024, i64 %37)
-  %38 = add i64 %35, 8
-  %probe_read_kernel20 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %38)
-  %39 = getelementptr i8, ptr %8, i64 10240
-  %40 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str21 = call i64 inttoptr (i64 115 to ptr)(ptr %39, i32 1024, i64 %40)
-  %41 = add i64 %38, 8
-  %probe_read_kernel22 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %41)
-  %42 = getelementptr i8, ptr %8, i64 11264
-  %43 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str23 = call i64 inttoptr (i64 115 to ptr)(ptr %42, i32 1024, i64 %43)
-  %44 = add i64 %41, 8
-  %probe_read_kernel24 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %44)
-  %45 = getelementptr i8, ptr %8, i64 12288
-  %46 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str25 = call i64 inttoptr (i64 115 to ptr)(ptr %45, i32 1024, i64 %46)
-  %47 = add i64 %44, 8
-  %probe_read_kernel26 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %47)
-  %48 = getelementptr i8, ptr %8, i64 13312
+  %probe_read_kernel_str33 = call i64 inttoptr (i64 115 to ptr)(ptr %36, i32 1024, i64 %37)
+  %38 = add i64 %join.end31, 1
+  %join.last35 = icmp slt i64 %probe_read_kernel_str33, 2
+  br i1 %join.last35, label %join_done, label %join_next34
+
+join_next34:                                      ; preds = %join_next29
+  %join.end36 = add i64 %join.end31, %probe_read_kernel_str33
+  %39 = add i64 %35, 8
+  %probe_read_kernel37 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %39)
+  %40 = getelementptr i8, ptr %8, i64 %join.end36
+  %41 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str38 = call i64 inttoptr (i64 115 to ptr)(ptr %40, i32 1024, i64 %41)
+  %42 = add i64 %join.end36, 1
+  %join.last40 = icmp slt i64 %probe_read_kernel_str38, 2
+  br i1 %join.last40, label %join_done, label %join_next39
+
+join_next39:                                      ; preds = %join_next34
+  %join.end41 = add i64 %join.end36, %probe_read_kernel_str38
+  %43 = add i64 %39, 8
+  %probe_read_kernel42 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %43)
+  %44 = getelementptr i8, ptr %8, i64 %join.end41
+  %45 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str43 = call i64 inttoptr (i64 115 to ptr)(ptr %44, i32 1024, i64 %45)
+  %46 = add i64 %join.end41, 1
+  %join.last45 = icmp slt i64 %probe_read_kernel_str43, 2
+  br i1 %join.last45, label %join_done, label %join_next44
+
+join_next44:                                      ; preds = %join_next39
+  %join.end46 = add i64 %join.end41, %probe_read_kernel_str43
+  %47 = add i64 %43, 8
+  %probe_read_kernel47 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %47)
+  %48 = getelementptr i8, ptr %8, i64 %join.end46
   %49 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str27 = call i64 inttoptr (i64 115 to ptr)(ptr %48, i32 1024, i64 %49)
-  %50 = add i64 %47, 8
-  %probe_read_kernel28 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %50)
-  %51 = getelementptr i8, ptr %8, i64 14336
-  %52 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str29 = call i64 inttoptr (i64 115 to ptr)(ptr %51, i32 1024, i64 %52)
-  %53 = add i64 %50, 8
-  %probe_read_kernel30 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %53)
-  %54 = getelementptr i8, ptr %8, i64 15360
-  %55 = load i64, ptr %join_r0, align 8
-  %probe_read_kernel_str31 = call i64 inttoptr (i64 115 to ptr)(ptr %54, i32 1024, i64 %55)
-  %ringbuf_output = call i64 inttoptr (i64 130 to ptr)(ptr @ringbuf, ptr %lookup_join_map, i64 16400, i64 0)
+  %probe_read_kernel_str48 = call i64 inttoptr (i64 115 to ptr)(ptr %48, i32 1024, i64 %49)
+  %50 = add i64 %join.end46, 1
+  %join.last50 = icmp slt i64 %probe_read_kernel_str48, 2
+  br i1 %join.last50, label %join_done, label %join_next49
+
+join_next49:                                      ; preds = %join_next44
+  %join.end51 = add i64 %join.end46, %probe_read_kernel_str48
+  %51 = add i64 %47, 8
+  %probe_read_kernel52 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %51)
+  %52 = getelementptr i8, ptr %8, i64 %join.end51
+  %53 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str53 = call i64 inttoptr (i64 115 to ptr)(ptr %52, i32 1024, i64 %53)
+  %54 = add i64 %join.end51, 1
+  %join.last55 = icmp slt i64 %probe_read_kernel_str53, 2
+  br i1 %join.last55, label %join_done, label %join_next54
+
+join_next54:                                      ; preds = %join_next49
+  %join.end56 = add i64 %join.end51, %probe_read_kernel_str53
+  %55 = add i64 %51, 8
+  %probe_read_kernel57 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %55)
+  %56 = getelementptr i8, ptr %8, i64 %join.end56
+  %57 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str58 = call i64 inttoptr (i64 115 to ptr)(ptr %56, i32 1024, i64 %57)
+  %58 = add i64 %join.end56, 1
+  %join.last60 = icmp slt i64 %probe_read_kernel_str58, 2
+  br i1 %join.last60, label %join_done, label %join_next59
+
+join_next59:                                      ; preds = %join_next54
+  %join.end61 = add i64 %join.end56, %probe_read_kernel_str58
+  %59 = add i64 %55, 8
+  %probe_read_kernel62 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %59)
+  %60 = getelementptr i8, ptr %8, i64 %join.end61
+  %61 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str63 = call i64 inttoptr (i64 115 to ptr)(ptr %60, i32 1024, i64 %61)
+  %62 = add i64 %join.end61, 1
+  %join.last65 = icmp slt i64 %probe_read_kernel_str63, 2
+  br i1 %join.last65, label %join_done, label %join_next64
+
+join_next64:                                      ; preds = %join_next59
+  %join.end66 = add i64 %join.end61, %probe_read_kernel_str63
+  %63 = add i64 %59, 8
+  %probe_read_kernel67 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %63)
+  %64 = getelementptr i8, ptr %8, i64 %join.end66
+  %65 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str68 = call i64 inttoptr (i64 115 to ptr)(ptr %64, i32 1024, i64 %65)
+  %66 = add i64 %join.end66, 1
+  %join.last70 = icmp slt i64 %probe_read_kernel_str68, 2
+  br i1 %join.last70, label %join_done, label %join_next69
+
+join_next69:                                      ; preds = %join_next64
+  %join.end71 = add i64 %join.end66, %probe_read_kernel_str68
+  %67 = add i64 %63, 8
+  %probe_read_kernel72 = call i64 inttoptr (i64 113 to ptr)(ptr %join_r0, i32 8, i64 %67)
+  %68 = getelementptr i8, ptr %8, i64 %join.end71
+  %69 = load i64, ptr %join_r0, align 8
+  %probe_read_kernel_str73 = call i64 inttoptr (i64 115 to ptr)(ptr %68, i32 1024, i64 %69)
+  %70 = add i64 %join.end71, 1
+  %join.last75 = icmp slt i64 %probe_read_kernel_str73, 2
+  br i1 %join.last75, label %join_done, label %join_next74
+
+join_next74:                                      ; preds = %join_next69
+  %join.end76 = add i64 %join.end71, %probe_read_kernel_str73
+  br label %join_done
+
+join_done:                                        ; preds = %join_next74, %join_next69, %join_next64, %join_next59, %join_next54, %join_next49, %join_next44, %join_next39, %join_next34, %join_next29, %join_next24, %join_next19, %join_next14, %join_next9, %join_next4, %join_next, %lookup_join_merge
+  %join.size = phi i64 [ 1, %lookup_join_merge ], [ %14, %join_next ], [ %18, %join_next4 ], [ %22, %join_next9 ], [ %26, %join_next14 ], [ %30, %join_next19 ], [ %34, %join_next24 ], [ %38, %join_next29 ], [ %42, %join_next34 ], [ %46, %join_next39 ], [ %50, %join_next44 ], [ %54, %join_next49 ], [ %58, %join_next54 ], [ %62, %join_next59 ], [ %66, %join_next64 ], [ %70, %join_next69 ], [ %join.end76, %join_next74 ]
+  %71 = add i64 16, %join.size
+  %ringbuf_output = call i64 inttoptr (i64 130 to ptr)(ptr @ringbuf, ptr %lookup_join_map, i64 %71, i64 0)
   %ringbuf_loss = icmp slt i64 %ringbuf_output, 0
   br i1 %ringbuf_loss, label %event_loss_counter, label %counter_merge
 
-event_loss_counter:                               ; preds = %lookup_join_merge
+event_loss_counter:                               ; preds = %join_done
   %get_cpu_id = call i64 inttoptr (i64 8 to ptr)() #4
-  %56 = load i64, ptr @__bt__max_cpu_id, align 8
-  %cpu.id.bounded = and i64 %get_cpu_id, %56
-  %57 = getelementptr [1 x [1 x i64]], ptr @__bt__event_loss_counter, i64 0, i64 %cpu.id.bounded, i64 0
-  %58 = load i64, ptr %57, align 8
-  %59 = add i64 %58, 1
-  store i64 %59, ptr %57, align 8
+  %72 = load i64, ptr @__bt__max_cpu_id, align 8
+  %cpu.id.bounded = and i64 %get_cpu_id, %72
+  %73 = getelementptr [1 x [1 x i64]], ptr @__bt__event_loss_counter, i64 0, i64 %cpu.id.bounded, i64 0
+  %74 = load i64, ptr %73, align 8
+  %75 = add i64 %74, 1
+  store i64 %75, ptr %73, align 8
   br label %counter_merge
 
-counter_merge:                                    ; preds = %event_loss_counter, %lookup_join_merge
+counter_merge:                                    ; preds = %event_loss_counter, %join_done
   br label %failure_callback
 }
 
@@ -0,0 +1,189 @@
+; ModuleID = 'bpftrace'
+source_filename = "bpftrace"
+target datalayout = "e-m:e-p:64:64-i64:64-i128:128-n32:64-S128"
+target triple = "bpf"
+
+%"struct map_t" = type { ptr, ptr, ptr, ptr }
+%"struct map_t.0" = type { ptr, ptr, ptr, ptr }
+%"struct map_t.1" = type { ptr, ptr }
+
+@LICENSE = global [4 x i8] c"GPL\00", section "license", !dbg !0
+@AT_x = dso_local global %"struct map_t" zeroinitializer, section ".maps", !dbg !7
+@cms_AT_x = dso_local global %"struct map_t.0" zeroinitializer, section ".maps", !dbg !26
+@ringbuf = dso_local global %"struct map_t.1" zeroinitializer, section ".maps", !dbg !46
+@__bt__event_loss_counter = dso_local externally_initialized global [1 x [1 x i64]] zeroinitializer, section ".data.event_loss_counter", !dbg !60
+@__bt__max_cpu_id = dso_local externally_initialized constant i64 0, section ".rodata", !dbg !64
+
+; Function Attrs: nounwind
+declare i64 @llvm.bpf.pseudo(i64 %0, i64 %1) #0
+
+; Function Attrs: nounwind
+define i64 @kprobe_f_1(ptr %0) #0 section "s_kprobe_f_1" !dbg !70 {
+entry:
+  %topk_hash = alloca i64, align 8
+  %lookup_topk_sketch_key = alloca i32, align 4
+  %"@x_key" = alloca i64, align 8
+  call void @llvm.lifetime.start.p0(i64 -1, ptr %"@x_key")
+  store i64 1, ptr %"@x_key", align 8
+  %1 = getelementptr i8, ptr %"@x_key", i64 0
+  %2 = load i64, ptr %1, align 1
+  %3 = mul i64 %2, -4132994306676758123
+  %4 = lshr i64 %3, 47
+  %5 = xor i64 %3, %4
+  %6 = mul i64 %5, -4132994306676758123
+  %7 = xor i64 3829533694005038248, %6
+  %8 = mul i64 %7, -4132994306676758123
+  %9 = lshr i64 %8, 47
+  %10 = xor i64 %8, %9
+  %11 = mul i64 %10, -4132994306676758123
+  %12 = lshr i64 %11, 47
+  %key_hash = xor i64 %11, %12
+  call void @llvm.lifetime.start.p0(i64 -1, ptr %lookup_topk_sketch_key)
+  store i32 0, ptr %lookup_topk_sketch_key, align 4
+  %lookup_topk_sketch_map = call ptr inttoptr (i64 1 to ptr)(ptr @cms_AT_x, ptr %lookup_topk_sketch_key)
+  call void @llvm.lifetime.end.p0(i64 -1, ptr %lookup_topk_sketch_key)
+  %lookup_topk_sketch_cond = icmp ne ptr %lookup_topk_sketch_map, null
+  br i1 %lookup_topk_sketch_cond, label %lookup_topk_sketch_merge, label %lookup_topk_sketch_failure
+
+lookup_topk_sketch_failure:                       ; preds = %entry
+  ret i64 0
+
+lookup_topk_sketch_merge:                         ; preds = %entry
+  %13 = and i64 %key_hash, 4294967295
+  %14 = lshr i64 %key_hash, 32
+  %15 = mul i64 %14, 0
+  %16 = add i64 %13, %15
+  %17 = and i64 %16, 1023
+  %18 = add i64 %17, 0
+  %19 = getelementptr i32, ptr %lookup_topk_sketch_map, i64 %18
+  %20 = load i32, ptr %19, align 4
+  %21 = add i32 %20, 1
+  store i32 %21, ptr %19, align 4
+  %22 = mul i64 %14, 1
+  %23 = add i64 %13, %22
+  %24 = and i64 %23, 1023
+  %25 = add i64 %24, 1024
+  %26 = getelementptr i32, ptr %lookup_topk_sketch_map, i64 %25
+  %27 = load i32, ptr %26, align 4
+  %28 = add i32 %27, 1
+  store i32 %28, ptr %26, align 4
+  %29 = mul i64 %14, 2
+  %30 = add i64 %13, %29
+  %31 = and i64 %30, 1023
+  %32 = add i64 %31, 2048
+  %33 = getelementptr i32, ptr %lookup_topk_sketch_map, i64 %32
+  %34 = load i32, ptr %33, align 4
+  %35 = add i32 %34, 1
+  store i32 %35, ptr %33, align 4
+  %36 = mul i64 %14, 3
+  %37 = add i64 %13, %36
+  %38 = and i64 %37, 1023
+  %39 = add i64 %38, 3072
+  %40 = getelementptr i32, ptr %lookup_topk_sketch_map, i64 %39
+  %41 = load i32, ptr %40, align 4
+  %42 = add i32 %41, 1
+  store i32 %42, ptr %40, align 4
+  %lookup_elem = call ptr inttoptr (i64 1 to ptr)(ptr @AT_x, ptr %"@x_key")
+  %lookup_cond = icmp ne ptr %lookup_elem, null
+  br i1 %lookup_cond, label %lookup_merge, label %lookup_failure
+
+lookup_failure:                                   ; preds = %lookup_topk_sketch_merge
+  call void @llvm.lifetime.start.p0(i64 -1, ptr %topk_hash)
+  store i64 %key_hash, ptr %topk_hash, align 8
+  %update_elem = call i64 inttoptr (i64 2 to ptr)(ptr @AT_x, ptr %"@x_key", ptr %topk_hash, i64 0)
+  call void @llvm.lifetime.end.p0(i64 -1, ptr %topk_hash)
+  br label %lookup_merge
+
+lookup_merge:                                     ; preds = %lookup_failure, %lookup_topk_sketch_merge
+  call void @llvm.lifetime.end.p0(i64 -1, ptr %"@x_key")
+  ret i64 0
+}
+
+; Function Attrs: nocallback nofree nosync nounwind willreturn memory(argmem: readwrite)
+declare void @llvm.lifetime.start.p0(i64 immarg %0, ptr nocapture %1) #1
+
+; Function Attrs: nocallback nofree nosync nounwind willreturn memory(argmem: readwrite)
+declare void @llvm.lifetime.end.p0(i64 immarg %0, ptr nocapture %1) #1
+
+attributes #0 = { nounwind }
+attributes #1 = { nocallback nofree nosync nounwind willreturn memory(argmem: readwrite) }
+
+!llvm.dbg.cu = !{!66}
+!llvm.module.flags = !{!68, !69}
+
+!0 = !DIGlobalVariableExpression(var: !1, expr: !DIExpression())
+!1 = distinct !DIGlobalVariable(name: "LICENSE", linkageName: "global", scope: !2, file: !2, type: !3, isLocal: false, isDefinition: true)
+!2 = !DIFile(filename: "bpftrace.bpf.o", directory: ".")
+!3 = !DICompositeType(tag: DW_TAG_array_type, baseType: !4, size: 32, elements: !5)
+!4 = !DIBasicType(name: "int8", size: 8, encoding: DW_ATE_signed)
+!5 = !{!6}
+!6 = !DISubrange(count: 4, lowerBound: 0)
+!7 = !DIGlobalVariableExpression(var: !8, expr: !DIExpression())
+!8 = distinct !DIGlobalVariable(name: "AT_x", linkageName: "global", scope: !2, file: !2, type: !9, isLocal: false, isDefinition: true)
+!9 = !DICompositeType(tag: DW_TAG_structure_type, scope: !2, file: !2, size: 256, elements: !10)
+!10 = !{!11, !17, !22, !25}
+!11 = !DIDerivedType(tag: DW_TAG_member, name: "type", scope: !2, file: !2, baseType: !12, size: 64)
+!12 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !13, size: 64)
+!13 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 288, elements: !15)
+!14 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!15 = !{!16}
+!16 = !DISubrange(count: 9, lowerBound: 0)
+!17 = !DIDerivedType(tag: DW_TAG_member, name: "max_entries", scope: !2, file: !2, baseType: !18, size: 64, offset: 64)
+!18 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !19, size: 64)
+!19 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 131072, elements: !20)
+!20 = !{!21}
+!21 = !DISubrange(count: 4096, lowerBound: 0)
+!22 = !DIDerivedType(tag: DW_TAG_member, name: "key", scope: !2, file: !2, baseType: !23, size: 64, offset: 128)
+!23 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !24, size: 64)
+!24 = !DIBasicType(name: "int64", size: 64, encoding: DW_ATE_signed)
+!25 = !DIDerivedType(tag: DW_TAG_member, name: "value", scope: !2, file: !2, baseType: !23, size: 64, offset: 192)
+!26 = !DIGlobalVariableExpression(var: !27, expr: !DIExpression())
+!27 = distinct !DIGlobalVariable(name: "cms_AT_x", linkageName: "global", scope: !2, file: !2, type: !28, isLocal: false, isDefinition: true)
+!28 = !DICompositeType(tag: DW_TAG_structure_type, scope: !2, file: !2, size: 256, elements: !29)
+!29 = !{!30, !35, !40, !43}
+!30 = !DIDerivedType(tag: DW_TAG_member, name: "type", scope: !2, file: !2, baseType: !31, size: 64)
+!31 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !32, size: 64)
+!32 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 192, elements: !33)
+!33 = !{!34}
+!34 = !DISubrange(count: 6, lowerBound: 0)
+!35 = !DIDerivedType(tag: DW_TAG_member, name: "max_entries", scope: !2, file: !2, baseType: !36, size: 64, offset: 64)
+!36 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !37, size: 64)
+!37 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 32, elements: !38)
+!38 = !{!39}
+!39 = !DISubrange(count: 1, lowerBound: 0)
+!40 = !DIDerivedType(tag: DW_TAG_member, name: "key", scope: !2, file: !2, baseType: !41, size: 64, offset: 128)
+!41 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !42, size: 64)
+!42 = !DIBasicType(name: "int32", size: 32, encoding: DW_ATE_signed)
+!43 = !DIDerivedType(tag: DW_TAG_member, name: "value", scope: !2, file: !2, baseType: !44, size: 64, offset: 192)
+!44 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !45, size: 64)
+!45 = !DICompositeType(tag: DW_TAG_array_type, baseType: !42, size: 131072, elements: !20)
+!46 = !DIGlobalVariableExpression(var: !47, expr: !DIExpression())
+!47 = distinct !DIGlobalVariable(name: "ringbuf", linkageName: "global", scope: !2, file: !2, type: !48, isLocal: false, isDefinition: true)
+!48 = !DICompositeType(tag: DW_TAG_structure_type, scope: !2, file: !2, size: 128, elements: !49)
+!49 = !{!50, !55}
+!50 = !DIDerivedType(tag: DW_TAG_member, name: "type", scope: !2, file: !2, baseType: !51, size: 64)
+!51 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !52, size: 64)
+!52 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 864, elements: !53)
+!53 = !{!54}
+!54 = !DISubrange(count: 27, lowerBound: 0)
+!55 = !DIDerivedType(tag: DW_TAG_member, name: "max_entries", scope: !2, file: !2, baseType: !56, size: 64, offset: 64)
+!56 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !57, size: 64)
+!57 = !DICompositeType(tag: DW_TAG_array_type, baseType: !14, size: 8388608, elements: !58)
+!58 = !{!59}
+!59 = !DISubrange(count: 262144, lowerBound: 0)
+!60 = !DIGlobalVariableExpression(var: !61, expr: !DIExpression())
+!61 = distinct !DIGlobalVariable(name: "__bt__event_loss_counter", linkageName: "global", scope: !2, file: !2, type: !62, isLocal: false, isDefinition: true)
+!62 = !DICompositeType(tag: DW_TAG_array_type, baseType: !63, size: 64, elements: !38)
+!63 = !DICompositeType(tag: DW_TAG_array_type, baseType: !24, size: 64, elements: !38)
+!64 = !DIGlobalVariableExpression(var: !65, expr: !DIExpression())
+!65 = distinct !DIGlobalVariable(name: "__bt__max_cpu_id", linkageName: "global", scope: !2, file: !2, type: !24, isLocal: false, isDefinition: true)
+!66 = distinct !DICompileUnit(language: DW_LANG_C, file: !2, producer: "bpftrace", isOptimized: false, runtimeVersion: 0, emissionKind: LineTablesOnly, globals: !67)
+!67 = !{!0, !7, !26, !46, !60, !64}
+!68 = !{i32 2, !"Debug Info Version", i32 3}
+!69 = !{i32 7, !"uwtable", i32 0}
+!70 = distinct !DISubprogram(name: "kprobe_f_1", linkageName: "kprobe_f_1", scope: !2, file: !2, type: !71, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !66, retainedNodes: !74)
+!71 = !DISubroutineType(types: !72)
+!72 = !{!24, !73}
+!73 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !4, size: 64)
+!74 = !{!75}
+!75 = !DILocalVariable(name: "ctx", arg: 1, scope: !70, file: !2, type: !73)
@@ -46,6 +46,15 @@ TEST(codegen, fmt_str_args_stack)
                                LARGE_ON_STACK_LIMIT);
 }
 
+TEST(codegen, fmt_str_args_packed)
+{
+  test_stack_or_scratch_buffer(
+      R"(kprobe:f { printf("%s %d\n", ")" + std::string(MAX_STRLEN - 1, 'x') +
+          R"(", 1) })",
+      NAME,
+      SMALL_ON_STACK_LIMIT);
+}
+
 TEST(codegen, str_scratch_buf)
 {
   test_stack_or_scratch_buffer("kprobe:f { str(arg0) }",
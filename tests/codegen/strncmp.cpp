@@ -25,6 +25,15 @@ TEST(codegen, string_equal_comparison)
        NAME);
 }
 
+TEST(codegen, string_equal_comparison_strncmp_helper)
+{
+  auto bpftrace = get_mock_bpftrace();
+  auto feature = std::make_unique<MockBPFfeature>();
+  feature->set_has_helper_strncmp(true);
+  bpftrace->feature_ = std::move(feature);
+  test(*bpftrace, "kprobe:f { @[comm == \"sshd\"] = 1; }", NAME);
+}
+
 TEST(codegen, string_not_equal_comparison)
 {
   test("kprobe:f { @[comm != \"sshd\"] = 1; }",
@@ -1,3 +1,5 @@
+#include <cstdlib>
+
 #include "gtest/gtest.h"
 
 class ThrowListener : public testing::EmptyTestEventListener {
@@ -12,6 +14,9 @@ class ThrowListener : public testing::EmptyTestEventListener {
 int main(int argc, char *argv[])
 {
   ::testing::InitGoogleTest(&argc, argv);
+  // Don't leave parsed C definitions in the user's cache directory. Tests
+  // that exercise the cache point it to a temporary directory.
+  ::setenv("BPFTRACE_CACHE_DIR", "", 1);
   ::testing::UnitTest::GetInstance()->listeners().Append(new ThrowListener);
   return RUN_ALL_TESTS();
 }
@@ -0,0 +1,111 @@
+#include <sstream>
+
+#include "map_planner.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+namespace bpftrace::test::map_planner {
+
+using ::testing::HasSubstr;
+
+TEST(map_planner, map_memory_size)
+{
+  EXPECT_EQ(map_memory_size(libbpf::BPF_MAP_TYPE_HASH, 8, 8, 4096, 4), 262144);
+  EXPECT_EQ(map_memory_size(libbpf::BPF_MAP_TYPE_LRU_HASH, 8, 8, 4096, 4),
+            262144);
+  // Keys and values are rounded up to 8 bytes, per-CPU values are stored
+  // once for every CPU.
+  EXPECT_EQ(map_memory_size(libbpf::BPF_MAP_TYPE_PERCPU_HASH, 4, 16, 10, 4),
+            1280);
+  EXPECT_EQ(map_memory_size(libbpf::BPF_MAP_TYPE_ARRAY, 4, 12, 2, 4), 32);
+  EXPECT_EQ(map_memory_size(libbpf::BPF_MAP_TYPE_PERCPU_ARRAY, 4, 12, 1, 4),
+            64);
+  EXPECT_EQ(map_memory_size(libbpf::BPF_MAP_TYPE_RINGBUF, 0, 0, 262144, 4),
+            262144);
+}
+
+static MapPlanner make_planner(uint64_t budget)
+{
+  MapPlanner planner(1, budget);
+  planner.add(MapPlanEntry{ .name = "fixed",
+                            .type = libbpf::BPF_MAP_TYPE_ARRAY,
+                            .key_size = 4,
+                            .value_size = 1000,
+                            .max_entries = 1 });
+  planner.add(MapPlanEntry{ .name = "@a",
+                            .type = libbpf::BPF_MAP_TYPE_HASH,
+                            .key_size = 8,
+                            .value_size = 8,
+                            .max_entries = 1000,
+                            .resizable = true });
+  planner.add(MapPlanEntry{ .name = "@b",
+                            .type = libbpf::BPF_MAP_TYPE_PERCPU_HASH,
+                            .key_size = 8,
+                            .value_size = 8,
+                            .max_entries = 1000,
+                            .resizable = true });
+  planner.add(MapPlanEntry{ .name = "@declared",
+                            .type = libbpf::BPF_MAP_TYPE_HASH,
+                            .key_size = 8,
+                            .value_size = 8,
+                            .max_entries = 10 });
+  return planner;
+}
+
+TEST(map_planner, no_budget)
+{
+  auto planner = make_planner(0);
+  EXPECT_EQ(planner.total_size(), 1000 + 64000 + 72000 + 640);
+  ASSERT_TRUE(bool(planner.plan()));
+  for (const auto &entry : planner.entries())
+    EXPECT_FALSE(entry.resized);
+}
+
+TEST(map_planner, downsize)
+{
+  auto planner = make_planner(1000 + 640 + 68000);
+  ASSERT_TRUE(bool(planner.plan()));
+  EXPECT_LE(planner.total_size(), 1000 + 640 + 68000);
+
+  const auto &entries = planner.entries();
+  EXPECT_FALSE(entries[0].resized);
+  EXPECT_TRUE(entries[1].resized);
+  EXPECT_EQ(entries[1].max_entries, 500);
+  EXPECT_EQ(entries[1].type, libbpf::BPF_MAP_TYPE_LRU_HASH);
+  EXPECT_TRUE(entries[2].resized);
+  EXPECT_EQ(entries[2].max_entries, 500);
+  EXPECT_EQ(entries[2].type, libbpf::BPF_MAP_TYPE_LRU_PERCPU_HASH);
+  EXPECT_FALSE(entries[3].resized);
+  EXPECT_EQ(entries[3].max_entries, 10);
+
+  std::stringstream out;
+  planner.report(out);
+  EXPECT_THAT(out.str(), HasSubstr("(resized)"));
+  EXPECT_THAT(out.str(), HasSubstr("total map memory: 68.0KiB"));
+}
+
+TEST(map_planner, downsize_not_evictable)
+{
+  MapPlanner planner(1, 32000);
+  planner.add(MapPlanEntry{ .name = "@hist",
+                            .type = libbpf::BPF_MAP_TYPE_PERCPU_HASH,
+                            .key_size = 16,
+                            .value_size = 8,
+                            .max_entries = 1000,
+                            .resizable = true,
+                            .evictable = false });
+  ASSERT_TRUE(bool(planner.plan()));
+
+  const auto &entry = planner.entries()[0];
+  EXPECT_TRUE(entry.resized);
+  EXPECT_EQ(entry.max_entries, 400);
+  EXPECT_EQ(entry.type, libbpf::BPF_MAP_TYPE_PERCPU_HASH);
+}
+
+TEST(map_planner, budget_too_small)
+{
+  auto planner = make_planner(1000);
+  EXPECT_FALSE(bool(planner.plan()));
+}
+
+} // namespace bpftrace::test::map_planner
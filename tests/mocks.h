@@ -105,6 +105,12 @@ public:
     return { "mock_vmlinux" };
   }
 
+  std::unordered_set<std::string> get_raw_tracepoint_modules(
+      const std::string &__attribute__((unused)) /*name*/) const override
+  {
+    return { "vmlinux" };
+  }
+
   const std::optional<struct stat> &get_pidns_self_stat() const override
   {
     static const std::optional<struct stat> init_pid_namespace = []() {
@@ -163,8 +169,22 @@ public:
     has_get_ns_current_pid_tgid_ = std::make_optional<bool>(has_features);
     has_map_lookup_percpu_elem_ = std::make_optional<bool>(has_features);
     has_loop_ = std::make_optional<bool>(has_features);
+    // Keeps histogram helpers inlined, as in the expected codegen output.
+    has_btf_func_global_ = std::make_optional<bool>(false);
+    // Keeps string comparisons against literals unrolled.
+    has_strncmp_ = std::make_optional<bool>(false);
   };
 
+  void set_has_helper_strncmp(bool available)
+  {
+    has_strncmp_ = std::make_optional<bool>(available);
+  }
+
+  void set_has_btf_func_global(bool available)
+  {
+    has_btf_func_global_ = std::make_optional<bool>(available);
+  }
+
   bool has_fentry() override
   {
     return has_features_;
@@ -184,6 +204,12 @@ public:
     return false;
   }
 
+  bool has_helper_get_current_ancestor_cgroup_id(
+      libbpf::bpf_prog_type __attribute__((unused)) /*prog_type*/) override
+  {
+    return has_features_;
+  }
+
   bool has_features_;
 };
 
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "offline_symbolizer.h"
+#include "util/symbols.h"
+#include "util/temp.h"
+#include "gtest/gtest.h"
+
+namespace {
+#include "data/data_source_debug.h"
+#include "data/data_source_dwarf.h"
+#include "data/data_source_stripped.h"
+} // namespace
+
+namespace bpftrace::test::offline_symbolizer {
+
+using util::TempDir;
+
+static void write_file(const std::filesystem::path &path,
+                       const unsigned char *data,
+                       size_t size)
+{
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream file(path, std::ios::trunc | std::ios::binary);
+  file.write(reinterpret_cast<const char *>(data), size);
+  ASSERT_TRUE(file);
+}
+
+static const std::string BUILD_ID = "0123456789abcdef0123456789abcdef01234567";
+
+TEST(offline_symbolizer, format_frames)
+{
+  BuildIdFrame frame = {};
+  frame.status = BuildIdFrame::VALID;
+  for (size_t i = 0; i < sizeof(frame.build_id); i++)
+    frame.build_id[i] = (i % 8) * 0x22 + 0x01;
+  frame.offset = 0x1c2f4;
+  EXPECT_EQ(format_build_id_frame(frame),
+            "0123456789abcdef0123456789abcdef01234567+0x1c2f4");
+
+  frame.status = BuildIdFrame::IP;
+  frame.ip = 0x7f3a4c21f6a0;
+  EXPECT_EQ(format_build_id_frame(frame), "0x7f3a4c21f6a0");
+
+  EXPECT_EQ(format_kernel_frame(0xffffffff81e0010a),
+            "kernel+0xffffffff81e0010a");
+}
+
+TEST(offline_symbolizer, symbolize)
+{
+  auto dir = TempDir::create();
+  ASSERT_TRUE(bool(dir));
+  auto kallsyms = dir->create_file("kallsyms", false);
+  ASSERT_TRUE(bool(kallsyms));
+  std::string symbols = "ffffffff81000000 T _stext\n"
+                        "ffffffff81001000 t do_one_initcall\n";
+  ASSERT_TRUE(bool(kallsyms->write_all(symbols)));
+
+  OfflineSymbolizer symbolizer(dir->path(), kallsyms->path());
+  ASSERT_TRUE(symbolizer.has_kallsyms());
+
+  EXPECT_EQ(symbolizer.symbolize_line("    kernel+0xffffffff81001010"),
+            "    do_one_initcall+16");
+  // Frames of unknown binaries and plain addresses are left as they are.
+  EXPECT_EQ(symbolizer.symbolize_line("    " + BUILD_ID + "+0x10"),
+            "    " + BUILD_ID + "+0x10");
+  EXPECT_EQ(symbolizer.symbolize_line("    0x7f3a4c21f6a0"),
+            "    0x7f3a4c21f6a0");
+  EXPECT_EQ(symbolizer.symbolize_line("@[foo+0x10]: 1"), "@[foo+0x10]: 1");
+  // JSON output has all frames of a stack in one line.
+  EXPECT_EQ(symbolizer.symbolize_line(
+                R"({"@": {"\nkernel+0xffffffff81000008\n)"
+                R"(kernel+0xffffffff81001000\n": 1}})"),
+            R"({"@": {"\n_stext+8\ndo_one_initcall+0\n": 1}})");
+
+  std::istringstream in("@[\n"
+                        "    kernel+0xffffffff81000001\n"
+                        "]: 3\n");
+  std::ostringstream out;
+  symbolizer.symbolize(in, out);
+  EXPECT_EQ(out.str(), "@[\n    _stext+1\n]: 3\n");
+}
+
+TEST(offline_symbolizer, stripped_binary_with_debug_file)
+{
+  auto dir = TempDir::create();
+  ASSERT_TRUE(bool(dir));
+
+  // The file offset of an address in func_1, taken from the unstripped
+  // binary.
+  auto unstripped = dir->path() / "unstripped";
+  write_file(unstripped, dwarf_data, sizeof(dwarf_data));
+  auto build_id = util::get_elf_build_id(unstripped);
+  if (build_id.empty())
+    GTEST_SKIP() << "Test binary has no build-id";
+  auto index = util::ElfIndex::get(unstripped);
+  ASSERT_TRUE(index);
+  auto func = index->find("func_1");
+  ASSERT_TRUE(func.has_value());
+  auto offset = index->file_offset(func->start + 4);
+  ASSERT_TRUE(offset.has_value());
+
+  std::ostringstream frame;
+  frame << build_id << std::string(40 - std::min<size_t>(build_id.size(), 40),
+                                   '0')
+        << "+0x" << std::hex << *offset;
+
+  // The stripped binary alone only has its dynamic symbols.
+  auto debug_dir = dir->path() / "debug";
+  auto binary = debug_dir / ".build-id" / build_id.substr(0, 2) /
+                build_id.substr(2);
+  write_file(binary, stripped_data, sizeof(stripped_data));
+  {
+    OfflineSymbolizer symbolizer(debug_dir, std::nullopt);
+    EXPECT_EQ(symbolizer.symbolize_line(frame.str()), frame.str());
+  }
+
+  // Symbols come from the debug file, load segments from the binary.
+  write_file(binary.string() + ".debug", debug_data, sizeof(debug_data));
+  OfflineSymbolizer symbolizer(debug_dir, std::nullopt);
+  EXPECT_EQ(symbolizer.symbolize_line(frame.str()), "func_1+4");
+}
+
+} // namespace bpftrace::test::offline_symbolizer
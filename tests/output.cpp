@@ -98,4 +98,79 @@ TEST(TextOutput, lhist_suffix)
   EXPECT_TRUE(err.str().empty());
 }
 
+static std::vector<ProgStats> test_prog_stats()
+{
+  return {
+    ProgStats{ .probe = "kprobe:do_nanosleep",
+               .verified_insns = 120,
+               .xlated_len = 960,
+               .jited_len = 612,
+               .load_time_ns = 1500000,
+               .run_cnt = 4,
+               .run_time_ns = 10000 },
+    ProgStats{ .probe = "BEGIN",
+               .verified_insns = 8,
+               .xlated_len = 64,
+               .jited_len = 40,
+               .load_time_ns = 250000,
+               .run_cnt = 1,
+               .run_time_ns = 500 },
+  };
+}
+
+TEST(TextOutput, prog_stats)
+{
+  ast::CDefinitions c_definitions;
+  std::stringstream out;
+  std::stringstream err;
+  TextOutput output{ c_definitions, out, err };
+
+  output.prog_stats(test_prog_stats(), true);
+  EXPECT_EQ(R"(probe                verified  xlated   jited   load ms        runs      run ms    ns/run
+kprobe:do_nanosleep       120     960     612     1.500           4       0.010      2500
+BEGIN                       8      64      40     0.250           1       0.001       500
+)",
+            out.str());
+
+  out.str("");
+  output.prog_stats(test_prog_stats(), false);
+  EXPECT_EQ(R"(probe                verified  xlated   jited   load ms        runs      run ms    ns/run
+kprobe:do_nanosleep       120     960     612     1.500           -           -         -
+BEGIN                       8      64      40     0.250           -           -         -
+)",
+            out.str());
+  EXPECT_TRUE(err.str().empty());
+}
+
+TEST(JsonOutput, prog_stats)
+{
+  ast::CDefinitions c_definitions;
+  std::stringstream out;
+  std::stringstream err;
+  JsonOutput output{ c_definitions, out, err };
+
+  output.prog_stats(test_prog_stats(), true);
+  EXPECT_EQ(
+      R"({"type": "prog_stats", "data": [)"
+      R"({"probe": "kprobe:do_nanosleep", "verified_insns": 120, )"
+      R"("xlated_bytes": 960, "jited_bytes": 612, "load_ns": 1500000, )"
+      R"("run_cnt": 4, "run_time_ns": 10000}, )"
+      R"({"probe": "BEGIN", "verified_insns": 8, "xlated_bytes": 64, )"
+      R"("jited_bytes": 40, "load_ns": 250000, "run_cnt": 1, )"
+      R"("run_time_ns": 500}]})"
+      "\n",
+      out.str());
+
+  out.str("");
+  output.prog_stats({ test_prog_stats()[1] }, false);
+  EXPECT_EQ(
+      R"({"type": "prog_stats", "data": [)"
+      R"({"probe": "BEGIN", "verified_insns": 8, "xlated_bytes": 64, )"
+      R"("jited_bytes": 40, "load_ns": 250000, "run_cnt": null, )"
+      R"("run_time_ns": null}]})"
+      "\n",
+      out.str());
+  EXPECT_TRUE(err.str().empty());
+}
+
 } // namespace bpftrace::test::output
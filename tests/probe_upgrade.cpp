@@ -0,0 +1,80 @@
+#include "ast/passes/probe_upgrade.h"
+#include "ast/attachpoint_parser.h"
+#include "ast/passes/config_analyser.h"
+#include "btf.h"
+#include "btf_common.h"
+#include "driver.h"
+#include "mocks.h"
+#include "gtest/gtest.h"
+
+namespace bpftrace::test::probe_upgrade {
+
+class probe_upgrade_btf : public test_btf {};
+
+void test(const std::string& input, const std::string& expected, bool upgrade)
+{
+  auto bpftrace = get_mock_bpftrace();
+  bpftrace->config_->upgrade_probes = upgrade;
+  ast::ASTContext ast("stdin", input);
+  std::stringstream msg;
+  msg << "\nInput:\n" << input << "\n\nOutput:\n";
+
+  auto ok = ast::PassManager()
+                .put(ast)
+                .put<BPFtrace>(*bpftrace)
+                .add(CreateParsePass())
+                .add(ast::CreateConfigPass())
+                .add(ast::CreateParseAttachpointsPass())
+                .add(CreateParseBTFPass())
+                .add(ast::CreateProbeUpgradePass())
+                .run();
+  ASSERT_TRUE(ok && ast.diagnostics().ok()) << msg.str();
+  ASSERT_EQ(ast.root->probes.size(), 1U) << msg.str();
+  ASSERT_EQ(ast.root->probes[0]->attach_points.size(), 1U) << msg.str();
+  EXPECT_EQ(ast.root->probes[0]->attach_points[0]->name(), expected)
+      << msg.str();
+}
+
+void test(const std::string& input, const std::string& expected)
+{
+  test(input, expected, true);
+}
+
+TEST_F(probe_upgrade_btf, upgrade)
+{
+  test("kprobe:func_1 { @ = count() }", "fentry:mock_vmlinux:func_1");
+  test("kretprobe:func_1 { @[tid] = nsecs }", "fexit:mock_vmlinux:func_1");
+  test("kprobe:func_1 { @[func] = count() }", "fentry:mock_vmlinux:func_1");
+  test("tracepoint:sched:event_rt { @[comm] = count() }",
+       "rawtracepoint:vmlinux:event_rt");
+  test("config = { upgrade_probes = true } kprobe:func_1 { 1 }",
+       "fentry:mock_vmlinux:func_1",
+       false);
+}
+
+TEST_F(probe_upgrade_btf, not_upgraded)
+{
+  test("kprobe:func_1 { 1 }", "kprobe:func_1", false);
+  test("tracepoint:sched:event_rt { 1 }", "tracepoint:sched:event_rt", false);
+
+  // These depend on how the probe is attached.
+  test("kprobe:func_1 { arg0 }", "kprobe:func_1");
+  test("kprobe:func_1 /arg1 == 0/ { 1 }", "kprobe:func_1");
+  test("kprobe:func_1 { reg(\"ip\") }", "kprobe:func_1");
+  test("kprobe:func_1 { printf(\"%s\\n\", probe) }", "kprobe:func_1");
+  test("kretprobe:func_1 { @ = retval }", "kretprobe:func_1");
+  test("tracepoint:sched:event_rt { args }", "tracepoint:sched:event_rt");
+
+  // Wildcards and functions or events without BTF.
+  test("kprobe:func_* { 1 }", "kprobe:func_*");
+  test("kprobe:sys_read { 1 }", "kprobe:sys_read");
+  test("tracepoint:sched:sched_one { 1 }", "tracepoint:sched:sched_one");
+}
+
+TEST(probe_upgrade, no_btf)
+{
+  test("kprobe:func_1 { 1 }", "kprobe:func_1");
+  test("tracepoint:sched:event_rt { 1 }", "tracepoint:sched:event_rt");
+}
+
+} // namespace bpftrace::test::probe_upgrade
@@ -96,6 +96,31 @@ TEST(resource_analyser, fmt_string_args_size_strings)
   EXPECT_EQ(resources.max_fmtstring_args_size, 72);
 }
 
+TEST(resource_analyser, fmt_string_args_packed)
+{
+  RequiredResources resources;
+  test(R"(BEGIN { printf("%s %d %s\n", str(0), 1, comm) })", true, &resources);
+  ASSERT_EQ(resources.printf_args.size(), 1);
+  const auto &fields = std::get<1>(resources.printf_args[0]);
+  ASSERT_EQ(fields.size(), 3);
+  // The large string moves behind the fixed arguments
+  EXPECT_TRUE(fields[0].is_packed);
+  EXPECT_EQ(fields[0].offset, 32);
+  EXPECT_FALSE(fields[1].is_packed);
+  EXPECT_EQ(fields[1].offset, 8);
+  EXPECT_FALSE(fields[2].is_packed);
+  EXPECT_EQ(fields[2].offset, 16);
+  EXPECT_EQ(resources.max_fmtstring_args_size, 1056);
+}
+
+TEST(resource_analyser, fmt_string_args_not_packed_on_stack)
+{
+  RequiredResources resources;
+  test(R"(BEGIN { printf("%s\n", str(0)) })", true, &resources, 2048);
+  ASSERT_EQ(resources.printf_args.size(), 1);
+  EXPECT_FALSE(std::get<1>(resources.printf_args[0])[0].is_packed);
+}
+
 TEST(resource_analyser, fmt_string_args_non_map_print_int)
 {
   RequiredResources resources;
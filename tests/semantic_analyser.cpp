@@ -916,6 +916,63 @@ kprobe:f { @ = tseries(1, 10s, 5, "stats"); }
 )");
 }
 
+TEST(semantic_analyser, call_topk)
+{
+  test("kprobe:f { @x[comm] = topk(); }");
+  test("kprobe:f { @x[comm, pid] = topk(5); }");
+  test("kprobe:f { @x[kstack] = topk(1000); }");
+  test_error("kprobe:f { @x[comm] = topk(0); }", R"(
+stdin:1:23-30: ERROR: topk: k 0 must be 1..1000
+kprobe:f { @x[comm] = topk(0); }
+                      ~~~~~~~
+)");
+  test_error("kprobe:f { @x[comm] = topk(1001); }", R"(
+stdin:1:23-33: ERROR: topk: k 1001 must be 1..1000
+kprobe:f { @x[comm] = topk(1001); }
+                      ~~~~~~~~~~
+)");
+  test_error("kprobe:f { @ = topk(); }", R"(
+stdin:1:16-22: ERROR: topk() counts map keys and must be assigned to a keyed map, e.g. @x[comm] = topk()
+kprobe:f { @ = topk(); }
+               ~~~~~~
+)");
+  test_error("kprobe:f { topk(); }", R"(
+stdin:1:12-18: ERROR: topk() must be assigned directly to a map
+kprobe:f { topk(); }
+           ~~~~~~
+)");
+}
+
+TEST(semantic_analyser, call_distinct)
+{
+  test("kprobe:f { @x = distinct(pid); }");
+  test("kprobe:f { @x[comm] = distinct(arg0); }");
+  test("kprobe:f { @x = distinct(comm); }");
+  test("kprobe:f { @x = distinct((pid, comm)); }");
+  test("kprobe:f { @x = distinct(kstack); }");
+  test("kprobe:f { @x = distinct(); }", 1);
+  test("kprobe:f { distinct(pid); }", 1);
+  test("kprobe:f { $x = distinct(pid); }", 1);
+  test("kprobe:f { @[distinct(pid)] = 1; }", 1);
+  test_error("kprobe:f { @x = distinct(ksym(1)); }", R"(
+stdin:1:17-34: ERROR: distinct() expects an integer, string, buffer, inet, tuple or stack argument (ksym_t provided)
+kprobe:f { @x = distinct(ksym(1)); }
+                ~~~~~~~~~~~~~~~~~
+)");
+}
+
+TEST(semantic_analyser, call_quantiles)
+{
+  test("kprobe:f { @x = quantiles(1); }");
+  test("kprobe:f { @x[comm] = quantiles(arg2); }");
+  test("kprobe:f { @x = quantiles(-1); }");
+  test("kprobe:f { @x = quantiles(); }", 1);
+  test("kprobe:f { @x = quantiles(comm); }", 1);
+  test("kprobe:f { quantiles(1); }", 1);
+  test("kprobe:f { $x = quantiles(1); }", 1);
+  test("kprobe:f { @[quantiles(1)] = 1; }", 1);
+}
+
 TEST(semantic_analyser, call_tseries_posparam)
 {
   BPFtrace bpftrace;
@@ -1729,6 +1786,29 @@ TEST(semantic_analyser, call_cgroup_path)
   test("kprobe:f { printf(\"%d\", cgroup_path(1)) }", 2);
 }
 
+TEST(semantic_analyser, cgroup_filter)
+{
+  auto bpftrace = get_mock_bpftrace();
+  bpftrace->cgroup_filter_ = CgroupFilter{
+    .path = "/sys/fs/cgroup/test",
+    .id = 1234,
+    .level = 2,
+  };
+  test(*bpftrace, "kprobe:f { 1 } tracepoint:sched:sched_one { 1 }");
+
+  // Probes which are not filtered do not need the helper.
+  test(*bpftrace, false, "BEGIN { 1 } interval:s:1 { 1 }", 0);
+  test(*bpftrace, false, "profile:hz:99 { 1 }", 0);
+  test_error(*bpftrace,
+             "kprobe:f { 1 }",
+             R"(
+stdin:1:1-9: ERROR: --cgroup is not supported for kprobe probes: the get_current_ancestor_cgroup_id BPF helper is not available for BPF_PROG_TYPE_KPROBE programs
+kprobe:f { 1 }
+~~~~~~~~
+)",
+             false);
+}
+
 TEST(semantic_analyser, call_strerror)
 {
   test("kprobe:f { strerror(1) }");
@@ -5207,6 +5287,15 @@ BEGIN { @a = tseries(10, 10s, 1); let $b = @a; }
                                   ~~~~~~
 )");
 
+  test_error("BEGIN { @a[1] = topk(); let $b = @a[1]; }", R"(
+stdin:1:25-39: ERROR: Value 'topk_t' cannot be assigned to a scratch variable.
+BEGIN { @a[1] = topk(); let $b = @a[1]; }
+                        ~~~~~~~~~~~~~~
+stdin:1:25-31: WARNING: Variable $b never assigned to.
+BEGIN { @a[1] = topk(); let $b = @a[1]; }
+                        ~~~~~~
+)");
+
   test_error("BEGIN { @a = stats(10); let $b = @a; }", R"(
 stdin:1:25-36: ERROR: Value 'stats_t' cannot be assigned to a scratch variable.
 BEGIN { @a = stats(10); let $b = @a; }
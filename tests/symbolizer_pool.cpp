@@ -0,0 +1,67 @@
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "symbolizer_pool.h"
+#include "gtest/gtest.h"
+
+namespace bpftrace::test::symbolizer_pool {
+
+using namespace std::chrono_literals;
+
+TEST(symbolizer_pool, ordered_output)
+{
+  Config config;
+  SymbolizerPool pool(config, 4);
+  std::vector<int> emitted;
+
+  for (int i = 0; i < 100; i++) {
+    auto result = std::make_shared<int>(-1);
+    // Earlier jobs take longer, so they finish out of order.
+    auto job = [i, result](Ksyms &, Usyms &) {
+      std::this_thread::sleep_for(std::chrono::microseconds((100 - i) * 10));
+      *result = i;
+    };
+    auto emit = [&emitted, result] { emitted.push_back(*result); };
+    if (i % 10 == 0)
+      pool.submit(nullptr, [&emitted, i] { emitted.push_back(i); });
+    else
+      pool.submit(job, emit);
+  }
+  pool.drain();
+  EXPECT_TRUE(pool.empty());
+
+  ASSERT_EQ(emitted.size(), 100);
+  for (int i = 0; i < 100; i++)
+    EXPECT_EQ(emitted[i], i);
+}
+
+TEST(symbolizer_pool, emit_ready)
+{
+  Config config;
+  SymbolizerPool pool(config, 1);
+  std::vector<int> emitted;
+
+  std::mutex mutex;
+  mutex.lock();
+  pool.submit(
+      [&mutex](Ksyms &, Usyms &) { std::lock_guard<std::mutex> lock(mutex); },
+      [&emitted] { emitted.push_back(0); });
+  pool.submit(nullptr, [&emitted] { emitted.push_back(1); });
+
+  // The first job is blocked, nothing may be emitted yet, not even the second
+  // submission which has no job.
+  pool.emit_ready();
+  EXPECT_TRUE(emitted.empty());
+  EXPECT_FALSE(pool.empty());
+
+  mutex.unlock();
+  pool.drain();
+  EXPECT_EQ(emitted, std::vector<int>({ 0, 1 }));
+}
+
+} // namespace bpftrace::test::symbolizer_pool
@@ -0,0 +1,74 @@
+#include <sstream>
+#include <unistd.h>
+
+#include "util/timing.h"
+#include "gtest/gtest.h"
+
+namespace bpftrace::test::timing {
+
+using util::Timeline;
+
+TEST(timing, write_trace)
+{
+  Timeline timeline;
+  auto start = Timeline::clock::now();
+  timeline.add("pass", "parse", start, start + std::chrono::microseconds(1500));
+  timeline.add("clang",
+               "definitions.h",
+               start + std::chrono::microseconds(200),
+               start + std::chrono::microseconds(700));
+  timeline.add("attach",
+               "kprobe:\"quoted\"",
+               start + std::chrono::microseconds(2000),
+               start + std::chrono::microseconds(2010));
+
+  std::ostringstream out;
+  timeline.write_trace(out);
+  std::string ids = R"(, "pid": )" + std::to_string(getpid()) +
+                    R"(, "tid": )" + std::to_string(gettid()) + "}";
+  EXPECT_EQ(out.str(),
+            R"({"displayTimeUnit": "ms", "traceEvents": [)"
+            "\n"
+            R"({"name": "parse", "cat": "pass", "ph": "X", "ts": 0, )"
+            R"("dur": 1500)" +
+                ids + ",\n" +
+                R"({"name": "definitions.h", "cat": "clang", "ph": "X", )"
+                R"("ts": 200, "dur": 500)" +
+                ids + ",\n" +
+                R"({"name": "kprobe:\"quoted\"", "cat": "attach", )"
+                R"("ph": "X", "ts": 2000, "dur": 10)" +
+                ids + "\n]}\n");
+}
+
+TEST(timing, print_totals)
+{
+  Timeline timeline;
+  auto start = Timeline::clock::now();
+  timeline.add("attach",
+               "kprobe:f",
+               start + std::chrono::milliseconds(3),
+               start + std::chrono::milliseconds(4));
+  timeline.add("pass", "parse", start, start + std::chrono::milliseconds(2));
+  timeline.add("pass",
+               "semantic",
+               start + std::chrono::milliseconds(2),
+               start + std::chrono::milliseconds(3));
+
+  // Stages in the order in which they started.
+  std::ostringstream out;
+  timeline.print_totals(out);
+  EXPECT_EQ(out.str(),
+            "pass                       3.000 ms       2\n"
+            "attach                     1.000 ms       1\n");
+}
+
+TEST(timing, disabled)
+{
+  ASSERT_FALSE(util::timing_enabled());
+  {
+    util::TimingSpan span("pass", "parse");
+  }
+  EXPECT_TRUE(util::timeline().empty());
+}
+
+} // namespace bpftrace::test::timing
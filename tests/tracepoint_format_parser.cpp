@@ -16,6 +16,12 @@ public:
   {
     return get_tracepoint_struct(format_file, category, event_name, bpftrace);
   }
+
+  static std::shared_ptr<Struct> get_tracepoint_record_public(
+      std::istream &format_file)
+  {
+    return get_tracepoint_record(format_file);
+  }
 };
 
 TEST(tracepoint_format_parser, tracepoint_struct)
@@ -256,4 +262,78 @@ TEST(tracepoint_format_parser, tracepoint_struct_btf)
   EXPECT_THAT(bpftrace->btf_set_, Contains("TASK_COMM_LEN"));
 }
 
+TEST(tracepoint_format_parser, record)
+{
+  std::string input =
+      "	field:unsigned short common_type;	offset:0;	size:2;	"
+      "signed:0;\n"
+      "	field:int common_pid;	offset:4;	size:4;	signed:1;\n"
+      "	field:int __syscall_nr;	offset:8;	size:4;	signed:1;\n"
+      "	field:unsigned int fd;	offset:16;	size:8;	signed:0;\n"
+      "	field:const char * buf;	offset:24;	size:8;	signed:0;\n"
+      "	field:char comm[16];	offset:32;	size:16;	signed:1;\n"
+      "	field:u32 args[2];	offset:48;	size:8;	signed:0;\n"
+      "	field:__data_loc char[] msg;	offset:56;	size:4;	signed:1;\n";
+
+  std::istringstream format_file(input);
+  auto record = MockTracepointFormatParser::get_tracepoint_record_public(
+      format_file);
+  ASSERT_TRUE(record);
+  EXPECT_EQ(record->size, 64);
+
+  const auto &common_type = record->GetField("common_type");
+  EXPECT_TRUE(common_type.type.IsIntTy());
+  EXPECT_FALSE(common_type.type.IsSigned());
+  EXPECT_EQ(common_type.type.GetSize(), 2U);
+  EXPECT_EQ(common_type.offset, 0);
+
+  // Same padding as in the C definition
+  EXPECT_FALSE(record->HasField("__pad_2"));
+  EXPECT_TRUE(record->HasField("__pad_12"));
+  EXPECT_TRUE(record->HasField("__pad_15"));
+
+  const auto &fd = record->GetField("fd");
+  EXPECT_TRUE(fd.type.IsIntTy());
+  EXPECT_FALSE(fd.type.IsSigned());
+  EXPECT_EQ(fd.type.GetSize(), 8U);
+  EXPECT_EQ(fd.offset, 16);
+
+  const auto &buf = record->GetField("buf");
+  ASSERT_TRUE(buf.type.IsPtrTy());
+  EXPECT_TRUE(buf.type.GetPointeeTy()->IsIntTy());
+  EXPECT_EQ(buf.type.GetPointeeTy()->GetSize(), 1U);
+
+  const auto &comm = record->GetField("comm");
+  EXPECT_TRUE(comm.type.IsStringTy());
+  EXPECT_EQ(comm.type.GetSize(), 16U);
+
+  const auto &args = record->GetField("args");
+  ASSERT_TRUE(args.type.IsArrayTy());
+  EXPECT_EQ(args.type.GetNumElements(), 2U);
+  EXPECT_EQ(args.type.GetElementTy()->GetSize(), 4U);
+
+  const auto &msg = record->GetField("msg");
+  EXPECT_TRUE(msg.is_data_loc);
+  EXPECT_EQ(msg.type.GetSize(), 8U);
+  EXPECT_EQ(msg.offset, 56);
+}
+
+TEST(tracepoint_format_parser, record_needs_clang)
+{
+  std::vector<std::string> inputs = {
+    "	field:struct foo * foo;	offset:8;	size:8;	signed:0;\n",
+    "	field:enum bar bar;	offset:8;	size:4;	signed:0;\n",
+    "	field:atomic_t count;	offset:8;	size:4;	signed:0;\n",
+    "	field:char comm[TASK_COMM_LEN];	offset:8;	size:16;	signed:0;\n",
+    "	field:unsigned short mismatch;	offset:8;	size:4;	signed:0;\n",
+  };
+
+  for (const auto &input : inputs) {
+    std::istringstream format_file(input);
+    EXPECT_FALSE(
+        MockTracepointFormatParser::get_tracepoint_record_public(format_file))
+        << input;
+  }
+}
+
 } // namespace bpftrace::test::tracepoint_format_parser
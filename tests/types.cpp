@@ -76,4 +76,27 @@ TEST(types, to_str)
   EXPECT_EQ(to_str(CreateVoid()), "void");
 }
 
+TEST(types, stack_type)
+{
+  StackType stack{ .limit = 10, .mode = StackMode::build_id };
+  auto kstack = CreateStack(true, stack).stack_type;
+  auto ustack = CreateStack(false, stack).stack_type;
+
+  // Only user frames are struct bpf_stack_build_id, so kernel and user
+  // stacks need separate maps.
+  EXPECT_EQ(kstack.value_words(), 10);
+  EXPECT_EQ(ustack.value_words(), 40);
+  EXPECT_NE(kstack, ustack);
+  EXPECT_NE(kstack.name(), ustack.name());
+
+  // In other modes they share the same map.
+  stack.mode = StackMode::bpftrace;
+  kstack = CreateStack(true, stack).stack_type;
+  ustack = CreateStack(false, stack).stack_type;
+  EXPECT_EQ(kstack.value_words(), 10);
+  EXPECT_EQ(ustack.value_words(), 10);
+  EXPECT_EQ(kstack, ustack);
+  EXPECT_EQ(kstack.name(), ustack.name());
+}
+
 } // namespace bpftrace::test::types
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
@@ -7,13 +10,18 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "util/arena.h"
 #include "util/bpf_names.h"
+#include "util/cache.h"
 #include "util/cgroup.h"
 #include "util/io.h"
+#include "util/kallsyms.h"
 #include "util/kernel.h"
 #include "util/math.h"
 #include "util/paths.h"
 #include "util/similar.h"
+#include "util/sketch.h"
+#include "util/stats.h"
 #include "util/strings.h"
 #include "util/symbols.h"
 #include "util/system.h"
@@ -105,6 +113,18 @@ TEST(utils, erase_parameter_list)
   test_erase_parameter_list("void foo(Bar &b", "void foo(Bar &b");
 }
 
+TEST(utils, json_escape)
+{
+  EXPECT_EQ(json_escape(""), "");
+  EXPECT_EQ(json_escape("parse/semantic"), "parse/semantic");
+  EXPECT_EQ(json_escape(R"(a "b" c:\d)"), R"(a \"b\" c:\\d)");
+  EXPECT_EQ(json_escape("a\tb\nc\r"), R"(a\tb\nc\r)");
+  EXPECT_EQ(json_escape(std::string("\x00\x01\x1f", 3)),
+            R"(\u0000\u0001\u001f)");
+  // Bytes of UTF-8 sequences are kept as they are
+  EXPECT_EQ(json_escape("\xc3\xa9"), "\xc3\xa9");
+}
+
 TEST(utils, wildcard_match)
 {
   std::vector<std::string> tokens_not = { "not" };
@@ -244,6 +264,21 @@ TEST(utils, get_cgroup_hierarchy_roots)
   }
 }
 
+TEST(utils, get_cgroup_level)
+{
+  auto roots = get_cgroup_hierarchy_roots();
+  for (const auto &root : roots[1]) {
+    EXPECT_EQ(get_cgroup_level(root), 0);
+    EXPECT_EQ(get_cgroup_level(root + "/"), 0);
+  }
+  // cgroupv1 hierarchies are not supported.
+  for (const auto &root : roots[0]) {
+    EXPECT_EQ(get_cgroup_level(root), std::nullopt);
+  }
+  EXPECT_EQ(get_cgroup_level("/tmp"), std::nullopt);
+  EXPECT_EQ(get_cgroup_level("/nonexistent/cgroup"), std::nullopt);
+}
+
 TEST(utils, get_cgroup_path_in_hierarchy)
 {
   std::string tmpdir = "/tmp/bpftrace-test-utils-XXXXXX";
@@ -279,6 +314,14 @@ TEST(utils, get_cgroup_path_in_hierarchy)
               "/subdir/file2");
   }
 
+  // Renaming a directory changes the paths of everything below it.
+  const std::filesystem::path renamed = path / "renamed";
+  std::filesystem::rename(subdir, renamed);
+  EXPECT_EQ(get_cgroup_path_in_hierarchy(file_2_st.st_ino, tmpdir),
+            "/renamed/file2");
+  std::filesystem::remove(file_1);
+  EXPECT_EQ(get_cgroup_path_in_hierarchy(file_1_st.st_ino, tmpdir), "");
+
   EXPECT_GT(std::filesystem::remove_all(tmpdir), 0);
 }
 
@@ -423,6 +466,32 @@ TEST(utils, get_pids_for_program)
   EXPECT_EQ(pids.size(), 0);
 }
 
+TEST(utils, get_pid_start_time)
+{
+  auto start_time = get_pid_start_time(getpid());
+  ASSERT_TRUE(start_time.has_value());
+  // We started after init.
+  EXPECT_GE(*start_time, get_pid_start_time(1).value_or(0));
+  EXPECT_EQ(get_pid_start_time(getpid()), start_time);
+
+  EXPECT_FALSE(get_pid_start_time(-1).has_value());
+}
+
+TEST(utils, get_exec_mappings)
+{
+  auto exe = get_pid_exe(getpid());
+  ASSERT_TRUE(bool(exe));
+  auto mappings = get_exec_mappings(getpid());
+  // Our own code is mapped, at least.
+  EXPECT_TRUE(std::ranges::any_of(
+      mappings, [&](const ProcMapping &m) { return m.path == *exe; }));
+  for (const auto &mapping : mappings)
+    EXPECT_LT(mapping.start, mapping.end);
+  EXPECT_TRUE(std::ranges::is_sorted(mappings, {}, &ProcMapping::start));
+
+  EXPECT_TRUE(get_exec_mappings(-1).empty());
+}
+
 TEST(utils, round_up_to_next_power_of_two)
 {
   // 2^31 = 2147483648 which is max power of 2 within uint32_t
@@ -437,6 +506,327 @@ TEST(utils, round_up_to_next_power_of_two)
   ASSERT_EQ(round_up_to_next_power_of_two(max_power_of_two), max_power_of_two);
 }
 
+TEST(utils, arena)
+{
+  struct Tracked {
+    Tracked(std::vector<int> &destroyed, int id)
+        : destroyed(destroyed), id(id)
+    {
+    }
+    ~Tracked()
+    {
+      destroyed.push_back(id);
+    }
+    std::vector<int> &destroyed;
+    int id;
+  };
+
+  std::vector<int> destroyed;
+  {
+    Arena arena;
+    auto *a = arena.make<Tracked>(destroyed, 1);
+    auto *b = arena.make<uint64_t>(42);
+    auto *c = arena.make<Tracked>(destroyed, 2);
+    // Larger than a slab.
+    auto *big = arena.make<std::array<char, Arena::SLAB_SIZE + 1>>();
+    EXPECT_EQ(a->id, 1);
+    EXPECT_EQ(*b, 42);
+    EXPECT_EQ(c->id, 2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(uint64_t), 0);
+    big->back() = 'x';
+    EXPECT_EQ(arena.size(), 4);
+
+    // Objects are destroyed in reverse order.
+    arena.clear();
+    EXPECT_EQ(destroyed, std::vector<int>({ 2, 1 }));
+    EXPECT_EQ(arena.size(), 0);
+
+    for (int i = 0; i < 10000; i++)
+      EXPECT_EQ(arena.make<Tracked>(destroyed, i)->id, i);
+    destroyed.clear();
+  }
+  ASSERT_EQ(destroyed.size(), 10000);
+  EXPECT_EQ(destroyed.front(), 9999);
+  EXPECT_EQ(destroyed.back(), 0);
+}
+
+TEST(utils, cache_dir)
+{
+  std::string tmpdir = "/tmp/bpftrace-test-cache-XXXXXX";
+  ASSERT_TRUE(::mkdtemp(tmpdir.data()));
+  const std::filesystem::path path(tmpdir);
+
+  // Caching is disabled for all tests, see main.cpp.
+  EXPECT_FALSE(get_cache_subdir("test").has_value());
+  ::setenv("BPFTRACE_CACHE_DIR", (path / "cache").c_str(), 1);
+  auto dir = get_cache_subdir("test");
+  ASSERT_TRUE(dir.has_value());
+  EXPECT_EQ(*dir, std::filesystem::canonical(path / "cache" / "test"));
+
+  // Files are evicted least recently used first, opening a file uses it.
+  auto now = std::filesystem::file_time_type::clock::now();
+  for (int i = 0; i < 3; i++) {
+    auto file = *dir / std::to_string(i);
+    std::ofstream(file) << std::string(100, 'x');
+    std::filesystem::last_write_time(file, now - std::chrono::hours(3 - i));
+  }
+  int fd = open_cache_file(*dir / "0");
+  ASSERT_GE(fd, 0);
+  ::close(fd);
+  trim_cache_dir(*dir, 200);
+  EXPECT_TRUE(std::filesystem::exists(*dir / "0"));
+  EXPECT_FALSE(std::filesystem::exists(*dir / "1"));
+  EXPECT_TRUE(std::filesystem::exists(*dir / "2"));
+
+  // Symlinks are not followed.
+  std::filesystem::create_symlink(*dir / "0", *dir / "link");
+  EXPECT_LT(open_cache_file(*dir / "link"), 0);
+
+  // Directories that others can write to are not used.
+  std::filesystem::permissions(*dir,
+                               std::filesystem::perms::others_write,
+                               std::filesystem::perm_options::add);
+  EXPECT_FALSE(get_cache_subdir("test").has_value());
+  ::setenv("BPFTRACE_CACHE_DIR", "", 1);
+
+  EXPECT_GT(std::filesystem::remove_all(path), 0);
+}
+
+TEST(utils, elf_symbol_table)
+{
+  ElfSymbolTable table;
+  table.add("main", 0x2000, 0x100, true);
+  table.add("data", 0x1000, 0x10, false);
+  table.add("marker", 0x3000, 0, true);
+  table.add("main_alias", 0x2000, 0x100, true);
+  table.add("main_head", 0x2000, 0x10, true);
+  table.finish();
+  ASSERT_EQ(table.size(), 5);
+
+  auto check = [](const ElfSymbolTable &table) {
+    EXPECT_FALSE(table.lookup(0xfff).has_value());
+    EXPECT_EQ(table.lookup(0x1000)->name, "data");
+    EXPECT_FALSE(table.lookup(0x1010).has_value());
+    // The largest of the symbols starting at the same address, the first one
+    // added if they have the same size.
+    EXPECT_EQ(table.lookup(0x2000)->name, "main");
+    EXPECT_EQ(table.lookup(0x20ff)->name, "main");
+    EXPECT_EQ(table.lookup(0x20ff)->start, 0x2000);
+    EXPECT_FALSE(table.lookup(0x2100).has_value());
+    // Symbols of size 0 only match their start address.
+    EXPECT_EQ(table.lookup(0x3000)->name, "marker");
+    EXPECT_FALSE(table.lookup(0x3001).has_value());
+
+    // Symbols are sorted by address.
+    EXPECT_EQ(table[0].name, "data");
+    EXPECT_EQ(table[0].start, 0x1000);
+    EXPECT_EQ(table[0].end, 0x1010);
+    EXPECT_FALSE(table[0].is_function);
+    EXPECT_EQ(table[4].name, "marker");
+    EXPECT_TRUE(table[4].is_function);
+  };
+  check(table);
+
+  std::string path = "/tmp/bpftrace-test-symbols-XXXXXX";
+  if (::mkdtemp(path.data()) == nullptr) {
+    throw std::runtime_error("creating temporary path for tests failed");
+  }
+  ASSERT_TRUE(table.save(path + "/table"));
+  auto loaded = ElfSymbolTable::load(path + "/table");
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(loaded->size(), 5);
+  check(*loaded);
+
+  // Truncated tables are rejected.
+  std::filesystem::resize_file(path + "/table",
+                               std::filesystem::file_size(path + "/table") - 1);
+  EXPECT_FALSE(ElfSymbolTable::load(path + "/table"));
+  EXPECT_FALSE(ElfSymbolTable::load(path + "/missing"));
+
+  EXPECT_GT(std::filesystem::remove_all(path), 0);
+}
+
+TEST(utils, elf_index)
+{
+  auto table = std::make_shared<ElfSymbolTable>();
+  table->add("foo", 0x401000, 0x20, true);
+  table->add("local", 0x401100, 0x10, true);
+  table->add("local", 0x401000 - 0x10, 0x10, true);
+  table->add("bar", 0x402000, 0x20, true);
+  table->finish();
+
+  std::vector<ElfIndex::LoadSegment> segments = {
+    { .vaddr = 0x400000, .size = 0x1800, .file_offset = 0 },
+    { .vaddr = 0x402000, .size = 0x1000, .file_offset = 0x1800 },
+  };
+  ElfIndex index(table, segments, true);
+
+  EXPECT_EQ(index.find("foo")->start, 0x401000);
+  EXPECT_EQ(index.lookup(0x401010)->name, "foo");
+  EXPECT_FALSE(index.find("missing").has_value());
+  // The lowest address if several symbols have the same name.
+  EXPECT_EQ(index.find("local")->start, 0x400ff0);
+  EXPECT_EQ(index.find_all("local").size(), 2);
+  EXPECT_TRUE(index.find_all("missing").empty());
+
+  EXPECT_EQ(index.file_offset(0x401000), 0x1000);
+  EXPECT_EQ(index.file_offset(0x402010), 0x1810);
+  EXPECT_FALSE(index.file_offset(0x403000).has_value());
+  EXPECT_EQ(index.address(0x1000), 0x401000);
+  EXPECT_EQ(index.address(0x1810), 0x402010);
+  EXPECT_FALSE(index.address(0x2800).has_value());
+
+  ElfIndex relocatable(table, {}, false);
+  EXPECT_EQ(relocatable.file_offset(0x401000), 0x401000);
+  EXPECT_EQ(relocatable.address(0x401000), 0x401000);
+}
+
+TEST(utils, kallsyms_index)
+{
+  std::istringstream kallsyms("ffffffff81000000 T _stext\n"
+                              "ffffffff81000000 T startup_64\n"
+                              "ffffffff81001000 t do_one_initcall\n"
+                              "ffffffff82000000 D jiffies\n"
+                              "0000000000000000 A fixed_percpu_data\n"
+                              "ffffffffc0001000 t foo_init\t[foo]\n"
+                              "ffffffffc0000000 t foo_exit\t[foo]\n"
+                              "ffffffffc0002000 t bpf_prog_1\t[bpf]\n"
+                              "ffffffffc0003000 t bar_init\t[bar]\n");
+  std::istringstream modules("foo 8192 0 - Live 0xffffffffc0000000\n"
+                             "bar 4096 0 - Live 0xffffffffc0003000\n");
+  KallsymsIndex index;
+  index.load(kallsyms, modules);
+  EXPECT_EQ(index.size(), 7);
+  EXPECT_EQ(index.shard_count(), 4);
+
+  EXPECT_FALSE(index.lookup(0xffffffff80000000).has_value());
+  // The first symbol at an address wins.
+  EXPECT_EQ(index.lookup(0xffffffff81000000)->name, "_stext");
+  EXPECT_EQ(index.lookup(0xffffffff81001010)->name, "do_one_initcall");
+  EXPECT_EQ(index.lookup(0xffffffff81001010)->start, 0xffffffff81001000);
+  EXPECT_TRUE(index.lookup(0xffffffff81001010)->module.empty());
+  EXPECT_EQ(index.lookup(0xffffffffc0000010)->name, "foo_exit");
+  EXPECT_EQ(index.lookup(0xffffffffc0001010)->module, "foo");
+  // [bpf] is between foo and bar.
+  EXPECT_EQ(index.lookup(0xffffffffc0002010)->name, "bpf_prog_1");
+  EXPECT_EQ(index.lookup(0xffffffffc0003010)->name, "bar_init");
+  // Past the end of bar.
+  EXPECT_FALSE(index.lookup(0xffffffffc0004000).has_value());
+
+  // Nothing changed.
+  std::istringstream same_kallsyms;
+  std::istringstream same_modules("foo 8192 0 - Live 0xffffffffc0000000\n"
+                                  "bar 4096 0 - Live 0xffffffffc0003000\n");
+  EXPECT_FALSE(index.reload(same_kallsyms, same_modules));
+
+  // foo is unloaded and baz is loaded. Only baz and [bpf] are read again.
+  std::istringstream new_kallsyms("ffffffff81000000 T ignored\n"
+                                  "ffffffffc0002000 t bpf_prog_2\t[bpf]\n"
+                                  "ffffffffc0003000 t ignored\t[bar]\n"
+                                  "ffffffffc0004000 t baz_init\t[baz]\n");
+  std::istringstream new_modules("bar 4096 0 - Live 0xffffffffc0003000\n"
+                                 "baz 4096 0 - Live 0xffffffffc0004000\n");
+  EXPECT_TRUE(index.reload(new_kallsyms, new_modules));
+  EXPECT_EQ(index.size(), 6);
+  EXPECT_EQ(index.lookup(0xffffffff81000000)->name, "_stext");
+  EXPECT_EQ(index.lookup(0xffffffffc0000010)->name, "jiffies");
+  EXPECT_EQ(index.lookup(0xffffffffc0002010)->name, "bpf_prog_2");
+  EXPECT_EQ(index.lookup(0xffffffffc0003010)->name, "bar_init");
+  EXPECT_EQ(index.lookup(0xffffffffc0004010)->name, "baz_init");
+}
+
+TEST(utils, topk_sketch)
+{
+  // Two CPUs, each with their own copy of the sketch.
+  constexpr size_t ncounters = TOPK_SKETCH_ROWS * TOPK_SKETCH_COLS;
+  std::vector<uint8_t> values(2 * ncounters * sizeof(uint32_t), 0);
+  auto add = [&](int cpu, uint64_t hash, uint32_t n) {
+    auto *counters = reinterpret_cast<uint32_t *>(values.data()) +
+                     (cpu * ncounters);
+    for (uint32_t row = 0; row < TOPK_SKETCH_ROWS; row++)
+      counters[(row * TOPK_SKETCH_COLS) + topk_sketch_column(hash, row)] += n;
+  };
+
+  const uint64_t a = 0x0123456789abcdef;
+  const uint64_t b = 0xfedcba9876543210;
+  const uint64_t c = 0x0000000100000001;
+  add(0, a, 10);
+  add(1, a, 5);
+  add(1, b, 7);
+
+  auto sketch = topk_merge_sketch(values, 2);
+  ASSERT_EQ(sketch.size(), ncounters);
+  // Estimates never undercount.
+  EXPECT_GE(topk_estimate(sketch, a), 15);
+  EXPECT_GE(topk_estimate(sketch, b), 7);
+  EXPECT_LE(topk_estimate(sketch, a), 15 + topk_error_bound(sketch));
+  EXPECT_LE(topk_estimate(sketch, c), topk_error_bound(sketch));
+  // ceil(e / 1024 * 22)
+  EXPECT_EQ(topk_error_bound(sketch), 1);
+}
+
+TEST(utils, distinct_value)
+{
+  // Two CPUs, each with their own set of registers, updated the same way the
+  // generated code does.
+  std::vector<uint8_t> values(2 * DISTINCT_REGISTERS, 0);
+  auto add = [&](int cpu, uint64_t value) {
+    // splitmix64 finalizer, any well-mixed 64-bit hash will do.
+    uint64_t hash = value + 0x9e3779b97f4a7c15;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+    hash ^= hash >> 31;
+    uint64_t idx = hash >> (64 - DISTINCT_PRECISION);
+    uint64_t bits = hash << DISTINCT_PRECISION;
+    auto rho = static_cast<uint8_t>(
+        bits ? std::min<int>(__builtin_clzll(bits) + 1,
+                             64 - DISTINCT_PRECISION + 1)
+             : 64 - DISTINCT_PRECISION + 1);
+    uint8_t &reg = values[(cpu * DISTINCT_REGISTERS) + idx];
+    reg = std::max(reg, rho);
+  };
+
+  EXPECT_EQ(distinct_value(values, 2), 0);
+
+  // Small cardinalities are exact enough thanks to linear counting.
+  add(0, 1);
+  add(1, 1);
+  add(1, 2);
+  add(0, 3);
+  EXPECT_EQ(distinct_value(values, 2), 3);
+
+  // Values seen on both CPUs are only counted once.
+  for (uint64_t i = 0; i < 100000; i++)
+    add(i % 2, i);
+  for (uint64_t i = 0; i < 100000; i++)
+    add((i + 1) % 2, i);
+  auto estimate = distinct_value(values, 2);
+  // 5 standard errors
+  EXPECT_GT(estimate, 100000 * 0.84);
+  EXPECT_LT(estimate, 100000 * 1.16);
+}
+
+TEST(utils, quantiles_value)
+{
+  // Indexes up to 2^(QUANTILES_BITS + 1) hold exactly one value.
+  EXPECT_EQ(quantiles_bucket_value(0), 0);
+  EXPECT_EQ(quantiles_bucket_value(1), 0);
+  EXPECT_EQ(quantiles_bucket_value(64), 63);
+  // [64, 66) and [992, 1008)
+  EXPECT_EQ(quantiles_bucket_value(65), 64);
+  EXPECT_EQ(quantiles_bucket_value(191), 999);
+
+  std::vector<uint64_t> buckets(65 * 32, 0);
+  EXPECT_EQ(quantiles_value(buckets, 0.5), 0);
+
+  buckets[11] = 9;  // 10
+  buckets[191] = 1; // [992, 1008)
+  EXPECT_EQ(quantiles_value(buckets, 0.5), 10);
+  EXPECT_EQ(quantiles_value(buckets, 0.9), 10);
+  EXPECT_EQ(quantiles_value(buckets, 0.99), 999);
+  EXPECT_EQ(quantiles_value(buckets, 1), 999);
+}
+
 TEST(utils, cat_file_success)
 {
   std::string test_content = "Hello, cat_file test!\nThis is line 2.\n";